@@ -0,0 +1,238 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures the cost of hook_event_proc() for each X11 event type by feeding it
+ * synthetic XRecord intercept data in a tight loop.  Requires a running X
+ * server, such as Xvfb, for the keyboard map and the request counters.
+ *
+ * usage: bench_hook [iterations]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <uiohook.h>
+
+#include <X11/keysym.h>
+
+#include "alloc_counter.h"
+#include "input_helper.h"
+#include "system_properties.h"
+#include "xrecord_fixture.h"
+
+#define BENCH_DEFAULT_ITERATIONS 1000000
+
+typedef struct _bench_result {
+    uint64_t events;
+    uint64_t nanoseconds;
+    uint64_t allocations;
+    uint64_t requests;
+} bench_result;
+
+static uint64_t typed = 0;
+
+static void dispatch_proc(uiohook_event * const event) {
+    if (event->type == EVENT_KEY_TYPED) {
+        typed++;
+    }
+}
+
+static uint64_t get_time_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+static uint64_t get_request_count(Display *display) {
+    uint64_t count = NextRequest(display);
+    if (helper_disp != NULL && helper_disp != display) {
+        count += NextRequest(helper_disp);
+    }
+
+    return count;
+}
+
+static void begin_scenario(Display *display, bench_result *result) {
+    result->requests = get_request_count(display);
+    allocations = 0;
+    counting = true;
+    result->nanoseconds = get_time_ns();
+}
+
+static void end_scenario(Display *display, bench_result *result, uint64_t events) {
+    result->nanoseconds = get_time_ns() - result->nanoseconds;
+    counting = false;
+    result->allocations = allocations;
+    result->requests = get_request_count(display) - result->requests;
+    result->events = events;
+}
+
+// Key press and release pairs for a key that produces a typed character.
+static bool bench_key_typed(Display *display, unsigned long iterations, bench_result *result) {
+    KeyCode keycode = XKeysymToKeycode(display, XK_a);
+    XRecordDatum press, release;
+    set_datum(&press, KeyPress, keycode, 0, 0);
+    set_datum(&release, KeyRelease, keycode, 0, 0);
+
+    typed = 0;
+    begin_scenario(display, result);
+    for (unsigned long i = 0; i < iterations; i++) {
+        send_datum(display, &press, i * 2);
+        send_datum(display, &release, i * 2 + 1);
+    }
+    end_scenario(display, result, iterations * 2);
+
+    // Without a keysym translation the scenario would skip the typed event entirely.
+    if (typed != iterations) {
+        fprintf(stderr, "key scenario typed %llu of %lu characters!\n", (unsigned long long) typed, iterations);
+        return false;
+    }
+
+    return true;
+}
+
+// Pointer motion with no buttons held.
+static bool bench_motion(Display *display, unsigned long iterations, bench_result *result) {
+    XRecordDatum motion;
+
+    begin_scenario(display, result);
+    for (unsigned long i = 0; i < iterations; i++) {
+        set_datum(&motion, MotionNotify, 0, (int16_t) (i % 1024), (int16_t) (i % 768));
+        send_datum(display, &motion, i);
+    }
+    end_scenario(display, result, iterations);
+
+    return true;
+}
+
+// Pointer motion while the first button is held.
+static bool bench_drag(Display *display, unsigned long iterations, bench_result *result) {
+    XRecordDatum button, motion;
+    set_datum(&button, ButtonPress, Button1, 0, 0);
+    send_datum(display, &button, 0);
+
+    begin_scenario(display, result);
+    for (unsigned long i = 0; i < iterations; i++) {
+        set_datum(&motion, MotionNotify, 0, (int16_t) (i % 1024), (int16_t) (i % 768));
+        send_datum(display, &motion, i);
+    }
+    end_scenario(display, result, iterations);
+
+    set_datum(&button, ButtonRelease, Button1, 0, 0);
+    send_datum(display, &button, iterations);
+
+    return true;
+}
+
+// Button press and release pairs that produce click events.
+static bool bench_button(Display *display, unsigned long iterations, bench_result *result) {
+    XRecordDatum press, release;
+    set_datum(&press, ButtonPress, Button1, 100, 100);
+    set_datum(&release, ButtonRelease, Button1, 100, 100);
+
+    begin_scenario(display, result);
+    for (unsigned long i = 0; i < iterations; i++) {
+        send_datum(display, &press, i * 2);
+        send_datum(display, &release, i * 2 + 1);
+    }
+    end_scenario(display, result, iterations * 2);
+
+    return true;
+}
+
+// Vertical wheel notches, reported by X11 as button press and release pairs.
+static bool bench_wheel(Display *display, unsigned long iterations, bench_result *result) {
+    XRecordDatum press, release;
+    set_datum(&press, ButtonPress, WheelDown, 100, 100);
+    set_datum(&release, ButtonRelease, WheelDown, 100, 100);
+
+    begin_scenario(display, result);
+    for (unsigned long i = 0; i < iterations; i++) {
+        send_datum(display, &press, i * 2);
+        send_datum(display, &release, i * 2 + 1);
+    }
+    end_scenario(display, result, iterations * 2);
+
+    return true;
+}
+
+static void print_result(const char *name, bench_result *result) {
+    fprintf(stdout, "%-8s %10llu events %10.1f ns/event %8.3f allocs/event %8.3f requests/event\n",
+            name,
+            (unsigned long long) result->events,
+            (double) result->nanoseconds / result->events,
+            (double) result->allocations / result->events,
+            (double) result->requests / result->events);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long iterations = BENCH_DEFAULT_ITERATIONS;
+    if (argc > 1) {
+        iterations = strtoul(argv[1], NULL, 10);
+        if (iterations == 0) {
+            fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Open helper_disp the same way hook_run() does.
+    load_library();
+
+    // Stands in for the control display opened by hook_run().
+    Display *display = XOpenDisplay(NULL);
+    if (display == NULL || helper_disp == NULL) {
+        fprintf(stderr, "bench_hook requires a running X server!\n");
+        return EXIT_FAILURE;
+    }
+
+    // Create the keyboard state hook_run() would create for the control display.
+    load_input_state(display);
+
+    hook_set_dispatch_proc(&dispatch_proc);
+    send_category(display, XRecordStartOfData);
+
+    struct {
+        const char *name;
+        bool (*proc)(Display *, unsigned long, bench_result *);
+    } scenarios[] = {
+        { "key",    &bench_key_typed },
+        { "motion", &bench_motion },
+        { "drag",   &bench_drag },
+        { "button", &bench_button },
+        { "wheel",  &bench_wheel }
+    };
+
+    int status = EXIT_SUCCESS;
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        bench_result result;
+        if (!scenarios[i].proc(display, iterations, &result)) {
+            status = EXIT_FAILURE;
+        }
+        print_result(scenarios[i].name, &result);
+    }
+
+    send_category(display, XRecordEndOfData);
+    unload_input_state();
+    XCloseDisplay(display);
+
+    return status;
+}
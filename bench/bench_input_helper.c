@@ -0,0 +1,229 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures the X11 input helper conversions across their full input domains.
+ * The helper source is included directly so the scancode table can be forced
+ * to evdev or xfree86 regardless of the running server.  The xkbcommon mode is
+ * fixed at build time by USE_XKB_COMMON.  Each result is printed as a single
+ * line JSON object.
+ *
+ * usage: bench_input_helper [rounds]
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "input_helper.c"
+
+#define BENCH_DEFAULT_ROUNDS 100
+
+#ifdef USE_XKB_COMMON
+#define BENCH_XKB_MODE "xkbcommon"
+#else
+#define BENCH_XKB_MODE "xkb"
+#endif
+
+// Keep the results observable so the conversions are not optimized away.
+static volatile uint64_t sink;
+
+static uint64_t get_time_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+static void print_result(const char *name, const char *table, uint64_t calls, uint64_t elapsed) {
+    fprintf(stdout, "{\"bench\":\"%s\",\"table\":\"%s\",\"xkb\":\"%s\",\"display\":%s,"
+            "\"calls\":%llu,\"ns\":%llu,\"ns_per_call\":%.2f}\n",
+            name, table, BENCH_XKB_MODE, helper_disp != NULL ? "true" : "false",
+            (unsigned long long) calls, (unsigned long long) elapsed,
+            calls > 0 ? (double) elapsed / calls : 0.0);
+}
+
+// Every X11 key code.
+static void bench_keycode_to_scancode(const char *table, unsigned int rounds) {
+    uint64_t acc = 0, calls = 0;
+
+    uint64_t start = get_time_ns();
+    for (unsigned int r = 0; r < rounds; r++) {
+        for (unsigned int keycode = 0; keycode <= 0xFF; keycode++) {
+            acc += keycode_to_scancode((KeyCode) keycode);
+            calls++;
+        }
+    }
+    print_result("keycode_to_scancode", table, calls, get_time_ns() - start);
+    sink += acc;
+}
+
+// Every 16-bit virtual scan code, including the extended 0x0E00 range.
+static void bench_scancode_to_keycode(const char *table, unsigned int rounds) {
+    uint64_t acc = 0, calls = 0;
+
+    uint64_t start = get_time_ns();
+    for (unsigned int r = 0; r < rounds; r++) {
+        for (unsigned int scancode = 0; scancode <= 0xFFFF; scancode++) {
+            acc += scancode_to_keycode((uint16_t) scancode);
+            calls++;
+        }
+    }
+    print_result("scancode_to_keycode", table, calls, get_time_ns() - start);
+    sink += acc;
+}
+
+// The legacy key symbol range followed by the directly encoded Unicode range.
+static void bench_keysym_to_unicode(unsigned int rounds) {
+    uint64_t acc = 0, calls = 0;
+    uint16_t buffer[2];
+
+    uint64_t start = get_time_ns();
+    for (unsigned int r = 0; r < rounds; r++) {
+        for (KeySym keysym = 0x0000; keysym <= 0xFFFF; keysym++) {
+            acc += keysym_to_unicode(keysym, buffer, sizeof(buffer) / sizeof(uint16_t));
+            calls++;
+        }
+
+        for (KeySym keysym = 0x1000000; keysym <= 0x100FFFF; keysym++) {
+            acc += keysym_to_unicode(keysym, buffer, sizeof(buffer) / sizeof(uint16_t));
+            calls++;
+        }
+    }
+    print_result("keysym_to_unicode", "none", calls, get_time_ns() - start);
+    sink += acc;
+}
+
+// Every UTF-16 code unit.
+static void bench_unicode_to_keysym(unsigned int rounds) {
+    uint64_t acc = 0, calls = 0;
+
+    uint64_t start = get_time_ns();
+    for (unsigned int r = 0; r < rounds; r++) {
+        for (unsigned int unicode = 0; unicode <= 0xFFFF; unicode++) {
+            acc += unicode_to_keysym((uint16_t) unicode);
+            calls++;
+        }
+    }
+    print_result("unicode_to_keysym", "none", calls, get_time_ns() - start);
+    sink += acc;
+}
+
+#ifdef USE_XKB_COMMON
+// Every X11 key code against the current keyboard state.
+static void bench_keycode_to_unicode(struct xkb_state *state, unsigned int rounds) {
+    uint64_t acc = 0, calls = 0;
+    uint16_t buffer[2];
+
+    uint64_t start = get_time_ns();
+    for (unsigned int r = 0; r < rounds; r++) {
+        for (unsigned int keycode = 0; keycode <= 0xFF; keycode++) {
+            acc += keycode_to_unicode(state, (KeyCode) keycode, buffer, sizeof(buffer) / sizeof(uint16_t));
+            calls++;
+        }
+    }
+    print_result("keycode_to_unicode", "none", calls, get_time_ns() - start);
+    sink += acc;
+}
+#else
+// Every X11 key code under the common shift, caps lock and num lock states.
+static void bench_keycode_to_keysym(unsigned int rounds) {
+    static const unsigned int masks[] = { 0, ShiftMask, LockMask, Mod2Mask, ShiftMask | Mod2Mask };
+    uint64_t acc = 0, calls = 0;
+
+    uint64_t start = get_time_ns();
+    for (unsigned int r = 0; r < rounds; r++) {
+        for (size_t m = 0; m < sizeof(masks) / sizeof(masks[0]); m++) {
+            for (unsigned int keycode = 0; keycode <= 0xFF; keycode++) {
+                acc += keycode_to_keysym((KeyCode) keycode, masks[m]);
+                calls++;
+            }
+        }
+    }
+    print_result("keycode_to_keysym", "none", calls, get_time_ns() - start);
+    sink += acc;
+}
+#endif
+
+static void bench_tables(const char *table, unsigned int rounds) {
+    bench_keycode_to_scancode(table, rounds);
+    bench_scancode_to_keycode(table, rounds);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned int rounds = BENCH_DEFAULT_ROUNDS;
+    if (argc > 1) {
+        rounds = (unsigned int) strtoul(argv[1], NULL, 10);
+        if (rounds == 0) {
+            fprintf(stderr, "usage: %s [rounds]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // The keyboard map is optional, without it the layout dependent lookups measure the fallback path.
+    helper_disp = XOpenDisplay(NULL);
+    if (helper_disp != NULL) {
+        load_input_helper();
+    }
+
+    #ifdef USE_EVDEV
+    is_evdev = true;
+    bench_tables("evdev", rounds);
+    is_evdev = false;
+    #endif
+    bench_tables("xfree86", rounds);
+
+    bench_keysym_to_unicode(rounds);
+    bench_unicode_to_keysym(rounds);
+
+    #ifdef USE_XKB_COMMON
+    struct xkb_context *context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+    struct xkb_state *state = NULL;
+    if (context != NULL) {
+        if (helper_disp != NULL) {
+            state = create_xkb_state(context, XGetXCBConnection(helper_disp));
+        } else {
+            // Compile the default keymap, which does not require a display.
+            struct xkb_keymap *keymap = xkb_keymap_new_from_names(context, NULL, XKB_KEYMAP_COMPILE_NO_FLAGS);
+            if (keymap != NULL) {
+                state = xkb_state_new(keymap);
+                xkb_keymap_unref(keymap);
+            }
+        }
+    }
+
+    if (state != NULL) {
+        bench_keycode_to_unicode(state, rounds);
+        destroy_xkb_state(state);
+    } else {
+        fprintf(stderr, "Failed to create a xkb_state, skipping keycode_to_unicode!\n");
+    }
+
+    if (context != NULL) {
+        xkb_context_unref(context);
+    }
+    #else
+    bench_keycode_to_keysym(rounds);
+    #endif
+
+    if (helper_disp != NULL) {
+        unload_input_helper();
+        XCloseDisplay(helper_disp);
+        helper_disp = NULL;
+    }
+
+    return EXIT_SUCCESS;
+}
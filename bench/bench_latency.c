@@ -0,0 +1,297 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures the delay between hook_post_event() and the arrival of the matching
+ * event at the dispatcher while hook_run() is recording a live display.  This
+ * is meant to be run on a dedicated Xvfb server, see the run_bench_latency
+ * target, because the injected events are delivered to the focused window.
+ *
+ * usage: bench_latency [samples]
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <uiohook.h>
+
+#define BENCH_DEFAULT_SAMPLES 10000
+
+// Time to wait for a single event before it is counted as lost.
+#define BENCH_EVENT_TIMEOUT 1000000000
+
+#ifdef USE_XRECORD_ASYNC
+#define BENCH_MODE "async"
+#else
+#define BENCH_MODE "sync"
+#endif
+
+typedef struct _bench_expect {
+    event_type type;
+    uint16_t keycode;
+    uint16_t button;
+    int16_t x;
+    int16_t y;
+} bench_expect;
+
+static pthread_mutex_t bench_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bench_cond = PTHREAD_COND_INITIALIZER;
+
+static bool enabled = false;
+static bool finished = false;
+static bench_expect expect;
+static uint64_t received_count = 0;
+static uint64_t received_time = 0;
+
+static uint64_t get_time_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+static bool is_expected(uiohook_event * const event) {
+    if (event->type != expect.type) {
+        return false;
+    }
+
+    switch (event->type) {
+        case EVENT_KEY_PRESSED:
+        case EVENT_KEY_RELEASED:
+            return event->data.keyboard.keycode == expect.keycode;
+
+        case EVENT_MOUSE_PRESSED:
+        case EVENT_MOUSE_RELEASED:
+            return event->data.mouse.button == expect.button;
+
+        case EVENT_MOUSE_MOVED:
+            return event->data.mouse.x == expect.x && event->data.mouse.y == expect.y;
+
+        default:
+            return true;
+    }
+}
+
+static void dispatch_proc(uiohook_event * const event) {
+    uint64_t now = get_time_ns();
+
+    pthread_mutex_lock(&bench_mutex);
+    if (event->type == EVENT_HOOK_ENABLED) {
+        enabled = true;
+        pthread_cond_broadcast(&bench_cond);
+    } else if (is_expected(event)) {
+        received_count++;
+        received_time = now;
+        pthread_cond_broadcast(&bench_cond);
+    }
+    pthread_mutex_unlock(&bench_mutex);
+}
+
+static void * hook_thread_proc(void *arg) {
+    *(int *) arg = hook_run();
+
+    // Release the main thread if the hook failed to start.
+    pthread_mutex_lock(&bench_mutex);
+    finished = true;
+    pthread_cond_broadcast(&bench_cond);
+    pthread_mutex_unlock(&bench_mutex);
+
+    return arg;
+}
+
+static void get_deadline(struct timespec *ts, uint64_t timeout) {
+    clock_gettime(CLOCK_REALTIME, ts);
+    uint64_t nsec = (uint64_t) ts->tv_nsec + timeout;
+    ts->tv_sec += nsec / 1000000000;
+    ts->tv_nsec = nsec % 1000000000;
+}
+
+// Wait for the received count to reach the target, returns false on timeout.
+static bool wait_received(uint64_t target, uint64_t timeout) {
+    struct timespec ts;
+    get_deadline(&ts, timeout);
+
+    int status = 0;
+    while (received_count < target && status != ETIMEDOUT) {
+        status = pthread_cond_timedwait(&bench_cond, &bench_mutex, &ts);
+    }
+
+    return received_count >= target;
+}
+
+/* Fill the event to post and the expected dispatch for the nth sample of a
+ * scenario.  Each scenario alternates between two states so that every sample
+ * produces exactly one matching event.
+ */
+static void prepare_sample(const char *name, uint64_t n, uiohook_event *event, bench_expect *match) {
+    memset(event, 0, sizeof(uiohook_event));
+    memset(match, 0, sizeof(bench_expect));
+
+    if (strcmp(name, "key") == 0) {
+        event->type = n % 2 == 0 ? EVENT_KEY_PRESSED : EVENT_KEY_RELEASED;
+        event->data.keyboard.keycode = VC_A;
+
+        match->type = event->type;
+        match->keycode = VC_A;
+    } else if (strcmp(name, "motion") == 0) {
+        event->type = EVENT_MOUSE_MOVED;
+        event->data.mouse.x = n % 2 == 0 ? 100 : 200;
+        event->data.mouse.y = n % 2 == 0 ? 100 : 200;
+
+        match->type = EVENT_MOUSE_MOVED;
+        match->x = event->data.mouse.x;
+        match->y = event->data.mouse.y;
+    } else {
+        event->type = n % 2 == 0 ? EVENT_MOUSE_PRESSED : EVENT_MOUSE_RELEASED;
+        event->data.mouse.button = MOUSE_BUTTON1;
+
+        match->type = event->type;
+        match->button = MOUSE_BUTTON1;
+    }
+}
+
+static int compare_uint64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+// Percentile given in tenths of a percent, 999 for p99.9.
+static double percentile_us(uint64_t *sorted, size_t count, unsigned int per_mille) {
+    if (count == 0) {
+        return 0.0;
+    }
+
+    return sorted[(count - 1) * per_mille / 1000] / 1000.0;
+}
+
+static void bench_scenario(const char *name, uint64_t samples, uint64_t *latency) {
+    uiohook_event event;
+    size_t count = 0;
+    uint64_t lost = 0;
+
+    // Round trip each sample so the latency excludes queueing behind earlier events.
+    for (uint64_t i = 0; i < samples; i++) {
+        pthread_mutex_lock(&bench_mutex);
+        prepare_sample(name, i, &event, &expect);
+        uint64_t target = received_count + 1;
+        pthread_mutex_unlock(&bench_mutex);
+
+        uint64_t start = get_time_ns();
+        hook_post_event(&event);
+
+        pthread_mutex_lock(&bench_mutex);
+        if (wait_received(target, BENCH_EVENT_TIMEOUT)) {
+            latency[count++] = received_time - start;
+        } else {
+            lost++;
+            received_count = target;
+        }
+        pthread_mutex_unlock(&bench_mutex);
+    }
+
+    /* The sustained rate is measured by posting every sample back to back and
+     * waiting for the last one to arrive.  Only the even samples match, the odd
+     * ones restore the starting state.
+     */
+    pthread_mutex_lock(&bench_mutex);
+    uint64_t first = received_count;
+    prepare_sample(name, 0, &event, &expect);
+    pthread_mutex_unlock(&bench_mutex);
+
+    uint64_t start = get_time_ns();
+    uint64_t posted = 0;
+    for (uint64_t i = 0; i < samples; i++) {
+        uiohook_event burst;
+        bench_expect unused;
+        prepare_sample(name, i, &burst, &unused);
+        hook_post_event(&burst);
+
+        if (i % 2 == 0) {
+            posted++;
+        }
+    }
+
+    pthread_mutex_lock(&bench_mutex);
+    wait_received(first + posted, BENCH_EVENT_TIMEOUT);
+    uint64_t delivered = received_count - first;
+    uint64_t elapsed = (delivered > 0 ? received_time : get_time_ns()) - start;
+    pthread_mutex_unlock(&bench_mutex);
+
+    qsort(latency, count, sizeof(uint64_t), compare_uint64);
+
+    fprintf(stdout, "mode=%s type=%s samples=%zu lost=%llu p50_us=%.1f p99_us=%.1f p999_us=%.1f max_rate_hz=%.0f\n",
+            BENCH_MODE, name, count, (unsigned long long) lost,
+            percentile_us(latency, count, 500),
+            percentile_us(latency, count, 990),
+            percentile_us(latency, count, 999),
+            elapsed > 0 ? delivered * 2 * 1000000000.0 / elapsed : 0.0);
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t samples = BENCH_DEFAULT_SAMPLES;
+    if (argc > 1) {
+        samples = strtoull(argv[1], NULL, 10);
+        if (samples == 0) {
+            fprintf(stderr, "usage: %s [samples]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    uint64_t *latency = malloc(sizeof(uint64_t) * samples);
+    if (latency == NULL) {
+        fprintf(stderr, "Failed to allocate memory for %llu samples!\n", (unsigned long long) samples);
+        return EXIT_FAILURE;
+    }
+
+    hook_set_dispatch_proc(&dispatch_proc);
+
+    int hook_status = UIOHOOK_FAILURE;
+    pthread_t hook_thread;
+    pthread_mutex_lock(&bench_mutex);
+    if (pthread_create(&hook_thread, NULL, hook_thread_proc, &hook_status) != 0) {
+        pthread_mutex_unlock(&bench_mutex);
+        fprintf(stderr, "Failed to create the hook thread!\n");
+        free(latency);
+        return EXIT_FAILURE;
+    }
+
+    struct timespec ts;
+    get_deadline(&ts, 5 * (uint64_t) BENCH_EVENT_TIMEOUT);
+    while (!enabled && !finished && pthread_cond_timedwait(&bench_cond, &bench_mutex, &ts) != ETIMEDOUT);
+    bool started = enabled;
+    pthread_mutex_unlock(&bench_mutex);
+
+    if (started) {
+        bench_scenario("key", samples, latency);
+        bench_scenario("motion", samples, latency);
+        bench_scenario("button", samples, latency);
+
+        hook_stop();
+    } else {
+        fprintf(stderr, "hook_run() did not start, is an X server with XRecord running?\n");
+    }
+
+    pthread_join(hook_thread, NULL);
+    free(latency);
+
+    return started && hook_status == UIOHOOK_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
+}
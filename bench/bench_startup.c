@@ -0,0 +1,163 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures the time from calling hook_run() until EVENT_HOOK_ENABLED reaches
+ * the dispatcher, restarting the hook for every sample.
+ *
+ * usage: bench_startup [samples]
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <uiohook.h>
+
+#define BENCH_DEFAULT_SAMPLES 100
+
+// Time to wait for the hook to start before giving up.
+#define BENCH_START_TIMEOUT 5000000000ULL
+
+static pthread_mutex_t bench_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bench_cond = PTHREAD_COND_INITIALIZER;
+
+static bool enabled = false;
+static bool finished = false;
+static uint64_t start_time = 0;
+static uint64_t enabled_time = 0;
+
+static uint64_t get_time_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+static void dispatch_proc(uiohook_event * const event) {
+    if (event->type == EVENT_HOOK_ENABLED) {
+        uint64_t now = get_time_ns();
+
+        pthread_mutex_lock(&bench_mutex);
+        enabled = true;
+        enabled_time = now;
+        pthread_cond_broadcast(&bench_cond);
+        pthread_mutex_unlock(&bench_mutex);
+    }
+}
+
+static void * hook_thread_proc(void *arg) {
+    pthread_mutex_lock(&bench_mutex);
+    start_time = get_time_ns();
+    pthread_mutex_unlock(&bench_mutex);
+
+    *(int *) arg = hook_run();
+
+    pthread_mutex_lock(&bench_mutex);
+    finished = true;
+    pthread_cond_broadcast(&bench_cond);
+    pthread_mutex_unlock(&bench_mutex);
+
+    return arg;
+}
+
+static int compare_uint64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+// Start and stop the hook once, returns false if it did not start.
+static bool run_sample(uint64_t *elapsed) {
+    int hook_status = UIOHOOK_FAILURE;
+    pthread_t hook_thread;
+
+    pthread_mutex_lock(&bench_mutex);
+    enabled = false;
+    finished = false;
+    pthread_mutex_unlock(&bench_mutex);
+
+    if (pthread_create(&hook_thread, NULL, hook_thread_proc, &hook_status) != 0) {
+        fprintf(stderr, "Failed to create the hook thread!\n");
+        return false;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t nsec = (uint64_t) ts.tv_nsec + BENCH_START_TIMEOUT;
+    ts.tv_sec += nsec / 1000000000;
+    ts.tv_nsec = nsec % 1000000000;
+
+    pthread_mutex_lock(&bench_mutex);
+    while (!enabled && !finished && pthread_cond_timedwait(&bench_cond, &bench_mutex, &ts) != ETIMEDOUT);
+    bool started = enabled;
+    *elapsed = enabled_time - start_time;
+    pthread_mutex_unlock(&bench_mutex);
+
+    if (started) {
+        hook_stop();
+    }
+    pthread_join(hook_thread, NULL);
+
+    return started && hook_status == UIOHOOK_SUCCESS;
+}
+
+int main(int argc, char *argv[]) {
+    size_t samples = BENCH_DEFAULT_SAMPLES;
+    if (argc > 1) {
+        samples = strtoul(argv[1], NULL, 10);
+        if (samples == 0) {
+            fprintf(stderr, "usage: %s [samples]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    uint64_t *startup = malloc(sizeof(uint64_t) * samples);
+    if (startup == NULL) {
+        fprintf(stderr, "Failed to allocate memory for %zu samples!\n", samples);
+        return EXIT_FAILURE;
+    }
+
+    hook_set_dispatch_proc(&dispatch_proc);
+
+    size_t count = 0;
+    while (count < samples && run_sample(&startup[count])) {
+        count++;
+    }
+
+    int status = EXIT_FAILURE;
+    if (count == samples) {
+        qsort(startup, count, sizeof(uint64_t), compare_uint64);
+
+        fprintf(stdout, "samples=%zu min_us=%.1f p50_us=%.1f p99_us=%.1f max_us=%.1f\n",
+                count,
+                startup[0] / 1000.0,
+                startup[(count - 1) * 500 / 1000] / 1000.0,
+                startup[(count - 1) * 990 / 1000] / 1000.0,
+                startup[count - 1] / 1000.0);
+
+        status = EXIT_SUCCESS;
+    } else {
+        fprintf(stderr, "hook_run() failed after %zu samples, is an X server with XRecord running?\n", count);
+    }
+
+    free(startup);
+
+    return status;
+}
@@ -59,8 +59,8 @@ bool logger_proc(unsigned int level, const char *format, ...) {
 void dispatch_proc(uiohook_event * const event) {
     char buffer[256] = { 0 };
     size_t length = snprintf(buffer, sizeof(buffer), 
-            "id=%i,when=%" PRIu64 ",mask=0x%X", 
-            event->type, event->time, event->mask);
+            "id=%i,when=%" PRIu64 ",mask=0x%X,device=%u", 
+            event->type, event->time, event->mask, event->device);
     
     switch (event->type) {
         case EVENT_KEY_PRESSED:
@@ -120,6 +120,17 @@ void dispatch_proc(uiohook_event * const event) {
                 event->data.wheel.rotation);
             break;
 
+        case EVENT_SCREEN_CHANGED:
+            {
+                screen_data screens[8];
+                unsigned char count = sizeof(screens) / sizeof(screens[0]);
+                if (hook_get_screen_info(screens, &count) == UIOHOOK_SUCCESS) {
+                    snprintf(buffer + length, sizeof(buffer) - length,
+                        ",screens=%u", count);
+                }
+            }
+            break;
+
         default:
             break;
     }
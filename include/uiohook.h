@@ -21,6 +21,7 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* Begin Error Codes */
@@ -74,7 +75,8 @@ typedef enum _event_type {
     EVENT_MOUSE_RELEASED,
     EVENT_MOUSE_MOVED,
     EVENT_MOUSE_DRAGGED,
-    EVENT_MOUSE_WHEEL
+    EVENT_MOUSE_WHEEL,
+    EVENT_SCREEN_CHANGED        // The monitor layout changed, see hook_get_screen_info().
 } event_type;
 
 typedef struct _screen_data {
@@ -99,6 +101,9 @@ typedef struct _mouse_event_data {
     uint16_t clicks;
     int16_t x;
     int16_t y;
+    uint8_t screen;             // Index into hook_get_screen_info(), SCREEN_UNDEFINED if outside every screen or unsupported.
+    int16_t screen_x;           // Position relative to the screen.
+    int16_t screen_y;
 } mouse_event_data,
   mouse_pressed_event_data,
   mouse_released_event_data,
@@ -112,6 +117,9 @@ typedef struct _mouse_wheel_event_data {
     uint16_t amount;
     int16_t rotation;
     uint8_t direction;
+    uint8_t screen;             // Index into hook_get_screen_info(), SCREEN_UNDEFINED if outside every screen or unsupported.
+    int16_t screen_x;           // Position relative to the screen.
+    int16_t screen_y;
 } mouse_wheel_event_data;
 
 typedef struct _uiohook_event {
@@ -124,11 +132,174 @@ typedef struct _uiohook_event {
         mouse_event_data mouse;
         mouse_wheel_event_data wheel;
     } data;
+    uint8_t device;             // Source device from hook_get_devices(), DEVICE_UNDEFINED if unknown or unsupported, best-effort on X11.
+    uint8_t device_class;       // device_class of the source device.
 } uiohook_event;
 
 typedef void (*dispatcher_t)(uiohook_event *const);
 /* End Virtual Event Types and Data Structures */
 
+/* Begin Motion Path Types and Data Structures */
+typedef enum _motion_path_type {
+    MOTION_PATH_LINE = 1,       // Straight line between exactly two points.
+    MOTION_PATH_BEZIER,         // Bezier curve using the points as control points.
+    MOTION_PATH_POINTS          // Polyline through the points, each segment taking equal time.
+} motion_path_type;
+
+typedef struct _motion_point {
+    int16_t x;
+    int16_t y;
+} motion_point;
+
+typedef struct _motion_path {
+    motion_path_type type;
+    const motion_point *points;
+    size_t count;
+    uint32_t duration;          // Total time in milliseconds.
+    uint32_t rate;              // Motion events per second.
+} motion_path;
+/* End Motion Path Types and Data Structures */
+
+/* Begin Replay Data Structures */
+typedef struct _replay_stats {
+    size_t count;               // Number of events posted.
+    int64_t min;                // Schedule error in nanoseconds, positive when late.
+    int64_t mean;
+    int64_t p50;
+    int64_t p90;
+    int64_t p99;
+    int64_t max;
+} replay_stats;
+/* End Replay Data Structures */
+
+/* Begin Recorder Types and Data Structures */
+typedef enum _recorder_sync_policy {
+    RECORDER_SYNC_NONE = 0,     // Leave writing back to the operating system.
+    RECORDER_SYNC_INTERVAL,     // fsync() once the sync interval has elapsed.
+    RECORDER_SYNC_ALWAYS        // fsync() after every write.
+} recorder_sync_policy;
+
+typedef struct _recorder_options {
+    size_t buffer_size;         // Ring buffer capacity in events, rounded up to a power of two.
+    recorder_sync_policy sync;
+    uint32_t sync_interval;     // Milliseconds between fsync() calls for RECORDER_SYNC_INTERVAL.
+} recorder_options;
+
+typedef struct _recorder_stats {
+    uint64_t recorded;          // Events copied into the ring buffer.
+    uint64_t dropped;           // Events lost because the ring buffer was full.
+    uint64_t written;           // Bytes of event records written.
+    uint64_t overhead;          // Sampled mean nanoseconds spent per event on the hook thread.
+} recorder_stats;
+/* End Recorder Types and Data Structures */
+
+/* Begin Dispatch Watchdog Data Structures */
+typedef struct _dispatch_budget {
+    uint32_t budget;            // Microseconds a dispatch procedure call may take, 0 disables the watchdog.
+    bool offload;               // Dispatch from a worker thread while the dispatch procedure is over budget.
+    uint16_t offload_after;     // Consecutive calls over budget before offloading, 0 for 3.
+    uint16_t recover_after;     // Consecutive calls within budget before dispatching inline again, 0 for 100.
+    size_t queue_size;          // Events queued for the worker thread, rounded up to a power of two, 0 for 1024.
+} dispatch_budget;
+
+typedef struct _dispatch_stats {
+    uint64_t calls;             // Timed dispatch procedure calls.
+    uint64_t slow;              // Calls over budget.
+    uint64_t max;               // Longest call in microseconds.
+    uint64_t offloaded;         // Events queued for the worker thread.
+    uint64_t dropped;           // Events lost because the queue was full.
+    bool queued;                // True while events are dispatched from the worker thread.
+} dispatch_stats;
+/* End Dispatch Watchdog Data Structures */
+
+/* Begin Trace Data Structures */
+typedef struct _trace_options {
+    size_t buffer_size;         // Spans kept per thread, rounded up to a power of two.
+} trace_options;
+
+typedef struct _trace_stats {
+    uint64_t recorded;          // Spans recorded since hook_trace_start().
+    uint64_t dropped;           // Spans overwritten before they were dumped.
+    uint64_t written;           // Spans written to the trace file.
+} trace_stats;
+/* End Trace Data Structures */
+
+/* Begin Event Codec Data Structures */
+// Largest number of bytes hook_codec_encode() writes for a single event.
+#define EVENT_CODEC_MAX_SIZE 50
+
+// Delta state shared by consecutive events, encoder and decoder must start from the same state.
+typedef struct _event_codec {
+    uint64_t time;
+    uint16_t mask;
+    int16_t x;
+    int16_t y;
+    uint16_t button;
+    uint16_t clicks;
+    uint16_t keycode;
+    uint16_t rawcode;
+    int16_t screen_x;           // Origin of the last screen, the position minus the relative position.
+    int16_t screen_y;
+    uint8_t device;
+    uint8_t device_class;
+} event_codec;
+/* End Event Codec Data Structures */
+
+/* Begin Virtual Backend Data Structures */
+// Native input for the virtual backend, type, code and value follow <linux/input-event-codes.h>.
+typedef struct _virtual_event {
+    uint16_t type;
+    uint16_t code;
+    int32_t value;
+} virtual_event;
+
+// Virtual event type outside the evdev range that attributes the following events to the device id in code.
+#define VIRTUAL_EVENT_DEVICE 0x20
+/* End Virtual Backend Data Structures */
+
+/* Begin System Properties Data Structures */
+// Snapshot of the values returned by the hook_get_* property functions, -1 if unavailable.
+typedef struct _system_properties {
+    long int auto_repeat_rate;
+    long int auto_repeat_delay;
+    long int pointer_acceleration_multiplier;
+    long int pointer_acceleration_threshold;
+    long int pointer_sensitivity;
+    long int multi_click_time;
+} system_properties;
+/* End System Properties Data Structures */
+
+/* Begin Input Snapshot Data Structures */
+// Input state tracked by the running hook, see hook_get_input_snapshot().
+typedef struct _input_snapshot {
+    uint64_t time;              // Time of the last event that changed the state.
+    uint8_t keys[32];           // Held native key codes, bit (code % 8) of keys[code / 8].
+    uint16_t mask;              // Modifier, button and lock masks.
+    int16_t x;                  // Last pointer position.
+    int16_t y;
+} input_snapshot;
+/* End Input Snapshot Data Structures */
+
+/* Begin Input Device Types and Data Structures */
+#define DEVICE_UNDEFINED            0x00
+#define DEVICE_NAME_SIZE            64
+
+typedef enum _device_class {
+    DEVICE_CLASS_UNKNOWN = 0,
+    DEVICE_CLASS_KEYBOARD,
+    DEVICE_CLASS_MOUSE,
+    DEVICE_CLASS_TOUCHPAD,
+    DEVICE_CLASS_TABLET,
+    DEVICE_CLASS_TOUCHSCREEN
+} device_class;
+
+typedef struct _device_info {
+    uint8_t id;                 // Value of uiohook_event.device for events from this device.
+    uint8_t device_class;
+    char name[DEVICE_NAME_SIZE];
+} device_info;
+/* End Input Device Types and Data Structures */
+
 
 /* Begin Virtual Key Codes */
 #define VC_ESCAPE                                0x0001
@@ -401,6 +572,8 @@ typedef void (*dispatcher_t)(uiohook_event *const);
 
 #define WHEEL_VERTICAL_DIRECTION                 3
 #define WHEEL_HORIZONTAL_DIRECTION               4
+
+#define SCREEN_UNDEFINED                         0xFF    // Outside Every Screen
 /* End Virtual Mouse Buttons */
 
 
@@ -420,18 +593,133 @@ extern "C" {
     // Send a virtual event back to the system.
     UIOHOOK_API void hook_post_event(uiohook_event * const event);
 
-    // Set the event callback function.
+    // Send a UTF-8 encoded string back to the system as a single batch of key events.
+    UIOHOOK_API int hook_post_text(const char *utf8, size_t length);
+
+    // Move the pointer along a path, posting motion events at a fixed rate until the path completes.
+    // Currently only available on X11, other platforms return UIOHOOK_FAILURE.
+    UIOHOOK_API int hook_post_motion_path(const motion_path *path);
+
+    // Replay events at their recorded times scaled by the speed multiplier, optionally reporting the schedule error.
+    // Currently only available on X11, other platforms return UIOHOOK_FAILURE.
+    UIOHOOK_API int hook_replay_events(const uiohook_event *events, size_t count, double speed, replay_stats *stats);
+
+    // Start recording every hooked event to a binary file, options may be NULL for the defaults.
+    // Currently only available on X11 when built with USE_RECORDER, otherwise UIOHOOK_FAILURE is returned.
+    UIOHOOK_API int hook_recorder_start(const char *path, const recorder_options *options);
+
+    // Stop recording and wait for the remaining events to be written, stats may be NULL.
+    // Currently only available on X11 when built with USE_RECORDER, otherwise UIOHOOK_FAILURE is returned.
+    UIOHOOK_API int hook_recorder_stop(recorder_stats *stats);
+
+    // Start recording receipt, translation, dispatch and post spans into a ring buffer per thread.
+    // Currently only available on X11 and the virtual backend when built with USE_TRACE, otherwise UIOHOOK_FAILURE is returned.
+    UIOHOOK_API int hook_trace_start(const trace_options *options);
+
+    // Stop recording spans, the recorded spans are kept until the next hook_trace_start().
+    // Currently only available on X11 and the virtual backend when built with USE_TRACE, otherwise UIOHOOK_FAILURE is returned.
+    UIOHOOK_API int hook_trace_stop();
+
+    // Write the spans of the current or last session as Chrome trace event JSON, stats may be NULL.
+    // Currently only available on X11 and the virtual backend when built with USE_TRACE, otherwise UIOHOOK_FAILURE is returned.
+    UIOHOOK_API int hook_trace_dump(const char *path, trace_stats *stats);
+
+    // Reset the event codec state before encoding or decoding a new stream.
+    UIOHOOK_API void hook_codec_reset(event_codec *codec);
+
+    // Encode a single event as zig-zag varint deltas, buffer must hold EVENT_CODEC_MAX_SIZE bytes.
+    UIOHOOK_API size_t hook_codec_encode(event_codec *codec, const uiohook_event *event, uint8_t *buffer);
+
+    // Decode a single event, returning the number of bytes consumed or 0 if the buffer is truncated or invalid.
+    // The codec state is only advanced by a complete event, so a truncated event may be retried with more bytes.
+    UIOHOOK_API size_t hook_codec_decode(event_codec *codec, const uint8_t *buffer, size_t size, uiohook_event *event);
+
+    // Set the event callback function.  On X11 and the virtual backend the library does not allocate
+    // memory per dispatched event once the hook is running, except for XInput2 events with USE_XINPUT2.
     UIOHOOK_API void hook_set_dispatch_proc(dispatcher_t dispatch_proc);
 
+    /* Time every dispatch procedure call and warn when one takes longer than
+     * the budget, NULL disables the watchdog.  With offload, events are copied
+     * to a worker thread while the dispatch procedure stays over budget, so it
+     * may be called from that thread and events are dropped if the queue
+     * fills.  Queued events are copies, so setting reserved has no effect on
+     * them: EVENT_KEY_TYPED still follows every queued key press and
+     * EVENT_MOUSE_CLICKED every queued button release.  EVENT_HOOK_DISABLED is
+     * always dispatched on the hook thread after the queue is drained.  Must
+     * not be called while the hook is running.
+     * Currently only available on X11 and the virtual backend.
+     */
+    UIOHOOK_API int hook_set_dispatch_budget(const dispatch_budget *budget);
+
+    // Copy the dispatch watchdog statistics since the last hook_set_dispatch_budget().  Safe to call from any thread.
+    // Currently only available on X11 and the virtual backend.
+    UIOHOOK_API int hook_get_dispatch_stats(dispatch_stats *stats);
+
+    /* Copies the held keys, the modifier and button masks and the pointer
+     * position last seen by the hook.  Safe to call from any thread, this
+     * never waits for the hook or the display server.
+     * Currently only available on X11 and the virtual backend.
+     */
+    UIOHOOK_API int hook_get_input_snapshot(input_snapshot *snapshot);
+
+    /* Copies up to count known input devices into the devices buffer and sets
+     * count to the number of devices, which may be larger than the buffer.
+     * The list is only populated on X11 when built with USE_XINPUT2.
+     * Attribution of events to devices is best-effort on X11, an event is
+     * reported with DEVICE_UNDEFINED if its XInput2 raw event does not arrive
+     * shortly after the recorded event, or has not arrived yet for key
+     * releases, auto-repeat and motion, and events from devices that share a
+     * timestamp may be attributed to either device.
+     * Currently only available on X11 and the virtual backend.
+     */
+    UIOHOOK_API int hook_get_devices(device_info *devices, unsigned char *count);
+
+    // Drop or restore events from a source device before they reach the dispatch procedure.
+    // Device ids may be reused after a device is removed.  Safe to call from any thread.
+    // Currently only available on X11 and the virtual backend.
+    UIOHOOK_API int hook_set_device_enabled(uint8_t device, bool enabled);
+
     // Insert the event hook.
     UIOHOOK_API int hook_run();
 
     // Withdraw the event hook.
     UIOHOOK_API int hook_stop();
 
+    // Make hook_run() replay a recording from hook_recorder_start() at the speed multiplier, 0 for as fast as possible.
+    // Passing a NULL path restores live input.
+    // Currently only available on X11, other platforms return UIOHOOK_FAILURE.
+    UIOHOOK_API int hook_set_replay_source(const char *path, double speed);
+
+    // Feed native input events to the running virtual hook, returning once they have been dispatched.
+    // Only available when built with UIOHOOK_SOURCE_DIR=virtual.
+    UIOHOOK_API int hook_virtual_inject(const virtual_event *events, size_t count);
+
+    // Set the virtual clock in milliseconds used to timestamp events dispatched by the virtual hook.
+    // Only available when built with UIOHOOK_SOURCE_DIR=virtual.
+    UIOHOOK_API void hook_virtual_set_time(uint64_t time);
+
+    // Advance the virtual clock by delta milliseconds and return the new time.
+    // Only available when built with UIOHOOK_SOURCE_DIR=virtual.
+    UIOHOOK_API uint64_t hook_virtual_advance_time(uint64_t delta);
+
+    // Replace the screen layout reported by hook_get_screen_info(), a single 1920x1080 screen by default.
+    // Only available when built with UIOHOOK_SOURCE_DIR=virtual.
+    UIOHOOK_API int hook_virtual_set_screens(const screen_data *layout, uint8_t count);
+
+    // Replace the device list reported by hook_get_devices(), empty by default.
+    // Only available when built with UIOHOOK_SOURCE_DIR=virtual.
+    UIOHOOK_API int hook_virtual_set_devices(const device_info *devices, uint8_t count);
+
     // Retrieves an array of screen data for each available monitor.
     UIOHOOK_API screen_data* hook_create_screen_info(unsigned char *count);
 
+    /* Copies the screen data for up to count monitors into the screens buffer
+     * and sets count to the number of monitors in the layout, which may be
+     * larger than the buffer.  On X11 and the virtual backend the layout is
+     * cached and no memory is allocated.
+     */
+    UIOHOOK_API int hook_get_screen_info(screen_data *screens, unsigned char *count);
+
     // Retrieves the keyboard auto repeat rate.
     UIOHOOK_API long int hook_get_auto_repeat_rate();
 
@@ -450,6 +738,15 @@ extern "C" {
     // Retrieves the double/triple click interval.
     UIOHOOK_API long int hook_get_multi_click_time();
 
+    /* Retrieves all of the above properties at once.  On X11 the values are
+     * cached and updated when the server reports a change, so this is safe to
+     * call from the dispatch procedure.  The server reports no change of the
+     * pointer acceleration, threshold and sensitivity, those three are only
+     * refreshed when the hook starts and by the hook_get_pointer_*() getters,
+     * which query the server on every call.
+     */
+    UIOHOOK_API int hook_get_system_properties(system_properties *properties);
+
 #ifdef __cplusplus
 }
 #endif
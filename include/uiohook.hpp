@@ -0,0 +1,220 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Header-only C++20 layer over uiohook.h.  A Hook<Handler> calls the handler
+ * methods that exist for each event type, such as on_key_pressed() or
+ * on_mouse_moved(), without virtual calls or a switch in the handler.  Event
+ * types without a method are dropped before any handler code runs.
+ *
+ *    struct Handler {
+ *        void on_key_pressed(uiohook_event &event) { ... }
+ *    };
+ *
+ *    Handler handler;
+ *    uiohook::Hook<Handler> hook(handler);
+ *    hook.start();
+ */
+
+#ifndef _included_uiohook_hpp
+#define _included_uiohook_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+#include <uiohook.h>
+
+namespace uiohook {
+
+// Bit of an event type in Hook<Handler>::handled_events.
+constexpr uint32_t event_bit(event_type type) noexcept {
+    return UINT32_C(1) << type;
+}
+
+namespace detail {
+
+// Calls the handler method for event type Type if the handler has one.
+template <typename Handler, event_type Type>
+struct handler_method;
+
+#define UIOHOOK_HANDLER_METHOD(type, method) \
+    template <typename Handler> \
+    struct handler_method<Handler, type> { \
+        static constexpr bool exists = requires(Handler &handler, uiohook_event &event) { handler.method(event); }; \
+        static void call(Handler &handler, uiohook_event &event) { \
+            if constexpr (exists) { \
+                handler.method(event); \
+            } \
+        } \
+    };
+
+UIOHOOK_HANDLER_METHOD(EVENT_HOOK_ENABLED, on_hook_enabled)
+UIOHOOK_HANDLER_METHOD(EVENT_HOOK_DISABLED, on_hook_disabled)
+UIOHOOK_HANDLER_METHOD(EVENT_KEY_TYPED, on_key_typed)
+UIOHOOK_HANDLER_METHOD(EVENT_KEY_PRESSED, on_key_pressed)
+UIOHOOK_HANDLER_METHOD(EVENT_KEY_RELEASED, on_key_released)
+UIOHOOK_HANDLER_METHOD(EVENT_MOUSE_CLICKED, on_mouse_clicked)
+UIOHOOK_HANDLER_METHOD(EVENT_MOUSE_PRESSED, on_mouse_pressed)
+UIOHOOK_HANDLER_METHOD(EVENT_MOUSE_RELEASED, on_mouse_released)
+UIOHOOK_HANDLER_METHOD(EVENT_MOUSE_MOVED, on_mouse_moved)
+UIOHOOK_HANDLER_METHOD(EVENT_MOUSE_DRAGGED, on_mouse_dragged)
+UIOHOOK_HANDLER_METHOD(EVENT_MOUSE_WHEEL, on_mouse_wheel)
+UIOHOOK_HANDLER_METHOD(EVENT_SCREEN_CHANGED, on_screen_changed)
+
+#undef UIOHOOK_HANDLER_METHOD
+
+// Event types start at EVENT_HOOK_ENABLED, one past each index.
+template <typename Handler, std::size_t... Indexes>
+constexpr uint32_t handled_events(std::index_sequence<Indexes...>) noexcept {
+    return ((handler_method<Handler, static_cast<event_type>(Indexes + 1)>::exists
+            ? event_bit(static_cast<event_type>(Indexes + 1)) : 0) | ... | 0);
+}
+
+} // namespace detail
+
+/* Owns the library dispatch procedure for its lifetime.  The library has a
+ * single dispatch procedure, so only one Hook may exist at a time.  The
+ * handler must outlive the hook and is called on the hook thread.
+ */
+template <typename Handler>
+class Hook {
+public:
+    // Event types with a handler method, the rest never reach the handler.
+    static constexpr uint32_t handled_events =
+            detail::handled_events<Handler>(std::make_index_sequence<EVENT_SCREEN_CHANGED>());
+
+    static_assert(handled_events != 0, "Handler has no on_* methods for any event type");
+
+    explicit Hook(Handler &handler) noexcept : handler_(handler) {
+        current_ = this;
+        hook_set_dispatch_proc(&Hook::dispatch);
+    }
+
+    // Stops the hook if it is running and releases the dispatch procedure.
+    ~Hook() {
+        stop();
+        hook_set_dispatch_proc(nullptr);
+        current_ = nullptr;
+    }
+
+    Hook(const Hook &) = delete;
+    Hook &operator=(const Hook &) = delete;
+
+    // Run the hook on the calling thread until stop() is called, see hook_run().
+    int run() {
+        state_.store(state::starting, std::memory_order_release);
+
+        int status = hook_run();
+
+        state_.store(state::stopped, std::memory_order_release);
+        state_.notify_all();
+
+        return status;
+    }
+
+    // Run the hook on a thread owned by this object, returning once it is enabled or failed to start.
+    int start() {
+        if (thread_.joinable()) {
+            return UIOHOOK_FAILURE;
+        }
+
+        status_ = UIOHOOK_SUCCESS;
+        state_.store(state::starting, std::memory_order_release);
+        thread_ = std::thread([this] {
+            status_ = hook_run();
+
+            state_.store(state::stopped, std::memory_order_release);
+            state_.notify_all();
+        });
+
+        state_.wait(state::starting, std::memory_order_acquire);
+        if (state_.load(std::memory_order_acquire) == state::stopped) {
+            thread_.join();
+            return status_;
+        }
+
+        return UIOHOOK_SUCCESS;
+    }
+
+    // Withdraw the hook and wait for the thread started by start(), see hook_stop().
+    int stop() {
+        int status = UIOHOOK_SUCCESS;
+        if (running()) {
+            status = hook_stop();
+        }
+
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+
+        return status;
+    }
+
+    // True from EVENT_HOOK_ENABLED until hook_run() returns.
+    bool running() const noexcept {
+        return state_.load(std::memory_order_acquire) == state::running;
+    }
+
+private:
+    enum class state { stopped, starting, running };
+
+    template <event_type Type>
+    static void call(uiohook_event &event) {
+        if constexpr (handled_events & event_bit(Type)) {
+            detail::handler_method<Handler, Type>::call(current_->handler_, event);
+        }
+    }
+
+    static void dispatch(uiohook_event *const event) {
+        if (event->type == EVENT_HOOK_ENABLED) {
+            current_->state_.store(state::running, std::memory_order_release);
+            current_->state_.notify_all();
+        }
+
+        if ((handled_events & event_bit(event->type)) == 0) {
+            return;
+        }
+
+        switch (event->type) {
+            case EVENT_HOOK_ENABLED:   call<EVENT_HOOK_ENABLED>(*event);   break;
+            case EVENT_HOOK_DISABLED:  call<EVENT_HOOK_DISABLED>(*event);  break;
+            case EVENT_KEY_TYPED:      call<EVENT_KEY_TYPED>(*event);      break;
+            case EVENT_KEY_PRESSED:    call<EVENT_KEY_PRESSED>(*event);    break;
+            case EVENT_KEY_RELEASED:   call<EVENT_KEY_RELEASED>(*event);   break;
+            case EVENT_MOUSE_CLICKED:  call<EVENT_MOUSE_CLICKED>(*event);  break;
+            case EVENT_MOUSE_PRESSED:  call<EVENT_MOUSE_PRESSED>(*event);  break;
+            case EVENT_MOUSE_RELEASED: call<EVENT_MOUSE_RELEASED>(*event); break;
+            case EVENT_MOUSE_MOVED:    call<EVENT_MOUSE_MOVED>(*event);    break;
+            case EVENT_MOUSE_DRAGGED:  call<EVENT_MOUSE_DRAGGED>(*event);  break;
+            case EVENT_MOUSE_WHEEL:    call<EVENT_MOUSE_WHEEL>(*event);    break;
+            case EVENT_SCREEN_CHANGED: call<EVENT_SCREEN_CHANGED>(*event); break;
+        }
+    }
+
+    static inline Hook *current_ = nullptr;
+
+    Handler &handler_;
+    std::thread thread_;
+    std::atomic<state> state_ { state::stopped };
+    int status_ = UIOHOOK_SUCCESS;
+};
+
+} // namespace uiohook
+
+#endif
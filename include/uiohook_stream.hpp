@@ -0,0 +1,257 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Header-only C++20 coroutine stream of hook events.  The hook thread pushes
+ * events into a single producer, single consumer lock-free ring and signals a
+ * file descriptor when a coroutine is waiting.  The executor watches fd() with
+ * its own poll loop and calls poll() when it is readable, which resumes the
+ * waiting coroutine on the executor thread.  No thread blocks on the consumer
+ * side.  POSIX only, an eventfd is used on Linux and a pipe elsewhere.
+ *
+ *    uiohook::EventStream<> stream;
+ *    uiohook::Hook<uiohook::EventStream<>> hook(stream);
+ *    hook.start();
+ *
+ *    task consume(uiohook::EventStream<> &stream) {
+ *        for (;;) {
+ *            for (const uiohook_event &event : co_await stream.next()) { ... }
+ *        }
+ *    }
+ */
+
+#ifndef _included_uiohook_stream_hpp
+#define _included_uiohook_stream_hpp
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+#include <uiohook.hpp>
+
+namespace uiohook {
+
+// Events available to a consumer, valid until the next call to EventStream::next().
+class EventBatch {
+public:
+    class iterator {
+    public:
+        iterator(const uiohook_event *ring, std::size_t mask, std::size_t index) noexcept
+                : ring_(ring), mask_(mask), index_(index) {}
+
+        const uiohook_event &operator*() const noexcept { return ring_[index_ & mask_]; }
+        const uiohook_event *operator->() const noexcept { return &ring_[index_ & mask_]; }
+        iterator &operator++() noexcept { index_++; return *this; }
+        bool operator==(const iterator &other) const noexcept { return index_ == other.index_; }
+
+    private:
+        const uiohook_event *ring_;
+        std::size_t mask_;
+        std::size_t index_;
+    };
+
+    EventBatch(const uiohook_event *ring, std::size_t mask, std::size_t head, std::size_t tail) noexcept
+            : ring_(ring), mask_(mask), head_(head), tail_(tail) {}
+
+    iterator begin() const noexcept { return iterator(ring_, mask_, head_); }
+    iterator end() const noexcept { return iterator(ring_, mask_, tail_); }
+    std::size_t size() const noexcept { return tail_ - head_; }
+    bool empty() const noexcept { return head_ == tail_; }
+
+private:
+    const uiohook_event *ring_;
+    std::size_t mask_;
+    std::size_t head_;
+    std::size_t tail_;
+};
+
+/* Handler for Hook<Handler> that queues every event for a single awaiting
+ * coroutine.  The hook thread never blocks, events that do not fit in the ring
+ * are dropped and counted.  The last slot is kept for EVENT_HOOK_DISABLED, so
+ * the batch that contains it is always delivered and is the last one until the
+ * hook is started again.
+ */
+template <std::size_t Capacity = 1024>
+class EventStream {
+    static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two larger than one");
+
+public:
+    class awaiter {
+    public:
+        explicit awaiter(EventStream &stream) noexcept : stream_(stream) {}
+
+        bool await_ready() const noexcept {
+            return !stream_.empty();
+        }
+
+        // Suspend unless an event arrived after the waiter was published.
+        bool await_suspend(std::coroutine_handle<> handle) noexcept {
+            stream_.waiter_.store(handle.address(), std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (!stream_.empty() && stream_.waiter_.exchange(nullptr, std::memory_order_acq_rel) != nullptr) {
+                return false;
+            }
+
+            return true;
+        }
+
+        EventBatch await_resume() noexcept {
+            return stream_.take();
+        }
+
+    private:
+        EventStream &stream_;
+    };
+
+    EventStream() noexcept {
+        #ifdef __linux__
+        fds_[0] = fds_[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        #else
+        if (pipe(fds_) == 0) {
+            for (int fd : fds_) {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+            }
+        } else {
+            fds_[0] = fds_[1] = -1;
+        }
+        #endif
+    }
+
+    ~EventStream() {
+        if (fds_[0] >= 0) {
+            close(fds_[0]);
+        }
+
+        if (fds_[1] != fds_[0] && fds_[1] >= 0) {
+            close(fds_[1]);
+        }
+    }
+
+    EventStream(const EventStream &) = delete;
+    EventStream &operator=(const EventStream &) = delete;
+
+    // Readable when the waiting coroutine should be resumed with poll(), -1 if it could not be created.
+    int fd() const noexcept {
+        return fds_[0];
+    }
+
+    // Release the previous batch and await the next non-empty one.
+    awaiter next() noexcept {
+        head_.store(taken_, std::memory_order_release);
+
+        return awaiter(*this);
+    }
+
+    // Call on the executor thread when fd() is readable, returns true if a coroutine was resumed.
+    bool poll() {
+        char buffer[8];
+        while (read(fds_[0], buffer, sizeof(buffer)) > 0);
+        signaled_.store(false, std::memory_order_seq_cst);
+
+        void *waiter = waiter_.exchange(nullptr, std::memory_order_acq_rel);
+        if (waiter == nullptr) {
+            return false;
+        }
+
+        std::coroutine_handle<>::from_address(waiter).resume();
+
+        return true;
+    }
+
+    // Events dropped because the consumer fell Capacity - 1 events behind.
+    uint64_t dropped() const noexcept {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    // Called on the hook thread by Hook<EventStream>.
+    void push(const uiohook_event &event) noexcept {
+        // Only the terminal event may take the last slot.
+        const std::size_t limit = event.type == EVENT_HOOK_DISABLED ? Capacity : Capacity - 1;
+
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= limit) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        ring_[tail & (Capacity - 1)] = event;
+        tail_.store(tail + 1, std::memory_order_release);
+
+        // Pairs with the fence in awaiter::await_suspend() so either side sees the other.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiter_.load(std::memory_order_seq_cst) != nullptr && !signaled_.exchange(true, std::memory_order_seq_cst)) {
+            #ifdef __linux__
+            const uint64_t value = 1;
+            #else
+            const char value = 1;
+            #endif
+            [[maybe_unused]] ssize_t written = write(fds_[1], &value, sizeof(value));
+        }
+    }
+
+    void on_hook_enabled(uiohook_event &event) { push(event); }
+    void on_hook_disabled(uiohook_event &event) { push(event); }
+    void on_key_typed(uiohook_event &event) { push(event); }
+    void on_key_pressed(uiohook_event &event) { push(event); }
+    void on_key_released(uiohook_event &event) { push(event); }
+    void on_mouse_clicked(uiohook_event &event) { push(event); }
+    void on_mouse_pressed(uiohook_event &event) { push(event); }
+    void on_mouse_released(uiohook_event &event) { push(event); }
+    void on_mouse_moved(uiohook_event &event) { push(event); }
+    void on_mouse_dragged(uiohook_event &event) { push(event); }
+    void on_mouse_wheel(uiohook_event &event) { push(event); }
+    void on_screen_changed(uiohook_event &event) { push(event); }
+
+private:
+    bool empty() const noexcept {
+        return tail_.load(std::memory_order_acquire) == taken_;
+    }
+
+    EventBatch take() noexcept {
+        std::size_t head = taken_;
+        taken_ = tail_.load(std::memory_order_acquire);
+
+        return EventBatch(ring_, Capacity - 1, head, taken_);
+    }
+
+    uiohook_event ring_[Capacity];
+
+    // Written by the consumer, head_ trails taken_ until the batch is released.
+    alignas(64) std::atomic<std::size_t> head_ { 0 };
+    std::size_t taken_ = 0;
+
+    // Written by the hook thread.
+    alignas(64) std::atomic<std::size_t> tail_ { 0 };
+    std::atomic<uint64_t> dropped_ { 0 };
+
+    std::atomic<void *> waiter_ { nullptr };
+    std::atomic<bool> signaled_ { false };
+    int fds_[2];
+};
+
+} // namespace uiohook
+
+#endif
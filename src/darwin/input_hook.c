@@ -718,6 +718,9 @@ static inline void process_button_pressed(uint64_t timestamp, CGEventRef event_r
     event.data.mouse.clicks = click_count;
     event.data.mouse.x = event_point.x;
     event.data.mouse.y = event_point.y;
+    event.data.mouse.screen = SCREEN_UNDEFINED;
+    event.data.mouse.screen_x = event.data.mouse.x;
+    event.data.mouse.screen_y = event.data.mouse.y;
 
     logger(LOG_LEVEL_DEBUG, "%s [%u]: Button %u pressed %u time(s). (%u, %u)\n",
             __FUNCTION__, __LINE__, event.data.mouse.button, event.data.mouse.clicks,
@@ -741,6 +744,9 @@ static inline void process_button_released(uint64_t timestamp, CGEventRef event_
     event.data.mouse.clicks = click_count;
     event.data.mouse.x = event_point.x;
     event.data.mouse.y = event_point.y;
+    event.data.mouse.screen = SCREEN_UNDEFINED;
+    event.data.mouse.screen_x = event.data.mouse.x;
+    event.data.mouse.screen_y = event.data.mouse.y;
 
     logger(LOG_LEVEL_DEBUG, "%s [%u]: Button %u released %u time(s). (%u, %u)\n",
             __FUNCTION__, __LINE__, event.data.mouse.button, event.data.mouse.clicks,
@@ -762,6 +768,9 @@ static inline void process_button_released(uint64_t timestamp, CGEventRef event_
         event.data.mouse.clicks = click_count;
         event.data.mouse.x = event_point.x;
         event.data.mouse.y = event_point.y;
+        event.data.mouse.screen = SCREEN_UNDEFINED;
+        event.data.mouse.screen_x = event.data.mouse.x;
+        event.data.mouse.screen_y = event.data.mouse.y;
 
         logger(LOG_LEVEL_DEBUG, "%s [%u]: Button %u clicked %u time(s). (%u, %u)\n",
                 __FUNCTION__, __LINE__, event.data.mouse.button, event.data.mouse.clicks,
@@ -802,6 +811,9 @@ static inline void process_mouse_moved(uint64_t timestamp, CGEventRef event_ref)
     event.data.mouse.clicks = click_count;
     event.data.mouse.x = event_point.x;
     event.data.mouse.y = event_point.y;
+    event.data.mouse.screen = SCREEN_UNDEFINED;
+    event.data.mouse.screen_x = event.data.mouse.x;
+    event.data.mouse.screen_y = event.data.mouse.y;
 
     logger(LOG_LEVEL_DEBUG, "%s [%u]: Mouse %s to %u, %u.\n",
             __FUNCTION__, __LINE__, mouse_dragged ? "dragged" : "moved",
@@ -833,6 +845,9 @@ static inline void process_mouse_wheel(uint64_t timestamp, CGEventRef event_ref)
         event.data.wheel.clicks = click_count;
         event.data.wheel.x = event_point.x;
         event.data.wheel.y = event_point.y;
+        event.data.wheel.screen = SCREEN_UNDEFINED;
+        event.data.wheel.screen_x = event.data.wheel.x;
+        event.data.wheel.screen_y = event.data.wheel.y;
 
         // TODO Figure out if kCGScrollWheelEventDeltaAxis2 causes mouse events with zero rotation.
         if (CGEventGetIntegerValueField(event_ref, kCGScrollWheelEventIsContinuous) == 0) {
@@ -1434,3 +1449,32 @@ UIOHOOK_API int hook_stop() {
 
     return status;
 }
+
+UIOHOOK_API int hook_recorder_start(const char *path, const recorder_options *options) {
+    (void) path;
+    (void) options;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Recording is not supported on this platform!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
+
+UIOHOOK_API int hook_recorder_stop(recorder_stats *stats) {
+    (void) stats;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Recording is not supported on this platform!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
+
+UIOHOOK_API int hook_set_replay_source(const char *path, double speed) {
+    (void) path;
+    (void) speed;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Replay sources are not supported on this platform!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
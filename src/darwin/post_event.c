@@ -25,6 +25,9 @@
 #include "input_helper.h"
 #include "logger.h"
 
+// CGEventKeyboardSetUnicodeString() only supports a small number of characters.
+#define POST_TEXT_CHUNK_SIZE 20
+
 static CGEventFlags current_modifier_mask = 0x00;
 static CGEventType current_motion_event = kCGEventMouseMoved;
 static CGMouseButton current_motion_button = 0;
@@ -301,3 +304,78 @@ UIOHOOK_API void hook_post_event(uiohook_event * const event) {
 
     CFRelease(src);
 }
+
+UIOHOOK_API int hook_post_text(const char *utf8, size_t length) {
+    CFStringRef text = CFStringCreateWithBytes(kCFAllocatorDefault, (const UInt8 *) utf8, (CFIndex) length, kCFStringEncodingUTF8, false);
+    if (text == NULL) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: CFStringCreateWithBytes failed!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+
+    CGEventSourceRef src = CGEventSourceCreate(kCGEventSourceStateHIDSystemState);
+    if (src == NULL) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: CGEventSourceCreate failed!\n",
+                __FUNCTION__, __LINE__);
+
+        CFRelease(text);
+        return UIOHOOK_ERROR_OUT_OF_MEMORY;
+    }
+
+    int status = UIOHOOK_SUCCESS;
+
+    // Keyboard events can only carry a limited number of characters each.
+    UniChar buffer[POST_TEXT_CHUNK_SIZE];
+    CFIndex count = CFStringGetLength(text), size;
+    for (CFIndex i = 0; i < count && status == UIOHOOK_SUCCESS; i += size) {
+        size = count - i < POST_TEXT_CHUNK_SIZE ? count - i : POST_TEXT_CHUNK_SIZE;
+
+        // Do not split surrogate pairs across events.
+        if (size == POST_TEXT_CHUNK_SIZE && CFStringIsSurrogateHighCharacter(CFStringGetCharacterAtIndex(text, i + size - 1))) {
+            size--;
+        }
+
+        CFStringGetCharacters(text, CFRangeMake(i, size), buffer);
+
+        for (int j = 0; j < 2; j++) {
+            CGEventRef cg_event = CGEventCreateKeyboardEvent(src, 0, j == 0);
+            if (cg_event == NULL) {
+                logger(LOG_LEVEL_ERROR, "%s [%u]: CGEventCreateKeyboardEvent failed!\n",
+                        __FUNCTION__, __LINE__);
+
+                status = UIOHOOK_ERROR_OUT_OF_MEMORY;
+                break;
+            }
+
+            CGEventKeyboardSetUnicodeString(cg_event, (UniCharCount) size, buffer);
+            CGEventPost(kCGHIDEventTap, cg_event);
+            CFRelease(cg_event);
+        }
+    }
+
+    CFRelease(src);
+    CFRelease(text);
+
+    return status;
+}
+
+UIOHOOK_API int hook_post_motion_path(const motion_path *path) {
+    (void) path;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Motion paths are not supported on this platform!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
+
+UIOHOOK_API int hook_replay_events(const uiohook_event *events, size_t count, double speed, replay_stats *stats) {
+    (void) events;
+    (void) count;
+    (void) speed;
+    (void) stats;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Event replay is not supported on this platform!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
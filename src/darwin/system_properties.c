@@ -31,6 +31,8 @@
 #endif
 
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 #include <uiohook.h>
 
 #include "logger.h"
@@ -120,6 +122,22 @@ UIOHOOK_API screen_data* hook_create_screen_info(unsigned char *count) {
     return screens;
 }
 
+UIOHOOK_API int hook_get_screen_info(screen_data *screens, unsigned char *count) {
+    if (count == NULL || (screens == NULL && *count > 0)) {
+        return UIOHOOK_FAILURE;
+    }
+
+    unsigned char total = 0;
+    screen_data *info = hook_create_screen_info(&total);
+    if (info != NULL) {
+        memcpy(screens, info, sizeof(screen_data) * (total < *count ? total : *count));
+        free(info);
+    }
+    *count = total;
+
+    return UIOHOOK_SUCCESS;
+}
+
 /*
  * Apple's documentation is not very good.  I was finally able to find this
  * information after many hours of googling.  Value is the slider value in the
@@ -445,6 +463,21 @@ UIOHOOK_API long int hook_get_multi_click_time() {
     return value;
 }
 
+UIOHOOK_API int hook_get_system_properties(system_properties *properties) {
+    if (properties == NULL) {
+        return UIOHOOK_FAILURE;
+    }
+
+    properties->auto_repeat_rate = hook_get_auto_repeat_rate();
+    properties->auto_repeat_delay = hook_get_auto_repeat_delay();
+    properties->pointer_acceleration_multiplier = hook_get_pointer_acceleration_multiplier();
+    properties->pointer_acceleration_threshold = hook_get_pointer_acceleration_threshold();
+    properties->pointer_sensitivity = hook_get_pointer_sensitivity();
+    properties->multi_click_time = hook_get_multi_click_time();
+
+    return UIOHOOK_SUCCESS;
+}
+
 
 // Create a shared object constructor.
 __attribute__ ((constructor))
@@ -0,0 +1,984 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <uiohook.h>
+
+#include "dispatch_event.h"
+#include "logger.h"
+#include "seqlock.h"
+#include "trace.h"
+#include "usdt.h"
+#ifdef USE_RECORDER
+#include "recorder.h"
+#endif
+
+typedef struct _input_state {
+    uint16_t mask;
+    input_snapshot snapshot;
+    struct _mouse {
+        bool is_dragged;
+        struct _click {
+            unsigned short int count;
+            long int time;
+            unsigned short int button;
+        } click;
+    } mouse;
+} input_state;
+static input_state input;
+
+// Input state published for hook_get_input_snapshot(), written only by the hook thread.
+static seqlock snapshot_lock = SEQLOCK_INITIALIZER;
+static input_snapshot snapshot;
+
+// Largest grid built by dispatch_set_screens(), larger layouts are scanned linearly.
+#define SCREEN_INDEX_MAX_CELLS 4096
+
+/* Screen layout with an interval index over the screen edges.  The sorted
+ * edges split the layout into a grid of cells that each belong to at most one
+ * screen, so resolving a position takes two binary searches regardless of the
+ * number of screens.  Owned by the hook thread and rebuilt only when the
+ * layout changes.
+ */
+typedef struct _screen_index {
+    uint8_t count;
+    screen_data screens[UINT8_MAX];
+    uint16_t columns;
+    uint16_t rows;
+    int32_t x_edges[UINT8_MAX * 2];
+    int32_t y_edges[UINT8_MAX * 2];
+    bool grid;
+    uint8_t cells[SCREEN_INDEX_MAX_CELLS];
+} screen_index;
+static screen_index screens;
+
+// Devices published for hook_get_devices(), written only by the hook thread.
+typedef struct _device_table {
+    uint8_t count;
+    device_info devices[UINT8_MAX];
+} device_table;
+static seqlock devices_lock = SEQLOCK_INITIALIZER;
+static device_table devices;
+
+// Class of each device id and the source of the event being dispatched, owned by the hook thread.
+static uint8_t device_classes[UINT8_MAX + 1];
+static uint8_t source_device = DEVICE_UNDEFINED;
+
+// Devices dropped by hook_set_device_enabled(), one bit per device id.
+static uint32_t disabled_devices[(UINT8_MAX + 1) / 32];
+
+// Multi-click time in milliseconds set by the input source, read by the hook thread.
+static long int multi_click_time = 200;
+
+// Virtual event pointer.
+static uiohook_event event;
+
+// Event dispatch callback.
+static dispatcher_t dispatcher = NULL;
+
+// Default dispatch_budget values used for zero fields.
+#define WATCHDOG_DEFAULT_OFFLOAD_AFTER  3
+#define WATCHDOG_DEFAULT_RECOVER_AFTER  100
+#define WATCHDOG_DEFAULT_QUEUE_SIZE     1024
+
+/* Times each dispatch procedure call against the budget from
+ * hook_set_dispatch_budget().  With offload, a slow dispatch procedure is
+ * moved to a worker thread fed by a single producer ring buffer until it is
+ * fast again, so the hook thread keeps reading events.
+ */
+typedef struct _dispatch_watchdog {
+    uint64_t budget;                // Nanoseconds, 0 when the watchdog is disabled.
+    uint16_t offload_after;
+    uint16_t recover_after;
+    bool offload;
+    bool running;                   // Set between EVENT_HOOK_ENABLED and EVENT_HOOK_DISABLED.
+
+    // Only touched by the hook thread.
+    bool queued;
+    uint16_t slow_streak;
+
+    // Written by the worker thread while queued.
+    uint16_t fast_streak;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t worker_id;
+    bool worker_running;
+    uiohook_event *ring;
+    uint64_t capacity;
+    uint64_t head;                  // Events queued by the hook thread.
+    uint64_t tail;                  // Events dispatched by the worker thread.
+
+    dispatch_stats stats;
+} dispatch_watchdog;
+
+static dispatch_watchdog watchdog = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER
+};
+
+UIOHOOK_API void hook_set_dispatch_proc(dispatcher_t dispatch_proc) {
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Setting new dispatch callback to %#p.\n",
+            __FUNCTION__, __LINE__, dispatch_proc);
+
+    dispatcher = dispatch_proc;
+}
+
+void dispatch_set_multi_click_time(long int time) {
+    __atomic_store_n(&multi_click_time, time, __ATOMIC_RELAXED);
+}
+
+static inline long int get_multi_click_time() {
+    return __atomic_load_n(&multi_click_time, __ATOMIC_RELAXED);
+}
+
+// True if the event comes from a device disabled by hook_set_device_enabled().
+static inline bool is_device_disabled(uint8_t device) {
+    return (__atomic_load_n(&disabled_devices[device / 32], __ATOMIC_RELAXED) & (1U << (device % 32))) != 0;
+}
+
+static uint64_t get_monotonic_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+static inline void call_dispatcher(uiohook_event *const event) {
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Dispatching event type %u.\n",
+            __FUNCTION__, __LINE__, event->type);
+
+    USDT_PROBE3(dispatch_begin, event->type, event->time, event->device);
+    TRACE_BEGIN(span);
+    dispatcher(event);
+    TRACE_END(TRACE_STAGE_DISPATCH, event->type, span);
+    USDT_PROBE3(dispatch_end, event->type, event->time, event->reserved);
+}
+
+// Call the dispatch procedure and update the watchdog statistics, returns true if it was over budget.
+static bool call_dispatcher_timed(uiohook_event *const event) {
+    uint64_t start = get_monotonic_ns();
+    call_dispatcher(event);
+    uint64_t elapsed = get_monotonic_ns() - start;
+
+    __atomic_store_n(&watchdog.stats.calls, watchdog.stats.calls + 1, __ATOMIC_RELAXED);
+    if (elapsed / 1000 > watchdog.stats.max) {
+        __atomic_store_n(&watchdog.stats.max, elapsed / 1000, __ATOMIC_RELAXED);
+    }
+
+    if (elapsed <= watchdog.budget) {
+        return false;
+    }
+
+    __atomic_store_n(&watchdog.stats.slow, watchdog.stats.slow + 1, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+static void * watchdog_worker_proc(void *arg) {
+    (void) arg;
+
+    pthread_mutex_lock(&watchdog.mutex);
+    while (watchdog.worker_running) {
+        uint64_t tail = watchdog.tail;
+        if (tail == __atomic_load_n(&watchdog.head, __ATOMIC_ACQUIRE)) {
+            pthread_cond_wait(&watchdog.cond, &watchdog.mutex);
+            continue;
+        }
+        pthread_mutex_unlock(&watchdog.mutex);
+
+        // The dispatch procedure may have been removed after the event was queued.
+        uiohook_event copy = watchdog.ring[tail & (watchdog.capacity - 1)];
+        if (dispatcher != NULL && call_dispatcher_timed(&copy)) {
+            __atomic_store_n(&watchdog.fast_streak, 0, __ATOMIC_RELAXED);
+        } else if (watchdog.fast_streak < UINT16_MAX) {
+            __atomic_store_n(&watchdog.fast_streak, watchdog.fast_streak + 1, __ATOMIC_RELAXED);
+        }
+
+        // The slot is only released once the dispatch procedure returned.
+        pthread_mutex_lock(&watchdog.mutex);
+        __atomic_store_n(&watchdog.tail, tail + 1, __ATOMIC_RELEASE);
+        pthread_cond_broadcast(&watchdog.cond);
+    }
+    pthread_mutex_unlock(&watchdog.mutex);
+
+    return NULL;
+}
+
+// Wait for the worker thread to dispatch every queued event and dispatch inline again.
+static void watchdog_drain() {
+    pthread_mutex_lock(&watchdog.mutex);
+    while (__atomic_load_n(&watchdog.tail, __ATOMIC_ACQUIRE) != watchdog.head) {
+        pthread_cond_wait(&watchdog.cond, &watchdog.mutex);
+    }
+    pthread_mutex_unlock(&watchdog.mutex);
+
+    watchdog.queued = false;
+    watchdog.slow_streak = 0;
+    __atomic_store_n(&watchdog.stats.queued, false, __ATOMIC_RELAXED);
+}
+
+static void watchdog_dispatch(uiohook_event *const event) {
+    if (watchdog.queued) {
+        // Dispatch inline again once the worker drained the queue within budget.
+        if (__atomic_load_n(&watchdog.fast_streak, __ATOMIC_RELAXED) >= watchdog.recover_after
+                && __atomic_load_n(&watchdog.tail, __ATOMIC_ACQUIRE) == watchdog.head) {
+            logger(LOG_LEVEL_INFO, "%s [%u]: Dispatch procedure is within budget, dispatching inline.\n",
+                    __FUNCTION__, __LINE__);
+            watchdog_drain();
+        } else {
+            pthread_mutex_lock(&watchdog.mutex);
+            if (watchdog.head - __atomic_load_n(&watchdog.tail, __ATOMIC_ACQUIRE) < watchdog.capacity) {
+                watchdog.ring[watchdog.head & (watchdog.capacity - 1)] = *event;
+                __atomic_store_n(&watchdog.head, watchdog.head + 1, __ATOMIC_RELEASE);
+                __atomic_store_n(&watchdog.stats.offloaded, watchdog.stats.offloaded + 1, __ATOMIC_RELAXED);
+                pthread_cond_broadcast(&watchdog.cond);
+            } else {
+                __atomic_store_n(&watchdog.stats.dropped, watchdog.stats.dropped + 1, __ATOMIC_RELAXED);
+            }
+            pthread_mutex_unlock(&watchdog.mutex);
+
+            return;
+        }
+    }
+
+    if (!call_dispatcher_timed(event)) {
+        watchdog.slow_streak = 0;
+        return;
+    }
+
+    if (watchdog.slow_streak++ == 0) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: Dispatch procedure exceeded its %llu us budget for event type %u.\n",
+                __FUNCTION__, __LINE__, (unsigned long long) watchdog.budget / 1000, event->type);
+    }
+
+    if (watchdog.offload && watchdog.slow_streak >= watchdog.offload_after) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: Dispatch procedure is over budget, dispatching from the worker thread.\n",
+                __FUNCTION__, __LINE__);
+
+        __atomic_store_n(&watchdog.fast_streak, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&watchdog.stats.queued, true, __ATOMIC_RELAXED);
+        watchdog.queued = true;
+    }
+}
+
+// Stop the worker thread and release the queue.
+static void watchdog_stop_worker() {
+    if (!watchdog.worker_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&watchdog.mutex);
+    watchdog.worker_running = false;
+    pthread_cond_broadcast(&watchdog.cond);
+    pthread_mutex_unlock(&watchdog.mutex);
+
+    pthread_join(watchdog.worker_id, NULL);
+
+    free(watchdog.ring);
+    watchdog.ring = NULL;
+}
+
+UIOHOOK_API int hook_set_dispatch_budget(const dispatch_budget *budget) {
+    if (__atomic_load_n(&watchdog.running, __ATOMIC_ACQUIRE)) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: The dispatch budget cannot change while the hook is running!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+
+    watchdog_stop_worker();
+    memset(&watchdog.stats, 0, sizeof(dispatch_stats));
+    watchdog.queued = false;
+    watchdog.slow_streak = 0;
+    watchdog.fast_streak = 0;
+    watchdog.head = 0;
+    watchdog.tail = 0;
+
+    if (budget == NULL || budget->budget == 0) {
+        watchdog.budget = 0;
+        watchdog.offload = false;
+
+        return UIOHOOK_SUCCESS;
+    }
+
+    watchdog.budget = (uint64_t) budget->budget * 1000;
+    watchdog.offload = budget->offload;
+    watchdog.offload_after = budget->offload_after > 0 ? budget->offload_after : WATCHDOG_DEFAULT_OFFLOAD_AFTER;
+    watchdog.recover_after = budget->recover_after > 0 ? budget->recover_after : WATCHDOG_DEFAULT_RECOVER_AFTER;
+
+    if (watchdog.offload) {
+        size_t queue_size = budget->queue_size > 0 ? budget->queue_size : WATCHDOG_DEFAULT_QUEUE_SIZE;
+
+        // Round up to a power of two so the ring index is a mask.
+        watchdog.capacity = 2;
+        while (watchdog.capacity < queue_size) {
+            watchdog.capacity <<= 1;
+        }
+
+        watchdog.ring = (uiohook_event *) calloc(watchdog.capacity, sizeof(uiohook_event));
+        if (watchdog.ring == NULL) {
+            logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to allocate memory for dispatch queue!\n",
+                    __FUNCTION__, __LINE__);
+
+            watchdog.budget = 0;
+            watchdog.offload = false;
+            return UIOHOOK_ERROR_OUT_OF_MEMORY;
+        }
+
+        watchdog.worker_running = true;
+        if (pthread_create(&watchdog.worker_id, NULL, watchdog_worker_proc, NULL) != 0) {
+            logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to create dispatch worker thread!\n",
+                    __FUNCTION__, __LINE__);
+
+            watchdog.worker_running = false;
+            free(watchdog.ring);
+            watchdog.ring = NULL;
+            watchdog.budget = 0;
+            watchdog.offload = false;
+            return UIOHOOK_FAILURE;
+        }
+    }
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Dispatch budget set to %u us%s.\n",
+            __FUNCTION__, __LINE__, budget->budget, watchdog.offload ? " with offload" : "");
+
+    return UIOHOOK_SUCCESS;
+}
+
+UIOHOOK_API int hook_get_dispatch_stats(dispatch_stats *stats) {
+    if (stats == NULL) {
+        return UIOHOOK_FAILURE;
+    }
+
+    stats->calls = __atomic_load_n(&watchdog.stats.calls, __ATOMIC_RELAXED);
+    stats->slow = __atomic_load_n(&watchdog.stats.slow, __ATOMIC_RELAXED);
+    stats->max = __atomic_load_n(&watchdog.stats.max, __ATOMIC_RELAXED);
+    stats->offloaded = __atomic_load_n(&watchdog.stats.offloaded, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&watchdog.stats.dropped, __ATOMIC_RELAXED);
+    stats->queued = __atomic_load_n(&watchdog.stats.queued, __ATOMIC_RELAXED);
+
+    return UIOHOOK_SUCCESS;
+}
+
+// Send out an event if a dispatcher was set.
+static inline void dispatch_event(uiohook_event *const event) {
+    // Hook and screen events do not come from an input device.
+    if (event->type == EVENT_HOOK_ENABLED || event->type == EVENT_HOOK_DISABLED || event->type == EVENT_SCREEN_CHANGED) {
+        event->device = DEVICE_UNDEFINED;
+    } else {
+        event->device = source_device;
+    }
+    event->device_class = device_classes[event->device];
+
+    if (event->device != DEVICE_UNDEFINED && is_device_disabled(event->device)) {
+        logger(LOG_LEVEL_DEBUG, "%s [%u]: Dropping event type %u from disabled device %u.\n",
+                __FUNCTION__, __LINE__, event->type, event->device);
+        return;
+    }
+
+    #ifdef USE_RECORDER
+    recorder_record(event);
+    #endif
+
+    if (dispatcher != NULL) {
+        if (watchdog.budget > 0) {
+            watchdog_dispatch(event);
+        } else {
+            call_dispatcher(event);
+        }
+    } else {
+        logger(LOG_LEVEL_WARN, "%s [%u]: No dispatch callback set!\n",
+                __FUNCTION__, __LINE__);
+    }
+}
+
+// Publish the tracked input state, called before each event is dispatched.
+static inline void publish_snapshot(uint64_t timestamp) {
+    input.snapshot.time = timestamp;
+    input.snapshot.mask = input.mask;
+    seqlock_write(&snapshot_lock, &snapshot, &input.snapshot, sizeof(input_snapshot));
+}
+
+// Publish the tracked input state with a new pointer position.
+static inline void publish_pointer_snapshot(uint64_t timestamp, int16_t x, int16_t y) {
+    input.snapshot.x = x;
+    input.snapshot.y = y;
+    publish_snapshot(timestamp);
+}
+
+UIOHOOK_API int hook_get_input_snapshot(input_snapshot *state) {
+    if (state == NULL) {
+        return UIOHOOK_FAILURE;
+    }
+
+    seqlock_read(&snapshot_lock, state, &snapshot, sizeof(input_snapshot));
+
+    return UIOHOOK_SUCCESS;
+}
+
+UIOHOOK_API int hook_get_devices(device_info *buffer, unsigned char *count) {
+    if (count == NULL || (buffer == NULL && *count > 0)) {
+        return UIOHOOK_FAILURE;
+    }
+
+    uint8_t total;
+    uint32_t sequence;
+    do {
+        sequence = seqlock_read_begin(&devices_lock);
+        total = __atomic_load_n(&devices.count, __ATOMIC_RELAXED);
+        seqlock_copy_from(buffer, devices.devices, sizeof(device_info) * (total < *count ? total : *count));
+    } while (seqlock_read_retry(&devices_lock, sequence));
+
+    *count = total;
+
+    return UIOHOOK_SUCCESS;
+}
+
+UIOHOOK_API int hook_set_device_enabled(uint8_t device, bool enabled) {
+    if (device == DEVICE_UNDEFINED) {
+        return UIOHOOK_FAILURE;
+    }
+
+    if (enabled) {
+        __atomic_and_fetch(&disabled_devices[device / 32], ~(1U << (device % 32)), __ATOMIC_RELAXED);
+    } else {
+        __atomic_or_fetch(&disabled_devices[device / 32], 1U << (device % 32), __ATOMIC_RELAXED);
+    }
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Device %u %s.\n",
+            __FUNCTION__, __LINE__, device, enabled ? "enabled" : "disabled");
+
+    return UIOHOOK_SUCCESS;
+}
+
+void dispatch_set_devices(const device_info *list, uint8_t count) {
+    memset(device_classes, DEVICE_CLASS_UNKNOWN, sizeof(device_classes));
+    for (uint8_t i = 0; i < count; i++) {
+        device_classes[list[i].id] = list[i].device_class;
+    }
+    device_classes[DEVICE_UNDEFINED] = DEVICE_CLASS_UNKNOWN;
+
+    // Only the entries in use are published.
+    seqlock_write_begin(&devices_lock);
+    seqlock_copy_to(devices.devices, list, sizeof(device_info) * count);
+    __atomic_store_n(&devices.count, count, __ATOMIC_RELAXED);
+    seqlock_write_end(&devices_lock);
+}
+
+void dispatch_set_source(uint8_t device) {
+    source_device = device;
+}
+
+void dispatch_reset(uint16_t mask) {
+    input.mask = mask;
+    memset(&input.snapshot, 0, sizeof(input_snapshot));
+    input.mouse.is_dragged = false;
+    input.mouse.click.count = 0;
+    input.mouse.click.time = 0;
+    input.mouse.click.button = MOUSE_NOBUTTON;
+    source_device = DEVICE_UNDEFINED;
+}
+
+// Sort the edges in place and drop duplicates, returning the new count.
+static uint16_t sort_edges(int32_t *edges, uint16_t count) {
+    for (uint16_t i = 1; i < count; i++) {
+        int32_t edge = edges[i];
+        uint16_t j = i;
+        for (; j > 0 && edges[j - 1] > edge; j--) {
+            edges[j] = edges[j - 1];
+        }
+        edges[j] = edge;
+    }
+
+    uint16_t unique = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        if (unique == 0 || edges[unique - 1] != edges[i]) {
+            edges[unique++] = edges[i];
+        }
+    }
+
+    return unique;
+}
+
+// Find the interval between two edges that contains value, or UINT16_MAX if there is none.
+static inline uint16_t find_interval(const int32_t *edges, uint16_t count, int32_t value) {
+    if (count < 2 || value < edges[0] || value >= edges[count - 1]) {
+        return UINT16_MAX;
+    }
+
+    uint16_t low = 0, high = count - 1;
+    while (high - low > 1) {
+        uint16_t mid = low + (high - low) / 2;
+        if (edges[mid] <= value) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+void dispatch_set_screens(const screen_data *layout, uint8_t count) {
+    screens.count = count;
+    screens.columns = 0;
+    screens.rows = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        screens.screens[i] = layout[i];
+        screens.x_edges[screens.columns++] = layout[i].x;
+        screens.x_edges[screens.columns++] = (int32_t) layout[i].x + layout[i].width;
+        screens.y_edges[screens.rows++] = layout[i].y;
+        screens.y_edges[screens.rows++] = (int32_t) layout[i].y + layout[i].height;
+    }
+
+    screens.columns = sort_edges(screens.x_edges, screens.columns);
+    screens.rows = sort_edges(screens.y_edges, screens.rows);
+
+    size_t cells = count > 0 ? (size_t) (screens.columns - 1) * (screens.rows - 1) : 0;
+    screens.grid = cells <= SCREEN_INDEX_MAX_CELLS;
+    if (screens.grid) {
+        memset(screens.cells, SCREEN_UNDEFINED, cells);
+
+        // Overlapping screens, such as mirrored outputs, resolve to the first one.
+        for (uint8_t i = count; i-- > 0;) {
+            uint16_t left = find_interval(screens.x_edges, screens.columns, layout[i].x);
+            uint16_t top = find_interval(screens.y_edges, screens.rows, layout[i].y);
+            if (left == UINT16_MAX || top == UINT16_MAX) {
+                // Screens without an area cover no cells.
+                continue;
+            }
+
+            for (uint16_t column = left; column < screens.columns - 1 && screens.x_edges[column] < (int32_t) layout[i].x + layout[i].width; column++) {
+                for (uint16_t row = top; row < screens.rows - 1 && screens.y_edges[row] < (int32_t) layout[i].y + layout[i].height; row++) {
+                    screens.cells[column * (screens.rows - 1) + row] = i;
+                }
+            }
+        }
+    } else {
+        logger(LOG_LEVEL_DEBUG, "%s [%u]: Screen layout exceeds the index, using a linear scan.\n",
+                __FUNCTION__, __LINE__);
+    }
+}
+
+// Find the screen that contains the position, or SCREEN_UNDEFINED.
+static inline uint8_t find_screen(int16_t x, int16_t y) {
+    if (screens.grid) {
+        uint16_t column = find_interval(screens.x_edges, screens.columns, x);
+        uint16_t row = find_interval(screens.y_edges, screens.rows, y);
+        if (column == UINT16_MAX || row == UINT16_MAX) {
+            return SCREEN_UNDEFINED;
+        }
+
+        return screens.cells[column * (screens.rows - 1) + row];
+    }
+
+    for (uint8_t i = 0; i < screens.count; i++) {
+        const screen_data *screen = &screens.screens[i];
+        if (x >= screen->x && x < (int32_t) screen->x + screen->width
+                && y >= screen->y && y < (int32_t) screen->y + screen->height) {
+            return i;
+        }
+    }
+
+    return SCREEN_UNDEFINED;
+}
+
+// Resolve the screen of the position and the position relative to it.
+static inline void set_screen(int16_t x, int16_t y, uint8_t *screen, int16_t *screen_x, int16_t *screen_y) {
+    *screen = find_screen(x, y);
+    if (*screen != SCREEN_UNDEFINED) {
+        *screen_x = (int16_t) (x - screens.screens[*screen].x);
+        *screen_y = (int16_t) (y - screens.screens[*screen].y);
+    } else {
+        *screen_x = x;
+        *screen_y = y;
+    }
+
+    USDT_PROBE5(screen_adjust, x, y, *screen, *screen_x, *screen_y);
+}
+
+void set_key_state(uint16_t keycode, bool pressed) {
+    if (keycode < sizeof(input.snapshot.keys) * 8) {
+        if (pressed) {
+            input.snapshot.keys[keycode / 8] |= (uint8_t) (1 << (keycode % 8));
+        } else {
+            input.snapshot.keys[keycode / 8] &= (uint8_t) ~(1 << (keycode % 8));
+        }
+    }
+}
+
+void set_pointer_position(int16_t x, int16_t y) {
+    input.snapshot.x = x;
+    input.snapshot.y = y;
+}
+
+void set_modifier_mask(uint16_t mask) {
+    input.mask |= mask;
+}
+
+void unset_modifier_mask(uint16_t mask) {
+    input.mask &= ~mask;
+}
+
+uint16_t get_modifiers() {
+    return input.mask;
+}
+
+void dispatch_hook_enabled(uint64_t timestamp) {
+    // Populate the hook start event.
+    event.time = timestamp;
+    event.reserved = 0x00;
+
+    event.type = EVENT_HOOK_ENABLED;
+    event.mask = 0x00;
+    publish_snapshot(timestamp);
+
+    // Fire the hook start event.
+    USDT_PROBE1(hook_start, timestamp);
+    __atomic_store_n(&watchdog.running, true, __ATOMIC_RELEASE);
+    dispatch_event(&event);
+}
+
+void dispatch_hook_disabled(uint64_t timestamp) {
+    // Populate the hook stop event.
+    event.time = timestamp;
+    event.reserved = 0x00;
+
+    event.type = EVENT_HOOK_DISABLED;
+    event.mask = 0x00;
+
+    // Queued events are dispatched before the hook stop event, which is always dispatched inline.
+    if (watchdog.queued) {
+        watchdog_drain();
+    }
+
+    // Fire the hook stop event.
+    USDT_PROBE1(hook_stop, timestamp);
+    dispatch_event(&event);
+
+    // A slow hook stop event must not leave the next hook_run() queued.
+    if (watchdog.queued) {
+        watchdog_drain();
+    }
+    __atomic_store_n(&watchdog.running, false, __ATOMIC_RELEASE);
+}
+
+void dispatch_screen_changed(uint64_t timestamp) {
+    // Populate the screen changed event.
+    event.time = timestamp;
+    event.reserved = 0x00;
+
+    event.type = EVENT_SCREEN_CHANGED;
+    event.mask = get_modifiers();
+
+    // Fire the screen changed event.
+    dispatch_event(&event);
+}
+
+// Keypad keys report their navigation codes while num lock is off.
+static uint16_t translate_keypad(uint16_t scancode) {
+    if ((get_modifiers() & MASK_NUM_LOCK) == 0) {
+        switch (scancode) {
+            case VC_KP_SEPARATOR:
+            case VC_KP_1:
+            case VC_KP_2:
+            case VC_KP_3:
+            case VC_KP_4:
+            case VC_KP_5:
+            case VC_KP_6:
+            case VC_KP_7:
+            case VC_KP_8:
+            case VC_KP_0:
+            case VC_KP_9:
+                scancode |= 0xEE00;
+                break;
+        }
+    }
+
+    return scancode;
+}
+
+void dispatch_key_press(uint64_t timestamp, uint16_t scancode, uint16_t rawcode, const uint16_t *chars, size_t count) {
+    // TODO If you have a better suggestion for this ugly, let me know.
+    if      (scancode == VC_SHIFT_L)   { set_modifier_mask(MASK_SHIFT_L); }
+    else if (scancode == VC_SHIFT_R)   { set_modifier_mask(MASK_SHIFT_R); }
+    else if (scancode == VC_CONTROL_L) { set_modifier_mask(MASK_CTRL_L);  }
+    else if (scancode == VC_CONTROL_R) { set_modifier_mask(MASK_CTRL_R);  }
+    else if (scancode == VC_ALT_L)     { set_modifier_mask(MASK_ALT_L);   }
+    else if (scancode == VC_ALT_R)     { set_modifier_mask(MASK_ALT_R);   }
+    else if (scancode == VC_META_L)    { set_modifier_mask(MASK_META_L);  }
+    else if (scancode == VC_META_R)    { set_modifier_mask(MASK_META_R);  }
+
+    // Populate key pressed event.
+    event.time = timestamp;
+    event.reserved = 0x00;
+
+    event.type = EVENT_KEY_PRESSED;
+    event.mask = get_modifiers();
+    publish_snapshot(timestamp);
+
+    event.data.keyboard.keycode = translate_keypad(scancode);
+    event.data.keyboard.rawcode = rawcode;
+    event.data.keyboard.keychar = CHAR_UNDEFINED;
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Key %#X pressed. (%#X)\n",
+            __FUNCTION__, __LINE__, event.data.keyboard.keycode, event.data.keyboard.rawcode);
+
+    // Fire key pressed event.
+    dispatch_event(&event);
+
+    // If the pressed event was not consumed...
+    if (event.reserved ^ 0x01) {
+        for (size_t i = 0; i < count; i++) {
+            // Populate key typed event.
+            event.time = timestamp;
+            event.reserved = 0x00;
+
+            event.type = EVENT_KEY_TYPED;
+            event.mask = get_modifiers();
+
+            event.data.keyboard.keycode = VC_UNDEFINED;
+            event.data.keyboard.rawcode = rawcode;
+            event.data.keyboard.keychar = chars[i];
+
+            logger(LOG_LEVEL_DEBUG, "%s [%u]: Key %#X typed. (%lc)\n",
+                    __FUNCTION__, __LINE__, event.data.keyboard.keycode, (uint16_t) event.data.keyboard.keychar);
+
+            // Fire key typed event.
+            dispatch_event(&event);
+        }
+    }
+}
+
+void dispatch_key_release(uint64_t timestamp, uint16_t scancode, uint16_t rawcode) {
+    // TODO If you have a better suggestion for this ugly, let me know.
+    if      (scancode == VC_SHIFT_L)   { unset_modifier_mask(MASK_SHIFT_L); }
+    else if (scancode == VC_SHIFT_R)   { unset_modifier_mask(MASK_SHIFT_R); }
+    else if (scancode == VC_CONTROL_L) { unset_modifier_mask(MASK_CTRL_L);  }
+    else if (scancode == VC_CONTROL_R) { unset_modifier_mask(MASK_CTRL_R);  }
+    else if (scancode == VC_ALT_L)     { unset_modifier_mask(MASK_ALT_L);   }
+    else if (scancode == VC_ALT_R)     { unset_modifier_mask(MASK_ALT_R);   }
+    else if (scancode == VC_META_L)    { unset_modifier_mask(MASK_META_L);  }
+    else if (scancode == VC_META_R)    { unset_modifier_mask(MASK_META_R);  }
+
+    // Populate key released event.
+    event.time = timestamp;
+    event.reserved = 0x00;
+
+    event.type = EVENT_KEY_RELEASED;
+    event.mask = get_modifiers();
+    publish_snapshot(timestamp);
+
+    event.data.keyboard.keycode = translate_keypad(scancode);
+    event.data.keyboard.rawcode = rawcode;
+    event.data.keyboard.keychar = CHAR_UNDEFINED;
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Key %#X released. (%#X)\n",
+            __FUNCTION__, __LINE__, event.data.keyboard.keycode, event.data.keyboard.rawcode);
+
+    // Fire key released event.
+    dispatch_event(&event);
+}
+
+// Modifier mask for the first five buttons, other buttons do not have one.
+static uint16_t button_mask(uint16_t button) {
+    switch (button) {
+        case MOUSE_BUTTON1: return MASK_BUTTON1;
+        case MOUSE_BUTTON2: return MASK_BUTTON2;
+        case MOUSE_BUTTON3: return MASK_BUTTON3;
+        case MOUSE_BUTTON4: return MASK_BUTTON4;
+        case MOUSE_BUTTON5: return MASK_BUTTON5;
+        default: return 0x0000;
+    }
+}
+
+void dispatch_mouse_press(uint64_t timestamp, uint16_t button, int16_t x, int16_t y) {
+    set_modifier_mask(button_mask(button));
+
+    // Track the number of clicks, the button must match the previous button.
+    if (button == input.mouse.click.button && (long int) (timestamp - input.mouse.click.time) <= get_multi_click_time()) {
+        if (input.mouse.click.count < USHRT_MAX) {
+            input.mouse.click.count++;
+        } else {
+            logger(LOG_LEVEL_WARN, "%s [%u]: Click count overflow detected!\n",
+                    __FUNCTION__, __LINE__);
+        }
+    } else {
+        // Reset the click count.
+        input.mouse.click.count = 1;
+
+        // Set the previous button.
+        input.mouse.click.button = button;
+    }
+
+    // Save this events time to calculate the input.mouse.click.count.
+    input.mouse.click.time = timestamp;
+
+    // Populate mouse pressed event.
+    event.time = timestamp;
+    event.reserved = 0x00;
+
+    event.type = EVENT_MOUSE_PRESSED;
+    event.mask = get_modifiers();
+    publish_pointer_snapshot(timestamp, x, y);
+
+    event.data.mouse.button = button;
+    event.data.mouse.clicks = input.mouse.click.count;
+    event.data.mouse.x = x;
+    event.data.mouse.y = y;
+    set_screen(x, y, &event.data.mouse.screen, &event.data.mouse.screen_x, &event.data.mouse.screen_y);
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Button %u  pressed %u time(s). (%u, %u)\n",
+            __FUNCTION__, __LINE__, event.data.mouse.button, event.data.mouse.clicks,
+            event.data.mouse.x, event.data.mouse.y);
+
+    // Fire mouse pressed event.
+    dispatch_event(&event);
+}
+
+void dispatch_mouse_release(uint64_t timestamp, uint16_t button, int16_t x, int16_t y) {
+    unset_modifier_mask(button_mask(button));
+
+    // Populate mouse released event.
+    event.time = timestamp;
+    event.reserved = 0x00;
+
+    event.type = EVENT_MOUSE_RELEASED;
+    event.mask = get_modifiers();
+    publish_pointer_snapshot(timestamp, x, y);
+
+    event.data.mouse.button = button;
+    event.data.mouse.clicks = input.mouse.click.count;
+    event.data.mouse.x = x;
+    event.data.mouse.y = y;
+    set_screen(x, y, &event.data.mouse.screen, &event.data.mouse.screen_x, &event.data.mouse.screen_y);
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Button %u released %u time(s). (%u, %u)\n",
+            __FUNCTION__, __LINE__, event.data.mouse.button,
+            event.data.mouse.clicks,
+            event.data.mouse.x, event.data.mouse.y);
+
+    // Fire mouse released event.
+    dispatch_event(&event);
+
+    // If the pressed event was not consumed...
+    if (event.reserved ^ 0x01 && input.mouse.is_dragged != true) {
+        // Populate mouse clicked event.
+        event.time = timestamp;
+        event.reserved = 0x00;
+
+        event.type = EVENT_MOUSE_CLICKED;
+        event.mask = get_modifiers();
+
+        event.data.mouse.button = button;
+        event.data.mouse.clicks = input.mouse.click.count;
+        event.data.mouse.x = x;
+        event.data.mouse.y = y;
+        set_screen(x, y, &event.data.mouse.screen, &event.data.mouse.screen_x, &event.data.mouse.screen_y);
+
+        logger(LOG_LEVEL_DEBUG, "%s [%u]: Button %u clicked %u time(s). (%u, %u)\n",
+                __FUNCTION__, __LINE__, event.data.mouse.button,
+                event.data.mouse.clicks,
+                event.data.mouse.x, event.data.mouse.y);
+
+        // Fire mouse clicked event.
+        dispatch_event(&event);
+    }
+
+    // Reset the number of clicks.
+    if (button == input.mouse.click.button && (long int) (event.time - input.mouse.click.time) > get_multi_click_time()) {
+        // Reset the click count.
+        input.mouse.click.count = 0;
+    }
+}
+
+void dispatch_mouse_move(uint64_t timestamp, int16_t x, int16_t y) {
+    // Reset the click count.
+    if (input.mouse.click.count != 0 && (long int) (timestamp - input.mouse.click.time) > get_multi_click_time()) {
+        input.mouse.click.count = 0;
+    }
+
+    // Populate mouse move event.
+    event.time = timestamp;
+    event.reserved = 0x00;
+
+    event.mask = get_modifiers();
+    publish_pointer_snapshot(timestamp, x, y);
+
+    // Check the upper half of virtual modifiers for non-zero values and set the mouse
+    // dragged flag.  The last 3 bits are reserved for lock masks.
+    input.mouse.is_dragged = ((event.mask & 0x1F00) > 0);
+    if (input.mouse.is_dragged) {
+        // Create Mouse Dragged event.
+        event.type = EVENT_MOUSE_DRAGGED;
+    } else {
+        // Create a Mouse Moved event.
+        event.type = EVENT_MOUSE_MOVED;
+    }
+
+    event.data.mouse.button = MOUSE_NOBUTTON;
+    event.data.mouse.clicks = input.mouse.click.count;
+    event.data.mouse.x = x;
+    event.data.mouse.y = y;
+    set_screen(x, y, &event.data.mouse.screen, &event.data.mouse.screen_x, &event.data.mouse.screen_y);
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Mouse %s to %i, %i. (%#X)\n",
+            __FUNCTION__, __LINE__, input.mouse.is_dragged ? "dragged" : "moved",
+            event.data.mouse.x, event.data.mouse.y, event.mask);
+
+    // Fire mouse move event.
+    dispatch_event(&event);
+}
+
+void dispatch_mouse_wheel(uint64_t timestamp, int16_t x, int16_t y, uint8_t type, uint16_t amount, int16_t rotation, uint8_t direction) {
+    // Reset the click count and previous button.
+    input.mouse.click.count = 1;
+    input.mouse.click.button = MOUSE_NOBUTTON;
+
+    // Populate mouse wheel event.
+    event.time = timestamp;
+    event.reserved = 0x00;
+
+    event.type = EVENT_MOUSE_WHEEL;
+    event.mask = get_modifiers();
+    publish_pointer_snapshot(timestamp, x, y);
+
+    event.data.wheel.clicks = input.mouse.click.count;
+    event.data.wheel.x = x;
+    event.data.wheel.y = y;
+    event.data.wheel.type = type;
+    event.data.wheel.amount = amount;
+    event.data.wheel.rotation = rotation;
+    event.data.wheel.direction = direction;
+    set_screen(x, y, &event.data.wheel.screen, &event.data.wheel.screen_x, &event.data.wheel.screen_y);
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Mouse wheel type %u, rotated %i units in the %u direction at %u, %u.\n",
+            __FUNCTION__, __LINE__, event.data.wheel.type,
+            event.data.wheel.amount * event.data.wheel.rotation,
+            event.data.wheel.direction,
+            event.data.wheel.x, event.data.wheel.y);
+
+    // Fire mouse wheel event.
+    dispatch_event(&event);
+}
@@ -0,0 +1,101 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _included_dispatch_event
+#define _included_dispatch_event
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <uiohook.h>
+
+/* Input sources translate native input into virtual key codes, buttons and
+ * coordinates and pass it to these functions.  Modifier tracking, click
+ * counting, drag detection and EVENT_KEY_TYPED / EVENT_MOUSE_CLICKED
+ * generation are shared by every source.
+ */
+
+/* Reset the modifier mask and mouse state before a source starts producing
+ * events.  Clicks are counted with the time set by
+ * dispatch_set_multi_click_time().
+ */
+extern void dispatch_reset(uint16_t mask);
+
+/* Set the multi-click time in milliseconds used to count clicks, 200 until
+ * first set.  Live sources pass the desktop setting and keep it current, a
+ * replayed recording passes the recorded value.  Safe to call from any thread.
+ */
+extern void dispatch_set_multi_click_time(long int time);
+
+/* Track a native key code, such as an X11 KeyCode, as held or released in the
+ * input snapshot.  Codes above 255 are ignored.  Call before the matching
+ * dispatch_key_press() or dispatch_key_release().
+ */
+extern void set_key_state(uint16_t keycode, bool pressed);
+
+// Set the pointer position in the input snapshot before the first mouse event.
+extern void set_pointer_position(int16_t x, int16_t y);
+
+// Set the virtual modifier mask for future events.
+extern void set_modifier_mask(uint16_t mask);
+
+// Unset the virtual modifier mask for future events.
+extern void unset_modifier_mask(uint16_t mask);
+
+// Get the current virtual modifier mask state.
+extern uint16_t get_modifiers();
+
+extern void dispatch_hook_enabled(uint64_t timestamp);
+
+extern void dispatch_hook_disabled(uint64_t timestamp);
+
+/* Replace the screen layout used to resolve the screen and relative position
+ * of each mouse event.  The layout must use the same coordinates the source
+ * passes to the mouse dispatch functions.  Call from the hook thread.
+ */
+extern void dispatch_set_screens(const screen_data *layout, uint8_t count);
+
+/* Dispatch EVENT_SCREEN_CHANGED.  Sources call this from the hook thread
+ * before the next input event once the screen layout has changed.
+ */
+extern void dispatch_screen_changed(uint64_t timestamp);
+
+// Replace the device list reported by hook_get_devices() and used to classify events.
+extern void dispatch_set_devices(const device_info *list, uint8_t count);
+
+// Set the source device of the input events that follow, DEVICE_UNDEFINED if unknown.
+extern void dispatch_set_source(uint8_t device);
+
+/* Dispatch a key press followed by one EVENT_KEY_TYPED for each of the count
+ * characters, unless the press is consumed.
+ */
+extern void dispatch_key_press(uint64_t timestamp, uint16_t scancode, uint16_t rawcode, const uint16_t *chars, size_t count);
+
+extern void dispatch_key_release(uint64_t timestamp, uint16_t scancode, uint16_t rawcode);
+
+extern void dispatch_mouse_press(uint64_t timestamp, uint16_t button, int16_t x, int16_t y);
+
+// Dispatch a button release followed by EVENT_MOUSE_CLICKED if the pointer was not dragged.
+extern void dispatch_mouse_release(uint64_t timestamp, uint16_t button, int16_t x, int16_t y);
+
+// Dispatch EVENT_MOUSE_MOVED, or EVENT_MOUSE_DRAGGED while a button is held.
+extern void dispatch_mouse_move(uint64_t timestamp, int16_t x, int16_t y);
+
+extern void dispatch_mouse_wheel(uint64_t timestamp, int16_t x, int16_t y, uint8_t type, uint16_t amount, int16_t rotation, uint8_t direction);
+
+#endif
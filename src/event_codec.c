@@ -0,0 +1,397 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <uiohook.h>
+
+/* Each event is encoded as a tag byte followed by varint fields.  The low
+ * nibble of the tag holds the event type, the high nibble flags fields that
+ * differ from the codec state.  Time is always a zig-zag delta from the
+ * previous event and pointer coordinates are zig-zag deltas from the previous
+ * pointer position, so typical motion events take five bytes.
+ *
+ *    all events:       tag [mask] [reserved [device class]] time
+ *    key events:       [keycode rawcode] [keychar]
+ *    button events:    button clicks x y screen [origin]
+ *    motion events:    [button clicks] x y screen [origin]
+ *    wheel events:     clicks x y type amount rotation direction screen [origin]
+ *
+ * The screen index is shifted left by one with the low bit set when the screen
+ * origin, the position minus the relative position, differs from the last
+ * event and follows as two zig-zag values.  Likewise the reserved field is
+ * shifted left by one with the low bit set when the source device differs
+ * from the last event, followed by the device id and class bytes.
+ */
+#define TAG_TYPE_MASK       0x0F
+#define TAG_MASK            0x10    // Modifier mask changed.
+#define TAG_RESERVED        0x20    // Reserved field is not zero or the source device changed.
+#define TAG_CODES           0x40    // Key codes, or motion button and clicks, differ from the last event.
+#define TAG_KEY_CHAR        0x80    // Key event carries a character.
+
+static inline uint64_t zigzag_encode(int64_t value) {
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+static inline int64_t zigzag_decode(uint64_t value) {
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+static inline uint8_t *write_varint(uint8_t *buffer, uint64_t value) {
+    while (value >= 0x80) {
+        *buffer++ = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+    *buffer++ = (uint8_t) value;
+
+    return buffer;
+}
+
+static inline bool read_varint(const uint8_t **buffer, const uint8_t *end, uint64_t *value) {
+    const uint8_t *p = *buffer;
+
+    // Single byte values are by far the most common.
+    if (p < end && *p < 0x80) {
+        *value = *p;
+        *buffer = p + 1;
+        return true;
+    }
+
+    uint64_t result = 0;
+    for (unsigned int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        result |= (uint64_t) (byte & 0x7F) << shift;
+
+        if (byte < 0x80) {
+            *value = result;
+            *buffer = p;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static inline uint8_t *write_position(event_codec *codec, uint8_t *buffer, int16_t x, int16_t y) {
+    buffer = write_varint(buffer, zigzag_encode((int64_t) x - codec->x));
+    buffer = write_varint(buffer, zigzag_encode((int64_t) y - codec->y));
+    codec->x = x;
+    codec->y = y;
+
+    return buffer;
+}
+
+static inline bool read_position(event_codec *codec, const uint8_t **buffer, const uint8_t *end, int16_t *x, int16_t *y) {
+    uint64_t dx, dy;
+    if (!read_varint(buffer, end, &dx) || !read_varint(buffer, end, &dy)) {
+        return false;
+    }
+
+    codec->x = *x = (int16_t) (codec->x + zigzag_decode(dx));
+    codec->y = *y = (int16_t) (codec->y + zigzag_decode(dy));
+
+    return true;
+}
+
+static inline uint8_t *write_screen(event_codec *codec, uint8_t *buffer, int16_t x, int16_t y, uint8_t screen, int16_t screen_x, int16_t screen_y) {
+    int16_t origin_x = (int16_t) (x - screen_x);
+    int16_t origin_y = (int16_t) (y - screen_y);
+
+    bool moved = origin_x != codec->screen_x || origin_y != codec->screen_y;
+    buffer = write_varint(buffer, ((uint64_t) screen << 1) | (moved ? 0x01 : 0x00));
+    if (moved) {
+        buffer = write_varint(buffer, zigzag_encode(origin_x));
+        buffer = write_varint(buffer, zigzag_encode(origin_y));
+        codec->screen_x = origin_x;
+        codec->screen_y = origin_y;
+    }
+
+    return buffer;
+}
+
+static inline bool read_screen(event_codec *codec, const uint8_t **buffer, const uint8_t *end, int16_t x, int16_t y, uint8_t *screen, int16_t *screen_x, int16_t *screen_y) {
+    uint64_t value;
+    if (!read_varint(buffer, end, &value)) {
+        return false;
+    }
+
+    if (value & 0x01) {
+        uint64_t origin_x, origin_y;
+        if (!read_varint(buffer, end, &origin_x) || !read_varint(buffer, end, &origin_y)) {
+            return false;
+        }
+
+        codec->screen_x = (int16_t) zigzag_decode(origin_x);
+        codec->screen_y = (int16_t) zigzag_decode(origin_y);
+    }
+
+    *screen = (uint8_t) (value >> 1);
+    *screen_x = (int16_t) (x - codec->screen_x);
+    *screen_y = (int16_t) (y - codec->screen_y);
+
+    return true;
+}
+
+UIOHOOK_API void hook_codec_reset(event_codec *codec) {
+    memset(codec, 0, sizeof(event_codec));
+}
+
+UIOHOOK_API size_t hook_codec_encode(event_codec *codec, const uiohook_event *event, uint8_t *buffer) {
+    uint8_t *p = buffer + 1;
+    uint8_t tag = (uint8_t) (event->type & TAG_TYPE_MASK);
+
+    if (event->mask != codec->mask) {
+        tag |= TAG_MASK;
+        p = write_varint(p, event->mask);
+        codec->mask = event->mask;
+    }
+
+    bool device_changed = event->device != codec->device || event->device_class != codec->device_class;
+    if (event->reserved != 0 || device_changed) {
+        tag |= TAG_RESERVED;
+        p = write_varint(p, (uint64_t) event->reserved << 1 | device_changed);
+
+        if (device_changed) {
+            *p++ = event->device;
+            *p++ = event->device_class;
+            codec->device = event->device;
+            codec->device_class = event->device_class;
+        }
+    }
+
+    p = write_varint(p, zigzag_encode((int64_t) (event->time - codec->time)));
+    codec->time = event->time;
+
+    switch (event->type) {
+        case EVENT_KEY_TYPED:
+        case EVENT_KEY_PRESSED:
+        case EVENT_KEY_RELEASED:
+            // Presses and releases of the same key share their codes.
+            if (event->data.keyboard.keycode != codec->keycode || event->data.keyboard.rawcode != codec->rawcode) {
+                tag |= TAG_CODES;
+                p = write_varint(p, event->data.keyboard.keycode);
+                p = write_varint(p, event->data.keyboard.rawcode);
+                codec->keycode = event->data.keyboard.keycode;
+                codec->rawcode = event->data.keyboard.rawcode;
+            }
+
+            if (event->data.keyboard.keychar != CHAR_UNDEFINED) {
+                tag |= TAG_KEY_CHAR;
+                p = write_varint(p, event->data.keyboard.keychar);
+            }
+            break;
+
+        case EVENT_MOUSE_CLICKED:
+        case EVENT_MOUSE_PRESSED:
+        case EVENT_MOUSE_RELEASED:
+            p = write_varint(p, event->data.mouse.button);
+            p = write_varint(p, event->data.mouse.clicks);
+            p = write_position(codec, p, event->data.mouse.x, event->data.mouse.y);
+            p = write_screen(codec, p, event->data.mouse.x, event->data.mouse.y,
+                    event->data.mouse.screen, event->data.mouse.screen_x, event->data.mouse.screen_y);
+            break;
+
+        case EVENT_MOUSE_MOVED:
+        case EVENT_MOUSE_DRAGGED:
+            if (event->data.mouse.button != codec->button || event->data.mouse.clicks != codec->clicks) {
+                tag |= TAG_CODES;
+                p = write_varint(p, event->data.mouse.button);
+                p = write_varint(p, event->data.mouse.clicks);
+                codec->button = event->data.mouse.button;
+                codec->clicks = event->data.mouse.clicks;
+            }
+
+            p = write_position(codec, p, event->data.mouse.x, event->data.mouse.y);
+            p = write_screen(codec, p, event->data.mouse.x, event->data.mouse.y,
+                    event->data.mouse.screen, event->data.mouse.screen_x, event->data.mouse.screen_y);
+            break;
+
+        case EVENT_MOUSE_WHEEL:
+            p = write_varint(p, event->data.wheel.clicks);
+            p = write_position(codec, p, event->data.wheel.x, event->data.wheel.y);
+            *p++ = event->data.wheel.type;
+            p = write_varint(p, event->data.wheel.amount);
+            p = write_varint(p, zigzag_encode(event->data.wheel.rotation));
+            *p++ = event->data.wheel.direction;
+            p = write_screen(codec, p, event->data.wheel.x, event->data.wheel.y,
+                    event->data.wheel.screen, event->data.wheel.screen_x, event->data.wheel.screen_y);
+            break;
+
+        default:
+            break;
+    }
+
+    buffer[0] = tag;
+
+    return (size_t) (p - buffer);
+}
+
+// Decode into codec, which is left in an undefined state if 0 is returned.
+static size_t decode_event(event_codec *codec, const uint8_t *buffer, size_t size, uiohook_event *event) {
+    const uint8_t *p = buffer, *end = buffer + size;
+    if (p >= end) {
+        return 0;
+    }
+
+    uint8_t tag = *p++;
+    uint64_t value;
+
+    event->type = (event_type) (tag & TAG_TYPE_MASK);
+
+    if (tag & TAG_MASK) {
+        if (!read_varint(&p, end, &value)) {
+            return 0;
+        }
+        codec->mask = (uint16_t) value;
+    }
+    event->mask = codec->mask;
+
+    event->reserved = 0x00;
+    if (tag & TAG_RESERVED) {
+        if (!read_varint(&p, end, &value)) {
+            return 0;
+        }
+        event->reserved = (uint16_t) (value >> 1);
+
+        if (value & 0x01) {
+            if (end - p < 2) {
+                return 0;
+            }
+            codec->device = *p++;
+            codec->device_class = *p++;
+        }
+    }
+    event->device = codec->device;
+    event->device_class = codec->device_class;
+
+    if (!read_varint(&p, end, &value)) {
+        return 0;
+    }
+    codec->time += (uint64_t) zigzag_decode(value);
+    event->time = codec->time;
+
+    switch (event->type) {
+        case EVENT_KEY_TYPED:
+        case EVENT_KEY_PRESSED:
+        case EVENT_KEY_RELEASED:
+            if (tag & TAG_CODES) {
+                uint64_t rawcode;
+                if (!read_varint(&p, end, &value) || !read_varint(&p, end, &rawcode)) {
+                    return 0;
+                }
+                codec->keycode = (uint16_t) value;
+                codec->rawcode = (uint16_t) rawcode;
+            }
+            event->data.keyboard.keycode = codec->keycode;
+            event->data.keyboard.rawcode = codec->rawcode;
+
+            event->data.keyboard.keychar = CHAR_UNDEFINED;
+            if (tag & TAG_KEY_CHAR) {
+                if (!read_varint(&p, end, &value)) {
+                    return 0;
+                }
+                event->data.keyboard.keychar = (uint16_t) value;
+            }
+            break;
+
+        case EVENT_MOUSE_CLICKED:
+        case EVENT_MOUSE_PRESSED:
+        case EVENT_MOUSE_RELEASED:
+            {
+                uint64_t clicks;
+                if (!read_varint(&p, end, &value) || !read_varint(&p, end, &clicks)
+                        || !read_position(codec, &p, end, &event->data.mouse.x, &event->data.mouse.y)
+                        || !read_screen(codec, &p, end, event->data.mouse.x, event->data.mouse.y,
+                                &event->data.mouse.screen, &event->data.mouse.screen_x, &event->data.mouse.screen_y)) {
+                    return 0;
+                }
+                event->data.mouse.button = (uint16_t) value;
+                event->data.mouse.clicks = (uint16_t) clicks;
+            }
+            break;
+
+        case EVENT_MOUSE_MOVED:
+        case EVENT_MOUSE_DRAGGED:
+            if (tag & TAG_CODES) {
+                uint64_t clicks;
+                if (!read_varint(&p, end, &value) || !read_varint(&p, end, &clicks)) {
+                    return 0;
+                }
+                codec->button = (uint16_t) value;
+                codec->clicks = (uint16_t) clicks;
+            }
+            event->data.mouse.button = codec->button;
+            event->data.mouse.clicks = codec->clicks;
+
+            if (!read_position(codec, &p, end, &event->data.mouse.x, &event->data.mouse.y)
+                    || !read_screen(codec, &p, end, event->data.mouse.x, event->data.mouse.y,
+                            &event->data.mouse.screen, &event->data.mouse.screen_x, &event->data.mouse.screen_y)) {
+                return 0;
+            }
+            break;
+
+        case EVENT_MOUSE_WHEEL:
+            {
+                uint64_t amount, rotation;
+                if (!read_varint(&p, end, &value)
+                        || !read_position(codec, &p, end, &event->data.wheel.x, &event->data.wheel.y)
+                        || p >= end) {
+                    return 0;
+                }
+                event->data.wheel.clicks = (uint16_t) value;
+                event->data.wheel.type = *p++;
+
+                if (!read_varint(&p, end, &amount) || !read_varint(&p, end, &rotation) || p >= end) {
+                    return 0;
+                }
+                event->data.wheel.amount = (uint16_t) amount;
+                event->data.wheel.rotation = (int16_t) zigzag_decode(rotation);
+                event->data.wheel.direction = *p++;
+
+                if (!read_screen(codec, &p, end, event->data.wheel.x, event->data.wheel.y,
+                        &event->data.wheel.screen, &event->data.wheel.screen_x, &event->data.wheel.screen_y)) {
+                    return 0;
+                }
+            }
+            break;
+
+        case EVENT_HOOK_ENABLED:
+        case EVENT_HOOK_DISABLED:
+        case EVENT_SCREEN_CHANGED:
+            break;
+
+        default:
+            return 0;
+    }
+
+    return (size_t) (p - buffer);
+}
+
+UIOHOOK_API size_t hook_codec_decode(event_codec *codec, const uint8_t *buffer, size_t size, uiohook_event *event) {
+    // The state only advances once a complete event was read, so a truncated event can be retried.
+    event_codec next = *codec;
+
+    size_t length = decode_event(&next, buffer, size, event);
+    if (length > 0) {
+        *codec = next;
+    }
+
+    return length;
+}
@@ -0,0 +1,127 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _included_seqlock
+#define _included_seqlock
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Sequence lock for small snapshots that are written rarely and read often.
+ * Readers never block the writer, they copy the data and retry if a write
+ * happened in the meantime.  Writers must be serialized by the caller.
+ */
+typedef struct _seqlock {
+    uint32_t sequence;
+} seqlock;
+
+#define SEQLOCK_INITIALIZER { 0 }
+
+// True if both pointers can be copied a machine word at a time.
+static inline bool seqlock_is_aligned(const void *dest, const void *src) {
+    return ((uintptr_t) dest | (uintptr_t) src) % sizeof(unsigned long) == 0;
+}
+
+// Copy size bytes with relaxed atomic loads so a concurrent write is not a data race.
+static inline void seqlock_copy_from(void *dest, const void *src, size_t size) {
+    size_t i = 0;
+    if (seqlock_is_aligned(dest, src)) {
+        unsigned long *d = (unsigned long *) dest;
+        const unsigned long *s = (const unsigned long *) src;
+        for (; i < size / sizeof(unsigned long); i++) {
+            d[i] = __atomic_load_n(&s[i], __ATOMIC_RELAXED);
+        }
+        i *= sizeof(unsigned long);
+    }
+
+    unsigned char *d = (unsigned char *) dest;
+    const unsigned char *s = (const unsigned char *) src;
+    for (; i < size; i++) {
+        d[i] = __atomic_load_n(&s[i], __ATOMIC_RELAXED);
+    }
+}
+
+// Copy size bytes with relaxed atomic stores so a concurrent read is not a data race.
+static inline void seqlock_copy_to(void *dest, const void *src, size_t size) {
+    size_t i = 0;
+    if (seqlock_is_aligned(dest, src)) {
+        unsigned long *d = (unsigned long *) dest;
+        const unsigned long *s = (const unsigned long *) src;
+        for (; i < size / sizeof(unsigned long); i++) {
+            __atomic_store_n(&d[i], s[i], __ATOMIC_RELAXED);
+        }
+        i *= sizeof(unsigned long);
+    }
+
+    unsigned char *d = (unsigned char *) dest;
+    const unsigned char *s = (const unsigned char *) src;
+    for (; i < size; i++) {
+        __atomic_store_n(&d[i], s[i], __ATOMIC_RELAXED);
+    }
+}
+
+// Wait for any write in progress and return the sequence to pass to seqlock_read_retry().
+static inline uint32_t seqlock_read_begin(const seqlock *lock) {
+    uint32_t sequence;
+
+    // An odd sequence means a write is in progress.
+    while ((sequence = __atomic_load_n(&lock->sequence, __ATOMIC_ACQUIRE)) & 0x01);
+
+    return sequence;
+}
+
+// True if a write happened since seqlock_read_begin() and the data read must be discarded.
+static inline bool seqlock_read_retry(const seqlock *lock, uint32_t sequence) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    return __atomic_load_n(&lock->sequence, __ATOMIC_RELAXED) != sequence;
+}
+
+// Copy the protected data at src into dest, retrying until a consistent copy is made.
+static inline void seqlock_read(const seqlock *lock, void *dest, const void *src, size_t size) {
+    uint32_t sequence;
+    do {
+        sequence = seqlock_read_begin(lock);
+        seqlock_copy_from(dest, src, size);
+    } while (seqlock_read_retry(lock, sequence));
+}
+
+// Mark the start of a write, readers retry until seqlock_write_end() is called.
+static inline void seqlock_write_begin(seqlock *lock) {
+    uint32_t sequence = __atomic_load_n(&lock->sequence, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&lock->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+// Mark the end of a write started with seqlock_write_begin().
+static inline void seqlock_write_end(seqlock *lock) {
+    uint32_t sequence = __atomic_load_n(&lock->sequence, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&lock->sequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+// Publish size bytes from src into the protected data at dest.
+static inline void seqlock_write(seqlock *lock, void *dest, const void *src, size_t size) {
+    seqlock_write_begin(lock);
+    seqlock_copy_to(dest, src, size);
+    seqlock_write_end(lock);
+}
+
+#endif
@@ -0,0 +1,308 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <uiohook.h>
+
+#include "logger.h"
+
+#ifdef USE_TRACE
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "seqlock.h"
+#include "trace.h"
+
+// Spans kept per thread when trace_options.buffer_size is 0.
+#define TRACE_DEFAULT_BUFFER_SIZE 4096
+
+typedef struct _trace_span {
+    uint64_t begin;
+    uint32_t duration;              // Nanoseconds, saturated.
+    uint16_t code;
+    uint8_t stage;
+    uint8_t padding;
+} trace_span;
+
+/* Flight recorder for a single thread.  Only the owning thread writes spans,
+ * the oldest span is overwritten once the ring buffer is full.  Rings are
+ * never freed so a dump can still read the spans of a thread that exited.
+ */
+typedef struct _trace_ring {
+    struct _trace_ring *next;
+    uint32_t generation;            // Tracing session the spans belong to, changed under trace_mutex.
+    long tid;
+    uint64_t capacity;
+    uint64_t claimed;               // Spans started, claimed - capacity is the oldest intact span.
+    uint64_t head;                  // Spans written, the next span goes to head & (capacity - 1).
+    trace_span spans[];
+} trace_ring;
+
+static const char *stage_names[] = { "receipt", "translate", "dispatch", "post" };
+
+static pthread_mutex_t trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static trace_ring *rings = NULL;
+static uint64_t capacity = TRACE_DEFAULT_BUFFER_SIZE;
+static uint32_t generation = 0;
+static bool enabled = false;
+
+static __thread trace_ring *local_ring = NULL;
+
+
+static uint64_t get_monotonic_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+static long get_thread_id() {
+    #ifdef __linux__
+    return (long) syscall(SYS_gettid);
+    #else
+    static long next_id = 1;
+    return __atomic_fetch_add(&next_id, 1, __ATOMIC_RELAXED);
+    #endif
+}
+
+// Reuse or replace the ring of the calling thread for the current tracing session.
+static trace_ring * acquire_ring() {
+    pthread_mutex_lock(&trace_mutex);
+
+    trace_ring *ring = local_ring;
+    if (ring != NULL && ring->capacity == capacity) {
+        __atomic_store_n(&ring->claimed, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&ring->head, 0, __ATOMIC_RELAXED);
+        ring->generation = generation;
+    } else {
+        // A ring of a different size stays in the list with a stale generation.
+        ring = (trace_ring *) calloc(1, sizeof(trace_ring) + sizeof(trace_span) * capacity);
+        if (ring != NULL) {
+            ring->generation = generation;
+            ring->tid = local_ring != NULL ? local_ring->tid : get_thread_id();
+            ring->capacity = capacity;
+            ring->next = rings;
+            rings = ring;
+        } else {
+            logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to allocate memory for trace ring buffer!\n",
+                    __FUNCTION__, __LINE__);
+        }
+    }
+
+    if (ring != NULL) {
+        local_ring = ring;
+    }
+
+    pthread_mutex_unlock(&trace_mutex);
+
+    return ring;
+}
+
+uint64_t trace_begin() {
+    if (!__atomic_load_n(&enabled, __ATOMIC_RELAXED)) {
+        return 0;
+    }
+
+    return get_monotonic_ns();
+}
+
+void trace_end(trace_stage stage, uint16_t code, uint64_t begin) {
+    uint64_t duration = get_monotonic_ns() - begin;
+
+    trace_ring *ring = local_ring;
+    if (ring == NULL || ring->generation != __atomic_load_n(&generation, __ATOMIC_ACQUIRE)) {
+        ring = acquire_ring();
+        if (ring == NULL) {
+            return;
+        }
+    }
+
+    trace_span span = {
+        .begin = begin,
+        .duration = duration < UINT32_MAX ? (uint32_t) duration : UINT32_MAX,
+        .code = code,
+        .stage = (uint8_t) stage
+    };
+
+    // Claim the slot before overwriting it so a concurrent dump can discard the old span.
+    uint64_t head = ring->head;
+    __atomic_store_n(&ring->claimed, head + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    seqlock_copy_to(&ring->spans[head & (ring->capacity - 1)], &span, sizeof(trace_span));
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+UIOHOOK_API int hook_trace_start(const trace_options *options) {
+    size_t buffer_size = TRACE_DEFAULT_BUFFER_SIZE;
+    if (options != NULL && options->buffer_size > 0) {
+        buffer_size = options->buffer_size;
+    }
+
+    pthread_mutex_lock(&trace_mutex);
+    if (enabled) {
+        pthread_mutex_unlock(&trace_mutex);
+
+        logger(LOG_LEVEL_WARN, "%s [%u]: Tracing is already enabled!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+
+    // Round up to a power of two so the ring index is a mask.
+    capacity = 2;
+    while (capacity < buffer_size) {
+        capacity <<= 1;
+    }
+
+    // Spans of the previous session are discarded by each thread on its next span.
+    __atomic_store_n(&generation, generation + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&enabled, true, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&trace_mutex);
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Tracing with a %llu span ring buffer per thread.\n",
+            __FUNCTION__, __LINE__, (unsigned long long) capacity);
+
+    return UIOHOOK_SUCCESS;
+}
+
+UIOHOOK_API int hook_trace_stop() {
+    pthread_mutex_lock(&trace_mutex);
+    bool was_enabled = enabled;
+    __atomic_store_n(&enabled, false, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&trace_mutex);
+
+    if (!was_enabled) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: Tracing is not enabled!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+
+    return UIOHOOK_SUCCESS;
+}
+
+UIOHOOK_API int hook_trace_dump(const char *path, trace_stats *stats) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to open trace: %s! (%d)\n",
+                __FUNCTION__, __LINE__, path, errno);
+        return UIOHOOK_FAILURE;
+    }
+
+    int status = UIOHOOK_SUCCESS;
+    uint64_t recorded = 0, dropped = 0, written = 0;
+    long pid = (long) getpid();
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    pthread_mutex_lock(&trace_mutex);
+    trace_span *spans = (trace_span *) malloc(sizeof(trace_span) * capacity);
+    if (spans == NULL) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to allocate memory for trace spans!\n",
+                __FUNCTION__, __LINE__);
+        status = UIOHOOK_ERROR_OUT_OF_MEMORY;
+    }
+
+    for (trace_ring *ring = rings; ring != NULL && spans != NULL; ring = ring->next) {
+        if (ring->generation != generation) {
+            continue;
+        }
+
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint64_t first = head > ring->capacity ? head - ring->capacity : 0;
+        for (uint64_t i = first; i < head; i++) {
+            seqlock_copy_from(&spans[i - first], &ring->spans[i & (ring->capacity - 1)], sizeof(trace_span));
+        }
+
+        // Spans the owning thread overwrote while they were copied are discarded.
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint64_t claimed = __atomic_load_n(&ring->claimed, __ATOMIC_RELAXED);
+        uint64_t valid = claimed > ring->capacity ? claimed - ring->capacity : 0;
+        if (valid < first) {
+            valid = first;
+        }
+
+        for (uint64_t i = valid; i < head; i++) {
+            const trace_span *span = &spans[i - first];
+            fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"uiohook\",\"ph\":\"X\",\"ts\":%llu.%03u,\"dur\":%u.%03u,"
+                    "\"pid\":%ld,\"tid\":%ld,\"args\":{\"code\":%u}}",
+                    written > 0 ? ",\n" : "",
+                    stage_names[span->stage],
+                    (unsigned long long) (span->begin / 1000), (unsigned int) (span->begin % 1000),
+                    span->duration / 1000, span->duration % 1000,
+                    pid, ring->tid, span->code);
+            written++;
+        }
+
+        recorded += head;
+        dropped += valid;
+    }
+    pthread_mutex_unlock(&trace_mutex);
+
+    free(spans);
+
+    fprintf(file, "\n]}\n");
+    if (fclose(file) != 0 && status == UIOHOOK_SUCCESS) {
+        status = UIOHOOK_FAILURE;
+    }
+
+    if (stats != NULL) {
+        stats->recorded = recorded;
+        stats->dropped = dropped;
+        stats->written = written;
+    }
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Wrote %llu spans to %s.\n",
+            __FUNCTION__, __LINE__, (unsigned long long) written, path);
+
+    return status;
+}
+#else
+UIOHOOK_API int hook_trace_start(const trace_options *options) {
+    (void) options;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Tracing requires USE_TRACE!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
+
+UIOHOOK_API int hook_trace_stop() {
+    logger(LOG_LEVEL_WARN, "%s [%u]: Tracing requires USE_TRACE!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
+
+UIOHOOK_API int hook_trace_dump(const char *path, trace_stats *stats) {
+    (void) path;
+    (void) stats;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Tracing requires USE_TRACE!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
+#endif
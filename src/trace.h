@@ -0,0 +1,54 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _included_trace
+#define _included_trace
+
+#include <stdint.h>
+
+// Stages of the hook and post paths, each recorded as a span named after the stage.
+typedef enum _trace_stage {
+    TRACE_STAGE_RECEIPT = 0,        // Native event received, code is the native event type.
+    TRACE_STAGE_TRANSLATE,          // Native key translated, code is the native key code.
+    TRACE_STAGE_DISPATCH,           // Dispatch procedure called, code is the event type.
+    TRACE_STAGE_POST                // Event injected by hook_post_event(), code is the event type.
+} trace_stage;
+
+/* Spans are built with USE_TRACE and compile to nothing without it.  A span
+ * is only recorded if tracing was enabled with hook_trace_start() when it
+ * began:
+ *
+ *    TRACE_BEGIN(span);
+ *    ...
+ *    TRACE_END(TRACE_STAGE_DISPATCH, event->type, span);
+ */
+#ifdef USE_TRACE
+#define TRACE_BEGIN(name) uint64_t name = trace_begin()
+#define TRACE_END(stage, code, name) do { if (name != 0) { trace_end(stage, code, name); } } while (0)
+
+// Start time of a span in nanoseconds, or 0 if tracing is disabled.
+extern uint64_t trace_begin();
+
+// Record a span from begin until now in the ring buffer of the calling thread.
+extern void trace_end(trace_stage stage, uint16_t code, uint64_t begin);
+#else
+#define TRACE_BEGIN(name) do { } while (0)
+#define TRACE_END(stage, code, name) do { } while (0)
+#endif
+
+#endif
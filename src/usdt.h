@@ -0,0 +1,53 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _included_usdt
+#define _included_usdt
+
+/* Static tracepoints for bpftrace and perf, built with USE_USDT.  Each probe is
+ * a single nop in the instruction stream until a tracer attaches, and compiles
+ * to nothing without USE_USDT.  All probes use the uiohook provider:
+ *
+ *    hook_start(timestamp)                          EVENT_HOOK_ENABLED is about to be dispatched
+ *    hook_stop(timestamp)                           EVENT_HOOK_DISABLED is about to be dispatched
+ *    xrecord_reply(category, server_time, length)   XRecord intercept data received, length in 4 byte units
+ *    key_translate(keycode, scancode, keysym)       Native key code translated to a virtual scan code
+ *    screen_adjust(x, y, screen, screen_x, screen_y) Root position resolved to a screen
+ *    dispatch_begin(type, time, device)             Before the dispatch procedure is called
+ *    dispatch_end(type, time, reserved)             After the dispatch procedure returned
+ *    post_begin(type, time)                         hook_post_event() entered
+ *    post_end(type, time)                           hook_post_event() returning
+ *
+ *    bpftrace -e 'usdt:/usr/lib/libuiohook.so:uiohook:dispatch_begin { @start[tid] = nsecs; }
+ *                 usdt:/usr/lib/libuiohook.so:uiohook:dispatch_end { @ns = hist(nsecs - @start[tid]); }'
+ */
+#ifdef USE_USDT
+#include <sys/sdt.h>
+
+#define USDT_PROBE1(name, a) DTRACE_PROBE1(uiohook, name, a)
+#define USDT_PROBE2(name, a, b) DTRACE_PROBE2(uiohook, name, a, b)
+#define USDT_PROBE3(name, a, b, c) DTRACE_PROBE3(uiohook, name, a, b, c)
+#define USDT_PROBE5(name, a, b, c, d, e) DTRACE_PROBE5(uiohook, name, a, b, c, d, e)
+#else
+#define USDT_PROBE1(name, a) do { } while (0)
+#define USDT_PROBE2(name, a, b) do { } while (0)
+#define USDT_PROBE3(name, a, b, c) do { } while (0)
+#define USDT_PROBE5(name, a, b, c, d, e) do { } while (0)
+#endif
+
+#endif
@@ -0,0 +1,440 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <linux/input-event-codes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <uiohook.h>
+
+#include "input_helper.h"
+
+/* This table is derived from the evdev table in src/x11/input_helper.c with
+ * the X11 key code offset of 8 removed, so the first column is indexed by
+ * input event key code and the second column by virtual scan code.
+ */
+static const uint16_t keycode_scancode_table[][2] = {
+    /* idx        { keycode,                scancode                }, */
+    /*   0 */    { VC_UNDEFINED,            0x00                    },
+    /*   1 */    { VC_ESCAPE,               0x01                    },    /* KEY_ESC */
+    /*   2 */    { VC_1,                    0x02                    },    /* KEY_1 */
+    /*   3 */    { VC_2,                    0x03                    },    /* KEY_2 */
+    /*   4 */    { VC_3,                    0x04                    },    /* KEY_3 */
+    /*   5 */    { VC_4,                    0x05                    },    /* KEY_4 */
+    /*   6 */    { VC_5,                    0x06                    },    /* KEY_5 */
+    /*   7 */    { VC_6,                    0x07                    },    /* KEY_6 */
+    /*   8 */    { VC_7,                    0x08                    },    /* KEY_7 */
+    /*   9 */    { VC_8,                    0x09                    },    /* KEY_8 */
+    /*  10 */    { VC_9,                    0x0A                    },    /* KEY_9 */
+    /*  11 */    { VC_0,                    0x0B                    },    /* KEY_0 */
+    /*  12 */    { VC_MINUS,                0x0C                    },    /* KEY_MINUS */
+    /*  13 */    { VC_EQUALS,               0x0D                    },    /* KEY_EQUAL */
+    /*  14 */    { VC_BACKSPACE,            0x0E                    },    /* KEY_BACKSPACE */
+    /*  15 */    { VC_TAB,                  0x0F                    },    /* KEY_TAB */
+    /*  16 */    { VC_Q,                    0x10                    },    /* KEY_Q */
+    /*  17 */    { VC_W,                    0x11                    },    /* KEY_W */
+    /*  18 */    { VC_E,                    0x12                    },    /* KEY_E */
+    /*  19 */    { VC_R,                    0x13                    },    /* KEY_T */
+    /*  20 */    { VC_T,                    0x14                    },    /* KEY_R */
+    /*  21 */    { VC_Y,                    0x15                    },    /* KEY_Y */
+    /*  22 */    { VC_U,                    0x16                    },    /* KEY_U */
+    /*  23 */    { VC_I,                    0x17                    },    /* KEY_I */
+    /*  24 */    { VC_O,                    0x18                    },    /* KEY_O */
+    /*  25 */    { VC_P,                    0x19                    },    /* KEY_P */
+    /*  26 */    { VC_OPEN_BRACKET,         0x1A                    },    /* KEY_LEFTBRACE */
+    /*  27 */    { VC_CLOSE_BRACKET,        0x1B                    },    /* KEY_RIGHTBRACE */
+    /*  28 */    { VC_ENTER,                0x1C                    },    /* KEY_ENTER */
+    /*  29 */    { VC_CONTROL_L,            0x1D                    },    /* KEY_LEFTCTRL */
+    /*  30 */    { VC_A,                    0x1E                    },    /* KEY_A */
+    /*  31 */    { VC_S,                    0x1F                    },    /* KEY_S */
+    /*  32 */    { VC_D,                    0x20                    },    /* KEY_D */
+    /*  33 */    { VC_F,                    0x21                    },    /* KEY_F */
+    /*  34 */    { VC_G,                    0x22                    },    /* KEY_G */
+    /*  35 */    { VC_H,                    0x23                    },    /* KEY_H */
+    /*  36 */    { VC_J,                    0x24                    },    /* KEY_J */
+    /*  37 */    { VC_K,                    0x25                    },    /* KEY_K */
+    /*  38 */    { VC_L,                    0x26                    },    /* KEY_L */
+    /*  39 */    { VC_SEMICOLON,            0x27                    },    /* KEY_SEMICOLON */
+    /*  40 */    { VC_QUOTE,                0x28                    },    /* KEY_APOSTROPHE */
+    /*  41 */    { VC_BACKQUOTE,            0x29                    },    /* KEY_GRAVE */
+    /*  42 */    { VC_SHIFT_L,              0x2A                    },    /* KEY_LEFTSHIFT */
+    /*  43 */    { VC_BACK_SLASH,           0x2B                    },    /* KEY_BACKSLASH */
+    /*  44 */    { VC_Z,                    0x2C                    },    /* KEY_Z */
+    /*  45 */    { VC_X,                    0x2D                    },    /* KEY_X */
+    /*  46 */    { VC_C,                    0x2E                    },    /* KEY_C */
+    /*  47 */    { VC_V,                    0x2F                    },    /* KEY_V */
+    /*  48 */    { VC_B,                    0x30                    },    /* KEY_B */
+    /*  49 */    { VC_N,                    0x31                    },    /* KEY_N */
+    /*  50 */    { VC_M,                    0x32                    },    /* KEY_M */
+    /*  51 */    { VC_COMMA,                0x33                    },    /* KEY_COMMA */
+    /*  52 */    { VC_PERIOD,               0x34                    },    /* KEY_DOT */
+    /*  53 */    { VC_SLASH,                0x35                    },    /* KEY_SLASH */
+    /*  54 */    { VC_SHIFT_R,              0x36                    },    /* KEY_RIGHTSHIFT */
+    /*  55 */    { VC_KP_MULTIPLY,          0x37                    },    /* KEY_KPASTERISK */
+    /*  56 */    { VC_ALT_L,                0x38                    },    /* KEY_LEFTALT */
+    /*  57 */    { VC_SPACE,                0x39                    },    /* KEY_SPACE */
+    /*  58 */    { VC_CAPS_LOCK,            0x3A                    },    /* KEY_CAPSLOCK */
+    /*  59 */    { VC_F1,                   0x3B                    },    /* KEY_F1 */
+    /*  60 */    { VC_F2,                   0x3C                    },    /* KEY_F2 */
+    /*  61 */    { VC_F3,                   0x3D                    },    /* KEY_F3 */
+    /*  62 */    { VC_F4,                   0x3E                    },    /* KEY_F4 */
+    /*  63 */    { VC_F5,                   0x3F                    },    /* KEY_F5 */
+    /*  64 */    { VC_F6,                   0x40                    },    /* KEY_F6 */
+    /*  65 */    { VC_F7,                   0x41                    },    /* KEY_F7 */
+    /*  66 */    { VC_F8,                   0x42                    },    /* KEY_F8 */
+    /*  67 */    { VC_F9,                   0x43                    },    /* KEY_F9 */
+    /*  68 */    { VC_F10,                  0x44                    },    /* KEY_F10 */
+    /*  69 */    { VC_NUM_LOCK,             0x45                    },    /* KEY_NUMLOCK */
+    /*  70 */    { VC_SCROLL_LOCK,          0x46                    },    /* KEY_SCROLLLOCK */
+    /*  71 */    { VC_KP_7,                 0x47                    },    /* KEY_KP7 */
+    /*  72 */    { VC_KP_8,                 0x48                    },    /* KEY_KP8 */
+    /*  73 */    { VC_KP_9,                 0x49                    },    /* KEY_KP9 */
+    /*  74 */    { VC_KP_SUBTRACT,          0x4A                    },    /* KEY_KPMINUS */
+    /*  75 */    { VC_KP_4,                 0x4B                    },    /* KEY_KP4 */
+    /*  76 */    { VC_KP_5,                 0x4C                    },    /* KEY_KP5 */
+    /*  77 */    { VC_KP_6,                 0x4D                    },    /* KEY_KP6 */
+    /*  78 */    { VC_KP_ADD,               0x4E                    },    /* KEY_KPPLUS */
+    /*  79 */    { VC_KP_1,                 0x4F                    },    /* KEY_KP1 */
+    /*  80 */    { VC_KP_2,                 0x50                    },    /* KEY_KP2 */
+    /*  81 */    { VC_KP_3,                 0x51                    },    /* KEY_KP3 */
+    /*  82 */    { VC_KP_0,                 0x52                    },    /* KEY_KP0 */
+    /*  83 */    { VC_KP_SEPARATOR,         0x53                    },    /* KEY_KPDOT */
+    /*  84 */    { VC_UNDEFINED,            0x00                    },
+    /*  85 */    { VC_UNDEFINED,            0x00                    },
+    /*  86 */    { VC_UNDEFINED,            0x00                    },
+    /*  87 */    { VC_F11,                  0x57                    },    /* KEY_F11 */
+    /*  88 */    { VC_F12,                  0x58                    },    /* KEY_F12 */
+    /*  89 */    { VC_UNDEFINED,            0x00                    },
+    /*  90 */    { VC_KATAKANA,             0x00                    },
+    /*  91 */    { VC_HIRAGANA,             0xB7                    },    /* KEY_F13 */
+    /*  92 */    { VC_KANJI,                0xB8                    },    /* KEY_F14 */
+    /*  93 */    { VC_UNDEFINED,            0xB9                    },    /* KEY_F15 */
+    /*  94 */    { VC_UNDEFINED,            0x00                    },
+    /*  95 */    { VC_KP_COMMA,             0x00                    },
+    /*  96 */    { VC_KP_ENTER,             0x00                    },
+    /*  97 */    { VC_CONTROL_R,            0x00                    },
+    /*  98 */    { VC_KP_DIVIDE,            0x00                    },
+    /*  99 */    { VC_PRINTSCREEN,          0xBA                    },    /* KEY_F16 */
+    /* 100 */    { VC_ALT_R,                0xBB                    },    /* KEY_F17 */
+    /* 101 */    { VC_UNDEFINED,            0xBC                    },    /* KEY_F18 */
+    /* 102 */    { VC_HOME,                 0xBD                    },    /* KEY_F19 */
+    /* 103 */    { VC_UP,                   0xBE                    },    /* KEY_F20 */
+    /* 104 */    { VC_PAGE_UP,              0xBF                    },    /* KEY_F21 */
+    /* 105 */    { VC_LEFT,                 0xC0                    },    /* KEY_F22 */
+    /* 106 */    { VC_RIGHT,                0xC1                    },    /* KEY_F23 */
+    /* 107 */    { VC_END,                  0xC2                    },    /* KEY_F24 */
+    /* 108 */    { VC_DOWN,                 0x00                    },
+    /* 109 */    { VC_PAGE_DOWN,            0x00                    },
+    /* 110 */    { VC_INSERT,               0x00                    },
+    /* 111 */    { VC_DELETE,               0x00                    },
+    /* 112 */    { VC_UNDEFINED,            0x5A                    },    /* KEY_KATAKANA */
+    /* 113 */    { VC_VOLUME_MUTE,          0x00                    },
+    /* 114 */    { VC_VOLUME_DOWN,          0x00                    },
+    /* 115 */    { VC_VOLUME_UP,            0x00                    },
+    /* 116 */    { VC_POWER,                0x00                    },
+    /* 117 */    { VC_KP_EQUALS,            0x00                    },
+    /* 118 */    { VC_UNDEFINED,            0x00                    },
+    /* 119 */    { VC_PAUSE,                0x00                    },
+    /* 120 */    { VC_UNDEFINED,            0x00                    },
+    /* 121 */    { VC_UNDEFINED,            0x5C                    },    /* KEY_HENKAN */
+    /* 122 */    { VC_UNDEFINED,            0x00                    },
+    /* 123 */    { VC_UNDEFINED,            0x5B                    },    /* KEY_HIRAGANA */
+    /* 124 */    { VC_YEN,                  0x00                    },
+    /* 125 */    { VC_META_L,               0x7C                    },    /* KEY_YEN */
+    /* 126 */    { VC_META_R,               0x5F                    },    /* KEY_KPJPCOMMA */
+    /* 127 */    { VC_CONTEXT_MENU,         0x00                    },
+
+    /*            No Offset                Offset (i & 0x007F) + 128            */
+
+    /* 128 */    { VC_SUN_STOP,             0x00                    },
+    /* 129 */    { VC_SUN_AGAIN,            0x00                    },
+    /* 130 */    { VC_SUN_PROPS,            0x00                    },
+    /* 131 */    { VC_SUN_UNDO,             0x00                    },
+    /* 132 */    { VC_SUN_FRONT,            0x00                    },
+    /* 133 */    { VC_SUN_COPY,             0x00                    },
+    /* 134 */    { VC_SUN_OPEN,             0x00                    },
+    /* 135 */    { VC_SUN_INSERT,           0x00                    },
+    /* 136 */    { VC_SUN_FIND,             0x00                    },
+    /* 137 */    { VC_SUN_CUT,              0x00                    },
+    /* 138 */    { VC_SUN_HELP,             0x00                    },
+    /* 139 */    { VC_UNDEFINED,            0x00                    },
+    /* 140 */    { VC_APP_CALCULATOR,       0x00                    },
+    /* 141 */    { VC_UNDEFINED,            0x75                    },    /* KEY_KPEQUAL */
+    /* 142 */    { VC_SLEEP,                0x00                    },
+    /* 143 */    { VC_UNDEFINED,            0x00                    },
+    /* 144 */    { VC_UNDEFINED,            0x00                    },
+    /* 145 */    { VC_UNDEFINED,            0x00                    },
+    /* 146 */    { VC_UNDEFINED,            0x00                    },
+    /* 147 */    { VC_UNDEFINED,            0x00                    },
+    /* 148 */    { VC_UNDEFINED,            0x00                    },
+    /* 149 */    { VC_UNDEFINED,            0x00                    },
+    /* 150 */    { VC_UNDEFINED,            0x00                    },
+    /* 151 */    { VC_UNDEFINED,            0x00                    },
+    /* 152 */    { VC_UNDEFINED,            0x00                    },
+    /* 153 */    { VC_UNDEFINED,            0x00                    },
+    /* 154 */    { VC_UNDEFINED,            0x00                    },
+    /* 155 */    { VC_UNDEFINED,            0x00                    },
+    /* 156 */    { VC_UNDEFINED,            0x60                    },    /* KEY_KPENTER */
+    /* 157 */    { VC_UNDEFINED,            0x61                    },    /* KEY_RIGHTCTRL */
+    /* 158 */    { VC_APP_MAIL,             0x00                    },
+    /* 159 */    { VC_MEDIA_PLAY,           0x00                    },
+    /* 160 */    { VC_UNDEFINED,            0x71                    },    /* KEY_MUTE */
+    /* 161 */    { VC_UNDEFINED,            0x8C                    },    /* KEY_CALC */
+    /* 162 */    { VC_UNDEFINED,            0x9F                    },    /* KEY_FORWARD */
+    /* 163 */    { VC_UNDEFINED,            0x00                    },
+    /* 164 */    { VC_UNDEFINED,            0x00                    },
+    /* 165 */    { VC_UNDEFINED,            0x00                    },
+    /* 166 */    { VC_UNDEFINED,            0x00                    },
+    /* 167 */    { VC_UNDEFINED,            0x00                    },
+    /* 168 */    { VC_UNDEFINED,            0x00                    },
+    /* 169 */    { VC_UNDEFINED,            0x00                    },
+    /* 170 */    { VC_UNDEFINED,            0x00                    },
+    /* 171 */    { VC_UNDEFINED,            0x00                    },
+    /* 172 */    { VC_UNDEFINED,            0x00                    },
+    /* 173 */    { VC_UNDEFINED,            0x00                    },
+    /* 174 */    { VC_UNDEFINED,            0x72                    },    /* KEY_VOLUMEDOWN */
+    /* 175 */    { VC_UNDEFINED,            0x00                    },
+    /* 176 */    { VC_UNDEFINED,            0x73                    },    /* KEY_VOLUMEUP */
+    /* 177 */    { VC_UNDEFINED,            0x00                    },
+    /* 178 */    { VC_BROWSER_HOME,         0xB2                    },    /* KEY_SCROLLUP */
+    /* 179 */    { VC_UNDEFINED,            0x00                    },
+    /* 180 */    { VC_UNDEFINED,            0x00                    },
+    /* 181 */    { VC_UNDEFINED,            0x62                    },    /* KEY_KPSLASH */
+    /* 182 */    { VC_UNDEFINED,            0x00                    },
+    /* 183 */    { VC_F13,                  0x63                    },    /* KEY_SYSRQ */
+    /* 184 */    { VC_F14,                  0x64                    },    /* KEY_RIGHTALT */
+    /* 185 */    { VC_F15,                  0x00                    },
+    /* 186 */    { VC_F16,                  0x00                    },
+    /* 187 */    { VC_F17,                  0x00                    },
+    /* 188 */    { VC_F18,                  0x00                    },
+    /* 189 */    { VC_F19,                  0x00                    },
+    /* 190 */    { VC_F20,                  0x00                    },
+    /* 191 */    { VC_F21,                  0x00                    },
+    /* 192 */    { VC_F22,                  0x00                    },
+    /* 193 */    { VC_F23,                  0x00                    },
+    /* 194 */    { VC_F24,                  0x00                    },
+    /* 195 */    { VC_UNDEFINED,            0x00                    },
+    /* 196 */    { VC_UNDEFINED,            0x00                    },
+    /* 197 */    { VC_UNDEFINED,            0x77                    },    /* KEY_PAUSE */
+    /* 198 */    { VC_UNDEFINED,            0xDA                    },    /* KEY_CONNECT */
+    /* 199 */    { VC_UNDEFINED,            0x66                    },    /* KEY_HOME */
+    /* 200 */    { VC_UNDEFINED,            0x67                    },    /* KEY_UP */
+    /* 201 */    { VC_UNDEFINED,            0x68                    },    /* KEY_PAGEUP */
+    /* 202 */    { VC_UNDEFINED,            0x00                    },
+    /* 203 */    { VC_UNDEFINED,            0x69                    },    /* KEY_LEFT */
+    /* 204 */    { VC_UNDEFINED,            0x00                    },
+    /* 205 */    { VC_UNDEFINED,            0x6A                    },    /* KEY_RIGHT */
+    /* 206 */    { VC_UNDEFINED,            0x00                    },
+    /* 207 */    { VC_UNDEFINED,            0x6B                    },    /* KEY_END */
+    /* 208 */    { VC_UNDEFINED,            0x6C                    },    /* KEY_DOWN */
+    /* 209 */    { VC_UNDEFINED,            0x6D                    },    /* KEY_PAGEDOWN */
+    /* 210 */    { VC_UNDEFINED,            0x6E                    },    /* KEY_INSERT */
+    /* 211 */    { VC_UNDEFINED,            0x6F                    },    /* KEY_DELETE */
+    /* 212 */    { VC_UNDEFINED,            0x00                    },
+    /* 213 */    { VC_UNDEFINED,            0x00                    },
+    /* 214 */    { VC_UNDEFINED,            0x00                    },
+    /* 215 */    { VC_UNDEFINED,            0x00                    },
+    /* 216 */    { VC_UNDEFINED,            0x00                    },
+    /* 217 */    { VC_BROWSER_SEARCH,       0x00                    },
+    /* 218 */    { VC_LESSER_GREATER,       0x00                    },
+    /* 219 */    { VC_UNDEFINED,            0x7D                    },    /* KEY_LEFTMETA */
+    /* 220 */    { VC_UNDEFINED,            0x7E                    },    /* KEY_RIGHTMETA */
+    /* 221 */    { VC_UNDEFINED,            0x7F                    },    /* KEY_COMPOSE */
+    /* 222 */    { VC_UNDEFINED,            0x74                    },    /* KEY_POWER */
+    /* 223 */    { VC_UNDEFINED,            0x8E                    },    /* KEY_SLEEP */
+    /* 224 */    { VC_UNDEFINED,            0x00                    },
+    /* 225 */    { VC_UNDEFINED,            0x00                    },
+    /* 226 */    { VC_UNDEFINED,            0x00                    },
+    /* 227 */    { VC_UNDEFINED,            0x00                    },
+    /* 228 */    { VC_UNDEFINED,            0x00                    },
+    /* 229 */    { VC_UNDEFINED,            0xD9                    },    /* KEY_SEARCH */
+    /* 230 */    { VC_UNDEFINED,            0x00                    },
+    /* 231 */    { VC_UNDEFINED,            0x00                    },
+    /* 232 */    { VC_UNDEFINED,            0x00                    },
+    /* 233 */    { VC_UNDEFINED,            0x00                    },
+    /* 234 */    { VC_UNDEFINED,            0x00                    },
+    /* 235 */    { VC_UNDEFINED,            0x00                    },
+    /* 236 */    { VC_UNDEFINED,            0x9E                    },    /* KEY_BACK */
+    /* 237 */    { VC_UNDEFINED,            0x00                    },
+    /* 238 */    { VC_UNDEFINED,            0x00                    },
+    /* 239 */    { VC_UNDEFINED,            0x00                    },
+    /* 240 */    { VC_UNDEFINED,            0x00                    },
+    /* 241 */    { VC_UNDEFINED,            0x00                    },
+    /* 242 */    { VC_UNDEFINED,            0x00                    },
+    /* 243 */    { VC_UNDEFINED,            0x00                    },
+    /* 244 */    { VC_UNDEFINED,            0x86                    },    /* KEY_OPEN */
+    /* 245 */    { VC_UNDEFINED,            0x8A                    },    /* KEY_HELP */
+    /* 246 */    { VC_UNDEFINED,            0x82                    },    /* KEY_PROPS */
+    /* 247 */    { VC_UNDEFINED,            0x84                    },    /* KEY_FRONT */
+    /* 248 */    { VC_UNDEFINED,            0x80                    },    /* KEY_STOP */
+    /* 249 */    { VC_UNDEFINED,            0x81                    },    /* KEY_AGAIN */
+    /* 250 */    { VC_UNDEFINED,            0x83                    },    /* KEY_UNDO */
+    /* 251 */    { VC_UNDEFINED,            0x89                    },    /* KEY_CUT */
+    /* 252 */    { VC_UNDEFINED,            0x85                    },    /* KEY_COPY */
+    /* 253 */    { VC_UNDEFINED,            0x87                    },    /* KEY_PASTE */
+    /* 254 */    { VC_UNDEFINED,            0x88                    },    /* KEY_FIND */
+    /* 255 */    { VC_UNDEFINED,            0x00                    },
+};
+
+// Characters produced by each input event key code on a US keyboard layout.
+static const uint16_t keycode_unicode_table[][2] = {
+    /* keycode              { unshifted, shifted } */
+    [KEY_1]               = { '1', '!' },
+    [KEY_2]               = { '2', '@' },
+    [KEY_3]               = { '3', '#' },
+    [KEY_4]               = { '4', '$' },
+    [KEY_5]               = { '5', '%' },
+    [KEY_6]               = { '6', '^' },
+    [KEY_7]               = { '7', '&' },
+    [KEY_8]               = { '8', '*' },
+    [KEY_9]               = { '9', '(' },
+    [KEY_0]               = { '0', ')' },
+    [KEY_MINUS]           = { '-', '_' },
+    [KEY_EQUAL]           = { '=', '+' },
+    [KEY_Q]               = { 'q', 'Q' },
+    [KEY_W]               = { 'w', 'W' },
+    [KEY_E]               = { 'e', 'E' },
+    [KEY_R]               = { 'r', 'R' },
+    [KEY_T]               = { 't', 'T' },
+    [KEY_Y]               = { 'y', 'Y' },
+    [KEY_U]               = { 'u', 'U' },
+    [KEY_I]               = { 'i', 'I' },
+    [KEY_O]               = { 'o', 'O' },
+    [KEY_P]               = { 'p', 'P' },
+    [KEY_LEFTBRACE]       = { '[', '{' },
+    [KEY_RIGHTBRACE]      = { ']', '}' },
+    [KEY_A]               = { 'a', 'A' },
+    [KEY_S]               = { 's', 'S' },
+    [KEY_D]               = { 'd', 'D' },
+    [KEY_F]               = { 'f', 'F' },
+    [KEY_G]               = { 'g', 'G' },
+    [KEY_H]               = { 'h', 'H' },
+    [KEY_J]               = { 'j', 'J' },
+    [KEY_K]               = { 'k', 'K' },
+    [KEY_L]               = { 'l', 'L' },
+    [KEY_SEMICOLON]       = { ';', ':' },
+    [KEY_APOSTROPHE]      = { '\'', '"' },
+    [KEY_GRAVE]           = { '`', '~' },
+    [KEY_BACKSLASH]       = { '\\', '|' },
+    [KEY_Z]               = { 'z', 'Z' },
+    [KEY_X]               = { 'x', 'X' },
+    [KEY_C]               = { 'c', 'C' },
+    [KEY_V]               = { 'v', 'V' },
+    [KEY_B]               = { 'b', 'B' },
+    [KEY_N]               = { 'n', 'N' },
+    [KEY_M]               = { 'm', 'M' },
+    [KEY_COMMA]           = { ',', '<' },
+    [KEY_DOT]             = { '.', '>' },
+    [KEY_SLASH]           = { '/', '?' },
+    [KEY_KPASTERISK]      = { '*', '*' },
+    [KEY_SPACE]           = { ' ', ' ' },
+    [KEY_KP7]             = { '7', '7' },
+    [KEY_KP8]             = { '8', '8' },
+    [KEY_KP9]             = { '9', '9' },
+    [KEY_KPMINUS]         = { '-', '-' },
+    [KEY_KP4]             = { '4', '4' },
+    [KEY_KP5]             = { '5', '5' },
+    [KEY_KP6]             = { '6', '6' },
+    [KEY_KPPLUS]          = { '+', '+' },
+    [KEY_KP1]             = { '1', '1' },
+    [KEY_KP2]             = { '2', '2' },
+    [KEY_KP3]             = { '3', '3' },
+    [KEY_KP0]             = { '0', '0' },
+    [KEY_KPDOT]           = { '.', '.' },
+    [KEY_KPSLASH]         = { '/', '/' },
+};
+
+uint16_t keycode_to_scancode(uint16_t keycode) {
+    uint16_t scancode = VC_UNDEFINED;
+
+    unsigned short table_size = sizeof(keycode_scancode_table) / sizeof(keycode_scancode_table[0]);
+    if (keycode < table_size) {
+        scancode = keycode_scancode_table[keycode][0];
+    }
+
+    return scancode;
+}
+
+uint16_t scancode_to_keycode(uint16_t scancode) {
+    uint16_t keycode = 0x0000;
+
+    unsigned short table_size = sizeof(keycode_scancode_table) / sizeof(keycode_scancode_table[0]);
+    if (scancode >= 128) {
+        // Offset is the lower order bits + 128
+        scancode = (scancode & 0x007F) | 0x80;
+    }
+
+    if (scancode < table_size) {
+        keycode = keycode_scancode_table[scancode][1];
+    }
+
+    return keycode;
+}
+
+// Keypad digits only produce characters while num lock is on.
+static inline bool is_keypad_digit(uint16_t keycode) {
+    return (keycode >= KEY_KP7 && keycode <= KEY_KP0 && keycode != KEY_KPMINUS && keycode != KEY_KPPLUS)
+            || keycode == KEY_KPDOT;
+}
+
+size_t keycode_to_unicode(uint16_t keycode, uint16_t mask, uint16_t *buffer, size_t size) {
+    size_t count = 0;
+
+    unsigned short table_size = sizeof(keycode_unicode_table) / sizeof(keycode_unicode_table[0]);
+    if (size > 0 && keycode < table_size && keycode_unicode_table[keycode][0] != 0x0000) {
+        if (is_keypad_digit(keycode) && (mask & MASK_NUM_LOCK) == 0) {
+            return 0;
+        }
+
+        bool shifted = (mask & (MASK_SHIFT)) != 0;
+
+        // Caps lock only applies to letters.
+        uint16_t unshifted = keycode_unicode_table[keycode][0];
+        if (unshifted >= 'a' && unshifted <= 'z' && (mask & MASK_CAPS_LOCK) != 0) {
+            shifted = !shifted;
+        }
+
+        buffer[count++] = keycode_unicode_table[keycode][shifted ? 1 : 0];
+    }
+
+    return count;
+}
+
+uint16_t unicode_to_keycode(uint16_t unicode, bool *shift) {
+    unsigned short table_size = sizeof(keycode_unicode_table) / sizeof(keycode_unicode_table[0]);
+    for (uint16_t keycode = 0; keycode < table_size; keycode++) {
+        // Prefer the main keyboard block, keypad keys depend on num lock.
+        if (is_keypad_digit(keycode)) {
+            continue;
+        }
+
+        for (int level = 0; level < 2; level++) {
+            if (keycode_unicode_table[keycode][level] == unicode && unicode != 0x0000) {
+                *shift = level == 1;
+                return keycode;
+            }
+        }
+    }
+
+    return 0x00;
+}
+
+void load_input_helper() {
+}
+
+void unload_input_helper() {
+}
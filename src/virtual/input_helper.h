@@ -0,0 +1,56 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _included_input_helper
+#define _included_input_helper
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* The virtual backend uses Linux input event codes, as found in
+ * <linux/input-event-codes.h>, as its native key codes so injected events
+ * have the same shape as events read from an evdev device.
+ */
+
+/* Converts an input event key code to the appropriate keyboard scan code.
+ */
+extern uint16_t keycode_to_scancode(uint16_t keycode);
+
+/* Converts a keyboard scan code to the appropriate input event key code.
+ */
+extern uint16_t scancode_to_keycode(uint16_t scancode);
+
+/* Converts an input event key code to the characters it produces on a US
+ * keyboard layout with the given virtual modifier mask.
+ */
+extern size_t keycode_to_unicode(uint16_t keycode, uint16_t mask, uint16_t *buffer, size_t size);
+
+/* Finds the input event key code and shift state that produce a character on
+ * a US keyboard layout.  Returns 0x00 if the character cannot be typed.
+ */
+extern uint16_t unicode_to_keycode(uint16_t unicode, bool *shift);
+
+/* Nothing needs to be loaded for the virtual backend, these exist so callers
+ * can treat every backend alike.
+ */
+extern void load_input_helper();
+
+extern void unload_input_helper();
+
+#endif
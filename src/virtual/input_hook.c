@@ -0,0 +1,410 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <linux/input-event-codes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <uiohook.h>
+
+#include "dispatch_event.h"
+#include "input_helper.h"
+#include "logger.h"
+#include "system_properties.h"
+#include "trace.h"
+#include "usdt.h"
+
+static pthread_mutex_t hook_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t hook_cond = PTHREAD_COND_INITIALIZER;
+
+typedef struct _hook_info {
+    bool running;
+    pthread_t thread;
+    struct _queue {
+        const virtual_event *events;
+        size_t count;
+        uint64_t submitted;
+        uint64_t completed;
+    } queue;
+    struct _pointer {
+        int16_t x;
+        int16_t y;
+        bool moved;
+    } pointer;
+    uint32_t screen_generation;
+    uint32_t device_generation;
+} hook_info;
+static hook_info hook;
+
+// Device list set by hook_virtual_set_devices(), guarded by hook_mutex.
+static device_info devices[UINT8_MAX];
+static uint8_t device_count = 0;
+static uint32_t device_generation = 0;
+
+// Virtual clock in milliseconds used to timestamp dispatched events.
+static uint64_t virtual_time = 0;
+
+UIOHOOK_API void hook_virtual_set_time(uint64_t time) {
+    __atomic_store_n(&virtual_time, time, __ATOMIC_RELEASE);
+}
+
+UIOHOOK_API uint64_t hook_virtual_advance_time(uint64_t delta) {
+    return __atomic_add_fetch(&virtual_time, delta, __ATOMIC_ACQ_REL);
+}
+
+static inline uint64_t get_time() {
+    return __atomic_load_n(&virtual_time, __ATOMIC_ACQUIRE);
+}
+
+// Dispatch pending pointer motion before any event that depends on the pointer position.
+static void flush_motion() {
+    if (hook.pointer.moved) {
+        hook.pointer.moved = false;
+        dispatch_mouse_move(get_time(), hook.pointer.x, hook.pointer.y);
+    }
+}
+
+static uint16_t button_code_to_mouse_button(uint16_t code) {
+    switch (code) {
+        case BTN_LEFT:   return MOUSE_BUTTON1;
+        case BTN_RIGHT:  return MOUSE_BUTTON2;
+        case BTN_MIDDLE: return MOUSE_BUTTON3;
+        case BTN_SIDE:   return MOUSE_BUTTON4;
+        case BTN_EXTRA:  return MOUSE_BUTTON5;
+        default:         return MOUSE_NOBUTTON;
+    }
+}
+
+static void process_key_event(uint16_t code, int32_t value) {
+    TRACE_BEGIN(translate);
+    uint16_t scancode = keycode_to_scancode(code);
+    USDT_PROBE3(key_translate, code, scancode, 0);
+    TRACE_END(TRACE_STAGE_TRANSLATE, code, translate);
+    set_key_state(code, value != 0);
+
+    if (value == 0) {
+        dispatch_key_release(get_time(), scancode, code);
+        return;
+    }
+
+    // Lock keys toggle on press, auto repeat (value 2) leaves them alone.
+    if (value == 1) {
+        uint16_t lock = 0x0000;
+        if      (scancode == VC_CAPS_LOCK)   { lock = MASK_CAPS_LOCK;   }
+        else if (scancode == VC_NUM_LOCK)    { lock = MASK_NUM_LOCK;    }
+        else if (scancode == VC_SCROLL_LOCK) { lock = MASK_SCROLL_LOCK; }
+
+        if (get_modifiers() & lock) {
+            unset_modifier_mask(lock);
+        } else {
+            set_modifier_mask(lock);
+        }
+    }
+
+    uint16_t buffer[2];
+    size_t count = keycode_to_unicode(code, get_modifiers(), buffer, sizeof(buffer) / sizeof(uint16_t));
+
+    dispatch_key_press(get_time(), scancode, code, buffer, count);
+}
+
+// Load the current screen layout into the dispatch screen index.
+static void load_screens() {
+    screen_data screens[UINT8_MAX];
+    unsigned char count = UINT8_MAX;
+    if (hook_get_screen_info(screens, &count) != UIOHOOK_SUCCESS) {
+        count = 0;
+    }
+
+    dispatch_set_screens(screens, count);
+}
+
+UIOHOOK_API int hook_virtual_set_devices(const device_info *list, uint8_t count) {
+    if (list == NULL && count > 0) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: Invalid virtual device list!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (list[i].id == DEVICE_UNDEFINED) {
+            logger(LOG_LEVEL_WARN, "%s [%u]: Invalid virtual device id!\n",
+                    __FUNCTION__, __LINE__);
+            return UIOHOOK_FAILURE;
+        }
+    }
+
+    pthread_mutex_lock(&hook_mutex);
+    if (count > 0) {
+        memcpy(devices, list, sizeof(device_info) * count);
+    }
+    device_count = count;
+    device_generation++;
+    pthread_mutex_unlock(&hook_mutex);
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Virtual device count set to %u.\n",
+            __FUNCTION__, __LINE__, count);
+
+    return UIOHOOK_SUCCESS;
+}
+
+// Pass the device list to the dispatcher if it changed, hook_mutex must be held.
+static void load_devices() {
+    if (hook.device_generation != device_generation) {
+        hook.device_generation = device_generation;
+        dispatch_set_devices(devices, device_count);
+    }
+}
+
+static void process_events(const virtual_event *events, size_t count) {
+    pthread_mutex_lock(&hook_mutex);
+    load_devices();
+    pthread_mutex_unlock(&hook_mutex);
+
+    // Dispatch EVENT_SCREEN_CHANGED ahead of the batch if the screen layout changed.
+    uint32_t generation = get_screen_generation();
+    if (generation != hook.screen_generation) {
+        hook.screen_generation = generation;
+        load_screens();
+        dispatch_screen_changed(get_time());
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const virtual_event *event = &events[i];
+
+        switch (event->type) {
+            case EV_SYN:
+                if (event->code == SYN_REPORT) {
+                    flush_motion();
+                }
+                break;
+
+            case EV_KEY:
+                flush_motion();
+
+                if (event->code >= BTN_MISC && event->code < KEY_OK) {
+                    uint16_t button = button_code_to_mouse_button(event->code);
+                    if (event->value) {
+                        dispatch_mouse_press(get_time(), button, hook.pointer.x, hook.pointer.y);
+                    } else {
+                        dispatch_mouse_release(get_time(), button, hook.pointer.x, hook.pointer.y);
+                    }
+                } else {
+                    process_key_event(event->code, event->value);
+                }
+                break;
+
+            case EV_REL:
+                if (event->code == REL_X) {
+                    hook.pointer.x += event->value;
+                    hook.pointer.moved = true;
+                } else if (event->code == REL_Y) {
+                    hook.pointer.y += event->value;
+                    hook.pointer.moved = true;
+                } else if (event->code == REL_WHEEL && event->value != 0) {
+                    flush_motion();
+
+                    // Positive values rotate away from the user, the X11 WheelUp direction.
+                    dispatch_mouse_wheel(get_time(), hook.pointer.x, hook.pointer.y,
+                            WHEEL_UNIT_SCROLL, 3, event->value > 0 ? -1 : 1, WHEEL_VERTICAL_DIRECTION);
+                } else if (event->code == REL_HWHEEL && event->value != 0) {
+                    flush_motion();
+
+                    dispatch_mouse_wheel(get_time(), hook.pointer.x, hook.pointer.y,
+                            WHEEL_UNIT_SCROLL, 3, event->value > 0 ? 1 : -1, WHEEL_HORIZONTAL_DIRECTION);
+                }
+                break;
+
+            case EV_ABS:
+                if (event->code == ABS_X && event->value != hook.pointer.x) {
+                    hook.pointer.x = (int16_t) event->value;
+                    hook.pointer.moved = true;
+                } else if (event->code == ABS_Y && event->value != hook.pointer.y) {
+                    hook.pointer.y = (int16_t) event->value;
+                    hook.pointer.moved = true;
+                }
+                break;
+
+            case VIRTUAL_EVENT_DEVICE:
+                // Pending motion belongs to the previous device.
+                flush_motion();
+                dispatch_set_source((uint8_t) event->code);
+                break;
+
+            default:
+                logger(LOG_LEVEL_DEBUG, "%s [%u]: Unhandled virtual event type: %#X.\n",
+                        __FUNCTION__, __LINE__, event->type);
+                break;
+        }
+    }
+}
+
+UIOHOOK_API int hook_virtual_inject(const virtual_event *events, size_t count) {
+    if (events == NULL && count > 0) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: Invalid virtual events!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+
+    pthread_mutex_lock(&hook_mutex);
+    if (!hook.running) {
+        pthread_mutex_unlock(&hook_mutex);
+
+        logger(LOG_LEVEL_WARN, "%s [%u]: The virtual hook is not running!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+
+    // Events injected from a dispatch callback are processed in place.
+    if (pthread_equal(pthread_self(), hook.thread)) {
+        pthread_mutex_unlock(&hook_mutex);
+        process_events(events, count);
+        return UIOHOOK_SUCCESS;
+    }
+
+    // Only one batch is queued at a time so events are dispatched in the order they were injected.
+    while (hook.running && hook.queue.events != NULL) {
+        pthread_cond_wait(&hook_cond, &hook_mutex);
+    }
+
+    if (!hook.running) {
+        pthread_mutex_unlock(&hook_mutex);
+        return UIOHOOK_FAILURE;
+    }
+
+    hook.queue.events = events;
+    hook.queue.count = count;
+    uint64_t ticket = ++hook.queue.submitted;
+    pthread_cond_broadcast(&hook_cond);
+
+    // Wait for the hook thread so the caller observes every dispatched event on return.
+    while (hook.queue.completed < ticket) {
+        pthread_cond_wait(&hook_cond, &hook_mutex);
+    }
+    pthread_mutex_unlock(&hook_mutex);
+
+    return UIOHOOK_SUCCESS;
+}
+
+UIOHOOK_API int hook_run() {
+    pthread_mutex_lock(&hook_mutex);
+    if (hook.running) {
+        pthread_mutex_unlock(&hook_mutex);
+
+        logger(LOG_LEVEL_ERROR, "%s [%u]: The virtual hook is already running!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+
+    hook.running = true;
+    hook.thread = pthread_self();
+    hook.pointer.x = 0;
+    hook.pointer.y = 0;
+    hook.pointer.moved = false;
+    hook.screen_generation = get_screen_generation();
+    load_screens();
+
+    // Reset the shared modifier and click state.
+    dispatch_set_multi_click_time(hook_get_multi_click_time());
+    dispatch_reset(0x0000);
+    hook.device_generation = device_generation;
+    dispatch_set_devices(devices, device_count);
+    pthread_mutex_unlock(&hook_mutex);
+
+    // Fire the hook start event.
+    dispatch_hook_enabled(get_time());
+
+    pthread_mutex_lock(&hook_mutex);
+    while (hook.running || hook.queue.events != NULL) {
+        if (hook.queue.events != NULL) {
+            const virtual_event *events = hook.queue.events;
+            size_t count = hook.queue.count;
+            pthread_mutex_unlock(&hook_mutex);
+
+            process_events(events, count);
+
+            pthread_mutex_lock(&hook_mutex);
+            hook.queue.events = NULL;
+            hook.queue.count = 0;
+            hook.queue.completed++;
+            pthread_cond_broadcast(&hook_cond);
+        } else {
+            pthread_cond_wait(&hook_cond, &hook_mutex);
+        }
+    }
+    pthread_mutex_unlock(&hook_mutex);
+
+    // Fire the hook stop event.
+    dispatch_hook_disabled(get_time());
+
+    pthread_mutex_lock(&hook_mutex);
+    hook.thread = (pthread_t) 0;
+    pthread_mutex_unlock(&hook_mutex);
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Something, something, something, complete.\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_SUCCESS;
+}
+
+UIOHOOK_API int hook_stop() {
+    int status = UIOHOOK_FAILURE;
+
+    pthread_mutex_lock(&hook_mutex);
+    if (hook.running) {
+        hook.running = false;
+        pthread_cond_broadcast(&hook_cond);
+
+        status = UIOHOOK_SUCCESS;
+    }
+    pthread_mutex_unlock(&hook_mutex);
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Status: %#X.\n",
+            __FUNCTION__, __LINE__, status);
+
+    return status;
+}
+
+UIOHOOK_API int hook_recorder_start(const char *path, const recorder_options *options) {
+    (void) path;
+    (void) options;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Recording is not supported on this platform!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
+
+UIOHOOK_API int hook_recorder_stop(recorder_stats *stats) {
+    (void) stats;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Recording is not supported on this platform!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
+
+UIOHOOK_API int hook_set_replay_source(const char *path, double speed) {
+    (void) path;
+    (void) speed;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Replay sources are not supported on this platform!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
@@ -0,0 +1,193 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <linux/input-event-codes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <uiohook.h>
+
+#include "input_helper.h"
+#include "logger.h"
+
+// Longest sequence produced for a single posted event.
+#define MAX_POST_EVENTS    8
+
+static uint16_t mouse_button_to_button_code(uint16_t button) {
+    switch (button) {
+        case MOUSE_BUTTON1: return BTN_LEFT;
+        case MOUSE_BUTTON2: return BTN_RIGHT;
+        case MOUSE_BUTTON3: return BTN_MIDDLE;
+        case MOUSE_BUTTON4: return BTN_SIDE;
+        case MOUSE_BUTTON5: return BTN_EXTRA;
+        default:            return 0x0000;
+    }
+}
+
+static inline void append_event(virtual_event *events, size_t *count, uint16_t type, uint16_t code, int32_t value) {
+    events[(*count)++] = (virtual_event) {
+        .type = type,
+        .code = code,
+        .value = value
+    };
+}
+
+// Build the input events for a typed character, pressing shift when the character requires it.
+static size_t build_typed_events(uint16_t keychar, virtual_event *events) {
+    size_t count = 0;
+
+    bool shift = false;
+    uint16_t code = unicode_to_keycode(keychar, &shift);
+    if (code == 0x00) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: Unable to type character %#X on the virtual keyboard!\n",
+                __FUNCTION__, __LINE__, keychar);
+        return 0;
+    }
+
+    if (shift) {
+        append_event(events, &count, EV_KEY, KEY_LEFTSHIFT, 1);
+    }
+    append_event(events, &count, EV_KEY, code, 1);
+    append_event(events, &count, EV_KEY, code, 0);
+    if (shift) {
+        append_event(events, &count, EV_KEY, KEY_LEFTSHIFT, 0);
+    }
+    append_event(events, &count, EV_SYN, SYN_REPORT, 0);
+
+    return count;
+}
+
+static size_t build_events(uiohook_event * const event, virtual_event *events) {
+    size_t count = 0;
+
+    switch (event->type) {
+        case EVENT_KEY_TYPED:
+            count = build_typed_events(event->data.keyboard.keychar, events);
+            break;
+
+        case EVENT_KEY_PRESSED:
+        case EVENT_KEY_RELEASED: {
+            uint16_t code = scancode_to_keycode(event->data.keyboard.keycode);
+            if (code != 0x0000) {
+                append_event(events, &count, EV_KEY, code, event->type == EVENT_KEY_PRESSED ? 1 : 0);
+                append_event(events, &count, EV_SYN, SYN_REPORT, 0);
+            }
+            break;
+        }
+
+        case EVENT_MOUSE_PRESSED:
+        case EVENT_MOUSE_RELEASED:
+        case EVENT_MOUSE_CLICKED: {
+            uint16_t code = mouse_button_to_button_code(event->data.mouse.button);
+            if (code == 0x0000) {
+                break;
+            }
+
+            append_event(events, &count, EV_ABS, ABS_X, event->data.mouse.x);
+            append_event(events, &count, EV_ABS, ABS_Y, event->data.mouse.y);
+            if (event->type != EVENT_MOUSE_RELEASED) {
+                append_event(events, &count, EV_KEY, code, 1);
+                append_event(events, &count, EV_SYN, SYN_REPORT, 0);
+            }
+            if (event->type != EVENT_MOUSE_PRESSED) {
+                append_event(events, &count, EV_KEY, code, 0);
+                append_event(events, &count, EV_SYN, SYN_REPORT, 0);
+            }
+            break;
+        }
+
+        case EVENT_MOUSE_MOVED:
+        case EVENT_MOUSE_DRAGGED:
+            append_event(events, &count, EV_ABS, ABS_X, event->data.mouse.x);
+            append_event(events, &count, EV_ABS, ABS_Y, event->data.mouse.y);
+            append_event(events, &count, EV_SYN, SYN_REPORT, 0);
+            break;
+
+        case EVENT_MOUSE_WHEEL:
+            append_event(events, &count, EV_ABS, ABS_X, event->data.wheel.x);
+            append_event(events, &count, EV_ABS, ABS_Y, event->data.wheel.y);
+            if (event->data.wheel.direction == WHEEL_HORIZONTAL_DIRECTION) {
+                append_event(events, &count, EV_REL, REL_HWHEEL, event->data.wheel.rotation > 0 ? 1 : -1);
+            } else {
+                append_event(events, &count, EV_REL, REL_WHEEL, event->data.wheel.rotation < 0 ? 1 : -1);
+            }
+            append_event(events, &count, EV_SYN, SYN_REPORT, 0);
+            break;
+
+        default:
+            logger(LOG_LEVEL_WARN, "%s [%u]: Ignoring post event type %#X\n",
+                    __FUNCTION__, __LINE__, event->type);
+            break;
+    }
+
+    return count;
+}
+
+// Posted events are injected back into the running virtual hook.
+UIOHOOK_API void hook_post_event(uiohook_event * const event) {
+    virtual_event events[MAX_POST_EVENTS];
+    size_t count = build_events(event, events);
+
+    if (count > 0) {
+        hook_virtual_inject(events, count);
+    }
+}
+
+UIOHOOK_API int hook_post_text(const char *utf8, size_t length) {
+    int status = UIOHOOK_SUCCESS;
+
+    for (size_t i = 0; i < length; i++) {
+        // The virtual keyboard only has a US layout, so only ASCII can be typed.
+        unsigned char c = (unsigned char) utf8[i];
+        if (c >= 0x80) {
+            logger(LOG_LEVEL_WARN, "%s [%u]: Unable to type non-ASCII text at offset %zu!\n",
+                    __FUNCTION__, __LINE__, i);
+
+            status = UIOHOOK_FAILURE;
+            continue;
+        }
+
+        virtual_event events[MAX_POST_EVENTS];
+        size_t count = build_typed_events(c, events);
+        if (count == 0 || hook_virtual_inject(events, count) != UIOHOOK_SUCCESS) {
+            status = UIOHOOK_FAILURE;
+        }
+    }
+
+    return status;
+}
+
+UIOHOOK_API int hook_post_motion_path(const motion_path *path) {
+    (void) path;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Motion paths are not supported on this platform!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
+
+UIOHOOK_API int hook_replay_events(const uiohook_event *events, size_t count, double speed, replay_stats *stats) {
+    (void) events;
+    (void) count;
+    (void) speed;
+    (void) stats;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Event replay is not supported on this platform!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
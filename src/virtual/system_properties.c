@@ -0,0 +1,144 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uiohook.h>
+
+#include "logger.h"
+#include "system_properties.h"
+
+/* The virtual backend reports the X server defaults so results do not
+ * depend on the machine running the tests.
+ */
+#define VIRTUAL_AUTO_REPEAT_RATE                25
+#define VIRTUAL_AUTO_REPEAT_DELAY               660
+#define VIRTUAL_POINTER_ACCELERATION_MULTIPLIER 1
+#define VIRTUAL_POINTER_ACCELERATION_THRESHOLD  4
+#define VIRTUAL_POINTER_SENSITIVITY             2
+#define VIRTUAL_MULTI_CLICK_TIME                200
+
+static pthread_mutex_t screens_mutex = PTHREAD_MUTEX_INITIALIZER;
+static screen_data screens[UINT8_MAX] = {
+    { .number = 1, .x = 0, .y = 0, .width = 1920, .height = 1080 }
+};
+static uint8_t screen_count = 1;
+static uint32_t screen_generation = 0;
+
+UIOHOOK_API int hook_virtual_set_screens(const screen_data *layout, uint8_t count) {
+    if (layout == NULL && count > 0) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: Invalid virtual screen layout!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+
+    pthread_mutex_lock(&screens_mutex);
+    if (count > 0) {
+        memcpy(screens, layout, sizeof(screen_data) * count);
+    }
+    screen_count = count;
+    __atomic_add_fetch(&screen_generation, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&screens_mutex);
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Virtual screen count set to %u.\n",
+            __FUNCTION__, __LINE__, count);
+
+    return UIOHOOK_SUCCESS;
+}
+
+uint32_t get_screen_generation() {
+    return __atomic_load_n(&screen_generation, __ATOMIC_ACQUIRE);
+}
+
+UIOHOOK_API int hook_get_screen_info(screen_data *buffer, unsigned char *count) {
+    if (count == NULL || (buffer == NULL && *count > 0)) {
+        return UIOHOOK_FAILURE;
+    }
+
+    pthread_mutex_lock(&screens_mutex);
+    if (*count > 0) {
+        memcpy(buffer, screens, sizeof(screen_data) * (screen_count < *count ? screen_count : *count));
+    }
+    *count = screen_count;
+    pthread_mutex_unlock(&screens_mutex);
+
+    return UIOHOOK_SUCCESS;
+}
+
+UIOHOOK_API screen_data* hook_create_screen_info(unsigned char *count) {
+    *count = 0;
+    screen_data *copy = NULL;
+
+    pthread_mutex_lock(&screens_mutex);
+    if (screen_count > 0) {
+        copy = malloc(sizeof(screen_data) * screen_count);
+        if (copy != NULL) {
+            memcpy(copy, screens, sizeof(screen_data) * screen_count);
+            *count = screen_count;
+        } else {
+            logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to allocate memory for screen info!\n",
+                    __FUNCTION__, __LINE__);
+        }
+    }
+    pthread_mutex_unlock(&screens_mutex);
+
+    return copy;
+}
+
+UIOHOOK_API long int hook_get_auto_repeat_rate() {
+    return VIRTUAL_AUTO_REPEAT_RATE;
+}
+
+UIOHOOK_API long int hook_get_auto_repeat_delay() {
+    return VIRTUAL_AUTO_REPEAT_DELAY;
+}
+
+UIOHOOK_API long int hook_get_pointer_acceleration_multiplier() {
+    return VIRTUAL_POINTER_ACCELERATION_MULTIPLIER;
+}
+
+UIOHOOK_API long int hook_get_pointer_acceleration_threshold() {
+    return VIRTUAL_POINTER_ACCELERATION_THRESHOLD;
+}
+
+UIOHOOK_API long int hook_get_pointer_sensitivity() {
+    return VIRTUAL_POINTER_SENSITIVITY;
+}
+
+UIOHOOK_API long int hook_get_multi_click_time() {
+    return VIRTUAL_MULTI_CLICK_TIME;
+}
+
+UIOHOOK_API int hook_get_system_properties(system_properties *properties) {
+    if (properties == NULL) {
+        return UIOHOOK_FAILURE;
+    }
+
+    *properties = (system_properties) {
+        .auto_repeat_rate = VIRTUAL_AUTO_REPEAT_RATE,
+        .auto_repeat_delay = VIRTUAL_AUTO_REPEAT_DELAY,
+        .pointer_acceleration_multiplier = VIRTUAL_POINTER_ACCELERATION_MULTIPLIER,
+        .pointer_acceleration_threshold = VIRTUAL_POINTER_ACCELERATION_THRESHOLD,
+        .pointer_sensitivity = VIRTUAL_POINTER_SENSITIVITY,
+        .multi_click_time = VIRTUAL_MULTI_CLICK_TIME
+    };
+
+    return UIOHOOK_SUCCESS;
+}
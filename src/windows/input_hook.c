@@ -323,6 +323,9 @@ static void process_button_pressed(MSLLHOOKSTRUCT *mshook, uint16_t button) {
 
     event.data.mouse.x = (int16_t) mshook->pt.x;
     event.data.mouse.y = (int16_t) mshook->pt.y;
+    event.data.mouse.screen = SCREEN_UNDEFINED;
+    event.data.mouse.screen_x = event.data.mouse.x;
+    event.data.mouse.screen_y = event.data.mouse.y;
 
     logger(LOG_LEVEL_DEBUG, "%s [%u]: Button %u  pressed %u time(s). (%u, %u)\n",
             __FUNCTION__, __LINE__, event.data.mouse.button, event.data.mouse.clicks,
@@ -345,6 +348,9 @@ static void process_button_released(MSLLHOOKSTRUCT *mshook, uint16_t button) {
 
     event.data.mouse.x = (int16_t) mshook->pt.x;
     event.data.mouse.y = (int16_t) mshook->pt.y;
+    event.data.mouse.screen = SCREEN_UNDEFINED;
+    event.data.mouse.screen_x = event.data.mouse.x;
+    event.data.mouse.screen_y = event.data.mouse.y;
 
     logger(LOG_LEVEL_DEBUG, "%s [%u]: Button %u released %u time(s). (%u, %u)\n",
             __FUNCTION__, __LINE__, event.data.mouse.button,
@@ -367,6 +373,9 @@ static void process_button_released(MSLLHOOKSTRUCT *mshook, uint16_t button) {
         event.data.mouse.clicks = click_count;
         event.data.mouse.x = (int16_t) mshook->pt.x;
         event.data.mouse.y = (int16_t) mshook->pt.y;
+        event.data.mouse.screen = SCREEN_UNDEFINED;
+        event.data.mouse.screen_x = event.data.mouse.x;
+        event.data.mouse.screen_y = event.data.mouse.y;
 
         logger(LOG_LEVEL_DEBUG, "%s [%u]: Button %u clicked %u time(s). (%u, %u)\n",
                 __FUNCTION__, __LINE__, event.data.mouse.button, event.data.mouse.clicks,
@@ -414,6 +423,9 @@ static void process_mouse_moved(MSLLHOOKSTRUCT *mshook) {
         event.data.mouse.clicks = click_count;
         event.data.mouse.x = (int16_t) mshook->pt.x;
         event.data.mouse.y = (int16_t) mshook->pt.y;
+        event.data.mouse.screen = SCREEN_UNDEFINED;
+        event.data.mouse.screen_x = event.data.mouse.x;
+        event.data.mouse.screen_y = event.data.mouse.y;
 
         logger(LOG_LEVEL_DEBUG, "%s [%u]: Mouse %s to %u, %u.\n",
                 __FUNCTION__, __LINE__,  mouse_dragged ? "dragged" : "moved",
@@ -440,6 +452,9 @@ static void process_mouse_wheel(MSLLHOOKSTRUCT *mshook, uint8_t direction) {
     event.data.wheel.clicks = click_count;
     event.data.wheel.x = (int16_t) mshook->pt.x;
     event.data.wheel.y = (int16_t) mshook->pt.y;
+    event.data.wheel.screen = SCREEN_UNDEFINED;
+    event.data.wheel.screen_x = event.data.wheel.x;
+    event.data.wheel.screen_y = event.data.wheel.y;
 
     event.data.wheel.rotation = get_scroll_wheel_rotation(mshook->mouseData, direction);
 
@@ -725,3 +740,32 @@ UIOHOOK_API int hook_stop() {
 
     return status;
 }
+
+UIOHOOK_API int hook_recorder_start(const char *path, const recorder_options *options) {
+    (void) path;
+    (void) options;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Recording is not supported on this platform!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
+
+UIOHOOK_API int hook_recorder_stop(recorder_stats *stats) {
+    (void) stats;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Recording is not supported on this platform!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
+
+UIOHOOK_API int hook_set_replay_source(const char *path, double speed) {
+    (void) path;
+    (void) speed;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Replay sources are not supported on this platform!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
@@ -16,7 +16,9 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <uiohook.h>
 #include <windows.h>
 
@@ -246,3 +248,78 @@ UIOHOOK_API void hook_post_event(uiohook_event * const event) {
 
     free(input);
 }
+
+UIOHOOK_API int hook_post_text(const char *utf8, size_t length) {
+    if (length == 0) {
+        return UIOHOOK_SUCCESS;
+    } else if (length > INT_MAX) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Text length overflow detected!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+
+    int count = MultiByteToWideChar(CP_UTF8, 0, utf8, (int) length, NULL, 0);
+    if (count == 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: MultiByteToWideChar() failed! (%#lX)\n",
+                __FUNCTION__, __LINE__, (unsigned long) GetLastError());
+        return UIOHOOK_FAILURE;
+    }
+
+    WCHAR *buffer = (WCHAR *) malloc(sizeof(WCHAR) * count);
+    INPUT *inputs = (INPUT *) calloc(count * 2, sizeof(INPUT));
+    if (buffer == NULL || inputs == NULL) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: failed to allocate memory: calloc!\n",
+                __FUNCTION__, __LINE__);
+
+        free(buffer);
+        free(inputs);
+        return UIOHOOK_ERROR_OUT_OF_MEMORY;
+    }
+
+    MultiByteToWideChar(CP_UTF8, 0, utf8, (int) length, buffer, count);
+
+    // Each UTF-16 code unit is sent as a press and release pair in a single SendInput() call.
+    for (int i = 0; i < count; i++) {
+        inputs[i * 2].type = INPUT_KEYBOARD;
+        inputs[i * 2].ki.wScan = buffer[i];
+        inputs[i * 2].ki.dwFlags = KEYEVENTF_UNICODE;
+
+        inputs[i * 2 + 1].type = INPUT_KEYBOARD;
+        inputs[i * 2 + 1].ki.wScan = buffer[i];
+        inputs[i * 2 + 1].ki.dwFlags = KEYEVENTF_UNICODE | KEYEVENTF_KEYUP;
+    }
+
+    int status = UIOHOOK_SUCCESS;
+    if (SendInput(count * 2, inputs, sizeof(INPUT)) != (UINT) count * 2) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: SendInput() failed! (%#lX)\n",
+                __FUNCTION__, __LINE__, (unsigned long) GetLastError());
+
+        status = UIOHOOK_FAILURE;
+    }
+
+    free(buffer);
+    free(inputs);
+
+    return status;
+}
+
+UIOHOOK_API int hook_post_motion_path(const motion_path *path) {
+    (void) path;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Motion paths are not supported on this platform!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
+
+UIOHOOK_API int hook_replay_events(const uiohook_event *events, size_t count, double speed, replay_stats *stats) {
+    (void) events;
+    (void) count;
+    (void) speed;
+    (void) stats;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Event replay is not supported on this platform!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
@@ -16,6 +16,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdlib.h>
+#include <string.h>
 #include <uiohook.h>
 #include <windows.h>
 
@@ -122,6 +124,22 @@ UIOHOOK_API screen_data* hook_create_screen_info(unsigned char *count) {
     return screens.data;
 }
 
+UIOHOOK_API int hook_get_screen_info(screen_data *screens, unsigned char *count) {
+    if (count == NULL || (screens == NULL && *count > 0)) {
+        return UIOHOOK_FAILURE;
+    }
+
+    unsigned char total = 0;
+    screen_data *info = hook_create_screen_info(&total);
+    if (info != NULL) {
+        memcpy(screens, info, sizeof(screen_data) * (total < *count ? total : *count));
+        free(info);
+    }
+    *count = total;
+
+    return UIOHOOK_SUCCESS;
+}
+
 UIOHOOK_API long int hook_get_auto_repeat_rate() {
     long int value = -1;
     long int rate;
@@ -208,6 +226,21 @@ UIOHOOK_API long int hook_get_multi_click_time() {
     return value;
 }
 
+UIOHOOK_API int hook_get_system_properties(system_properties *properties) {
+    if (properties == NULL) {
+        return UIOHOOK_FAILURE;
+    }
+
+    properties->auto_repeat_rate = hook_get_auto_repeat_rate();
+    properties->auto_repeat_delay = hook_get_auto_repeat_delay();
+    properties->pointer_acceleration_multiplier = hook_get_pointer_acceleration_multiplier();
+    properties->pointer_acceleration_threshold = hook_get_pointer_acceleration_threshold();
+    properties->pointer_sensitivity = hook_get_pointer_sensitivity();
+    properties->multi_click_time = hook_get_multi_click_time();
+
+    return UIOHOOK_SUCCESS;
+}
+
 // DLL Entry point.
 BOOL WINAPI DllMain(HINSTANCE hInstDLL, DWORD fdwReason, LPVOID lpReserved) {
     switch (fdwReason) {
@@ -0,0 +1,108 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <uiohook.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/timerfd.h>
+#endif
+
+#include "deadline_timer.h"
+#include "logger.h"
+
+#define NSEC_PER_SEC 1000000000ULL
+
+uint64_t deadline_timer_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * NSEC_PER_SEC + (uint64_t) now.tv_nsec;
+}
+
+bool deadline_timer_init(deadline_timer *timer) {
+    #ifdef __linux__
+    timer->fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (timer->fd < 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: timerfd_create() failed! (%d)\n",
+                __FUNCTION__, __LINE__, errno);
+        return false;
+    }
+    #else
+    timer->fd = -1;
+    #endif
+
+    return true;
+}
+
+bool deadline_timer_wait(deadline_timer *timer, uint64_t deadline) {
+    if (deadline <= deadline_timer_now()) {
+        return true;
+    }
+
+    struct timespec expire = {
+        .tv_sec = (time_t) (deadline / NSEC_PER_SEC),
+        .tv_nsec = (long) (deadline % NSEC_PER_SEC)
+    };
+
+    #ifdef __linux__
+    struct itimerspec spec = {
+        .it_interval = { 0, 0 },
+        .it_value = expire
+    };
+
+    if (timerfd_settime(timer->fd, TFD_TIMER_ABSTIME, &spec, NULL) != 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: timerfd_settime() failed! (%d)\n",
+                __FUNCTION__, __LINE__, errno);
+        return false;
+    }
+
+    uint64_t expirations;
+    while (read(timer->fd, &expirations, sizeof(expirations)) < 0) {
+        if (errno != EINTR) {
+            logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to read timerfd! (%d)\n",
+                    __FUNCTION__, __LINE__, errno);
+            return false;
+        }
+    }
+    #else
+    int status;
+    while ((status = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &expire, NULL)) == EINTR);
+
+    if (status != 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: clock_nanosleep() failed! (%d)\n",
+                __FUNCTION__, __LINE__, status);
+        return false;
+    }
+    #endif
+
+    return true;
+}
+
+void deadline_timer_destroy(deadline_timer *timer) {
+    #ifdef __linux__
+    if (timer->fd >= 0) {
+        close(timer->fd);
+    }
+    #endif
+
+    timer->fd = -1;
+}
@@ -0,0 +1,49 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _included_deadline_timer
+#define _included_deadline_timer
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Blocks the calling thread until absolute CLOCK_MONOTONIC deadlines.
+typedef struct _deadline_timer {
+    int fd;
+} deadline_timer;
+
+/* Returns the current CLOCK_MONOTONIC time in nanoseconds.
+ */
+extern uint64_t deadline_timer_now();
+
+/* Initialize a deadline timer.  On Linux this creates a timerfd, elsewhere
+ * clock_nanosleep() with TIMER_ABSTIME is used.  Returns false on failure.
+ */
+extern bool deadline_timer_init(deadline_timer *timer);
+
+/* Sleep until the absolute CLOCK_MONOTONIC deadline in nanoseconds.  Returns
+ * immediately if the deadline has already passed.  Because deadlines are
+ * absolute, time spent between waits does not accumulate as drift.
+ */
+extern bool deadline_timer_wait(deadline_timer *timer, uint64_t deadline);
+
+/* Release resources held by a deadline timer.
+ */
+extern void deadline_timer_destroy(deadline_timer *timer);
+
+#endif
@@ -0,0 +1,333 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <uiohook.h>
+#include <unistd.h>
+
+#include "deadline_timer.h"
+#include "dispatch_event.h"
+#include "file_source.h"
+#include "input_helper.h"
+#include "logger.h"
+#include "recorder.h"
+
+// Longest single sleep so file_source_stop() is noticed while pacing long gaps.
+#define FILE_SOURCE_WAIT_SLICE    100 * 1000000ULL
+
+static char *source_path = NULL;
+static double source_speed = 0;
+
+static bool running = false;
+
+UIOHOOK_API int hook_set_replay_source(const char *path, double speed) {
+    if (!(speed >= 0)) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: Invalid replay speed!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+
+    char *copy = NULL;
+    if (path != NULL) {
+        copy = (char *) malloc(strlen(path) + 1);
+        if (copy == NULL) {
+            logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to allocate memory for replay source path!\n",
+                    __FUNCTION__, __LINE__);
+            return UIOHOOK_ERROR_OUT_OF_MEMORY;
+        }
+
+        strcpy(copy, path);
+    }
+
+    free(source_path);
+    source_path = copy;
+    source_speed = speed;
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Replay source set to %s at speed %f.\n",
+            __FUNCTION__, __LINE__, path != NULL ? path : "(live)", speed);
+
+    return UIOHOOK_SUCCESS;
+}
+
+bool file_source_enabled() {
+    return source_path != NULL;
+}
+
+bool file_source_running() {
+    return __atomic_load_n(&running, __ATOMIC_ACQUIRE);
+}
+
+// Check the header of a mapped recording and return the offset of the first record, or 0 if invalid.
+static size_t validate_recording(const uint8_t *base, size_t size) {
+    if (size < sizeof(recording_header)) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Recording is too small to contain a header!\n",
+                __FUNCTION__, __LINE__);
+        return 0;
+    }
+
+    const recording_header *header = (const recording_header *) base;
+    if (memcmp(header->magic, RECORDING_MAGIC, sizeof(header->magic)) != 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Invalid recording magic!\n",
+                __FUNCTION__, __LINE__);
+        return 0;
+    }
+
+    if (header->byte_order != RECORDING_BYTE_ORDER) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Recording byte order does not match the host!\n",
+                __FUNCTION__, __LINE__);
+        return 0;
+    }
+
+    if (header->version != RECORDING_VERSION || header->record_size != sizeof(recording_record)) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Unsupported recording version %u with record size %u!\n",
+                __FUNCTION__, __LINE__, header->version, header->record_size);
+        return 0;
+    }
+
+    if (header->header_size < sizeof(recording_header) || header->header_size % 8 != 0 || header->header_size > size) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Invalid recording header size %u!\n",
+                __FUNCTION__, __LINE__, header->header_size);
+        return 0;
+    }
+
+    return header->header_size;
+}
+
+// Copy a record into an event so the data union can be read with its natural alignment.
+static inline void read_record(const recording_record *record, uiohook_event *event) {
+    event->time = record->time;
+    event->type = record->type;
+    event->mask = record->mask;
+    event->reserved = 0x00;
+    event->device = DEVICE_UNDEFINED;
+    event->device_class = DEVICE_CLASS_UNKNOWN;
+    memcpy(&event->data, record->data, sizeof(record->data));
+}
+
+/* Load the recorded screen layout into the dispatch screen index, moved the
+ * same way the hook moved the recorded coordinates.
+ */
+static void load_recorded_screens(const uint8_t *base, size_t offset) {
+    const recording_header *header = (const recording_header *) base;
+    const recording_screen *recorded = (const recording_screen *) (base + sizeof(recording_header));
+
+    screen_data screens[UINT8_MAX];
+    uint8_t count = 0;
+    if (sizeof(recording_header) + sizeof(recording_screen) * header->screen_count <= offset) {
+        for (; count < header->screen_count && count < UINT8_MAX; count++) {
+            screens[count] = (screen_data) {
+                .number = recorded[count].number,
+                .x = recorded[count].x,
+                .y = recorded[count].y,
+                .width = recorded[count].width,
+                .height = recorded[count].height
+            };
+        }
+    }
+
+    #if defined(USE_XINERAMA) || defined(USE_XRANDR)
+    if (count > 1) {
+        int16_t origin_x = screens[0].x, origin_y = screens[0].y;
+        for (uint8_t i = 0; i < count; i++) {
+            screens[i].x -= origin_x;
+            screens[i].y -= origin_y;
+        }
+    }
+    #endif
+
+    dispatch_set_screens(screens, count);
+}
+
+// Sleep until the deadline in slices so a stop request is not delayed by long gaps.
+static bool wait_until(deadline_timer *timer, uint64_t deadline) {
+    uint64_t now = deadline_timer_now();
+    while (now + FILE_SOURCE_WAIT_SLICE < deadline) {
+        if (!deadline_timer_wait(timer, now + FILE_SOURCE_WAIT_SLICE)) {
+            return false;
+        }
+
+        if (!__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+            return true;
+        }
+
+        now = deadline_timer_now();
+    }
+
+    return deadline_timer_wait(timer, deadline);
+}
+
+static void replay_records(const recording_record *records, size_t count, deadline_timer *timer) {
+    uiohook_event event;
+    uint16_t chars[2];
+
+    uint64_t start = deadline_timer_now();
+    for (size_t i = 0; i < count && __atomic_load_n(&running, __ATOMIC_ACQUIRE); i++) {
+        read_record(&records[i], &event);
+
+        /* Typed and clicked events are synthesized again by the shared dispatch
+         * functions, and a recorded screen change does not describe the current layout.
+         */
+        if (event.type == EVENT_KEY_TYPED || event.type == EVENT_MOUSE_CLICKED
+                || event.type == EVENT_HOOK_ENABLED || event.type == EVENT_HOOK_DISABLED
+                || event.type == EVENT_SCREEN_CHANGED) {
+            continue;
+        }
+
+        if (timer != NULL) {
+            // Deadlines are relative to the first record so scheduling latency never accumulates.
+            uint64_t offset = event.time > records[0].time ? event.time - records[0].time : 0;
+            if (!wait_until(timer, start + (uint64_t) (offset * 1000000 / source_speed))) {
+                break;
+            }
+        }
+
+        /* The recorded mask already reflects lock keys and modifiers held
+         * before the recording started, the dispatch functions then apply
+         * the change caused by the event itself.
+         */
+        unset_modifier_mask(0xFFFF);
+        set_modifier_mask(event.mask);
+
+        switch (event.type) {
+            case EVENT_KEY_PRESSED: {
+                // Prefer the characters that were typed when recording, they reflect the keyboard layout in use.
+                size_t length = 0;
+                for (size_t j = i + 1; j < count && records[j].type == EVENT_KEY_TYPED && length < sizeof(chars) / sizeof(uint16_t); j++) {
+                    uiohook_event typed;
+                    read_record(&records[j], &typed);
+                    chars[length++] = typed.data.keyboard.keychar;
+                }
+
+                if (length == 0) {
+                    length = keysym_to_unicode(event.data.keyboard.rawcode, chars, sizeof(chars) / sizeof(uint16_t));
+                }
+
+                dispatch_key_press(event.time, event.data.keyboard.keycode, event.data.keyboard.rawcode, chars, length);
+                break;
+            }
+
+            case EVENT_KEY_RELEASED:
+                dispatch_key_release(event.time, event.data.keyboard.keycode, event.data.keyboard.rawcode);
+                break;
+
+            case EVENT_MOUSE_PRESSED:
+                dispatch_mouse_press(event.time, event.data.mouse.button, event.data.mouse.x, event.data.mouse.y);
+                break;
+
+            case EVENT_MOUSE_RELEASED:
+                dispatch_mouse_release(event.time, event.data.mouse.button, event.data.mouse.x, event.data.mouse.y);
+                break;
+
+            case EVENT_MOUSE_MOVED:
+            case EVENT_MOUSE_DRAGGED:
+                dispatch_mouse_move(event.time, event.data.mouse.x, event.data.mouse.y);
+                break;
+
+            case EVENT_MOUSE_WHEEL:
+                dispatch_mouse_wheel(event.time, event.data.wheel.x, event.data.wheel.y,
+                        event.data.wheel.type, event.data.wheel.amount,
+                        event.data.wheel.rotation, event.data.wheel.direction);
+                break;
+
+            default:
+                logger(LOG_LEVEL_WARN, "%s [%u]: Ignoring unknown recorded event type %u.\n",
+                        __FUNCTION__, __LINE__, event.type);
+                break;
+        }
+    }
+}
+
+int file_source_run() {
+    int fd = open(source_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to open recording %s! (%d)\n",
+                __FUNCTION__, __LINE__, source_path, errno);
+        return UIOHOOK_FAILURE;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to stat recording %s! (%d)\n",
+                __FUNCTION__, __LINE__, source_path, errno);
+        close(fd);
+        return UIOHOOK_FAILURE;
+    }
+
+    size_t size = (size_t) info.st_size;
+    uint8_t *base = (uint8_t *) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to map recording %s! (%d)\n",
+                __FUNCTION__, __LINE__, source_path, errno);
+        return UIOHOOK_FAILURE;
+    }
+
+    // Records are only read once, front to back.
+    madvise(base, size, MADV_SEQUENTIAL);
+
+    int status = UIOHOOK_FAILURE;
+    size_t offset = validate_recording(base, size);
+    if (offset > 0) {
+        const recording_record *records = (const recording_record *) (base + offset);
+        size_t count = (size - offset) / sizeof(recording_record);
+
+        logger(LOG_LEVEL_DEBUG, "%s [%u]: Replaying %zu recorded events from %s.\n",
+                __FUNCTION__, __LINE__, count, source_path);
+
+        deadline_timer timer;
+        bool paced = source_speed > 0;
+        if (!paced || deadline_timer_init(&timer)) {
+            // Running first so the settings thread no longer replaces the recorded multi-click time.
+            __atomic_store_n(&running, true, __ATOMIC_RELEASE);
+            dispatch_set_multi_click_time(((const recording_header *) base)->multi_click_time);
+            dispatch_reset(0x0000);
+            load_recorded_screens(base, offset);
+
+            dispatch_hook_enabled(count > 0 ? records[0].time : 0);
+            replay_records(records, count, paced ? &timer : NULL);
+            dispatch_hook_disabled(count > 0 ? records[count - 1].time : 0);
+
+            __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+
+            if (paced) {
+                deadline_timer_destroy(&timer);
+            }
+
+            status = UIOHOOK_SUCCESS;
+        }
+    }
+
+    munmap(base, size);
+
+    return status;
+}
+
+int file_source_stop() {
+    if (!__atomic_exchange_n(&running, false, __ATOMIC_ACQ_REL)) {
+        return UIOHOOK_FAILURE;
+    }
+
+    return UIOHOOK_SUCCESS;
+}
@@ -0,0 +1,43 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _included_file_source
+#define _included_file_source
+
+#include <stdbool.h>
+
+/* Returns true if hook_set_replay_source() selected a recording to replace
+ * the live XRecord source.
+ */
+extern bool file_source_enabled();
+
+// Returns true while file_source_run() is dispatching a recording.
+extern bool file_source_running();
+
+/* Memory map the selected recording and dispatch its events through the same
+ * post-processing as the live hook.  Blocks until the end of the recording or
+ * until file_source_stop() is called.  This method is called by hook_run().
+ */
+extern int file_source_run();
+
+/* Stop a running file source.  Returns UIOHOOK_FAILURE if no recording is
+ * being replayed.  This method is called by hook_stop().
+ */
+extern int file_source_stop();
+
+#endif
@@ -0,0 +1,353 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <uiohook.h>
+
+#include <X11/Xlib.h>
+#include <X11/extensions/XInput2.h>
+
+#include "dispatch_event.h"
+#include "input_device.h"
+#include "logger.h"
+
+// Raw events kept while waiting for the recorded event of the same input.
+#define PENDING_EVENTS_SIZE 32
+
+// Longest wait in milliseconds for a raw event that arrives after the recorded event.
+#define RAW_EVENT_TIMEOUT 2
+
+typedef struct _pending_event {
+    int type;                   // Core event type of the raw event.
+    unsigned int detail;
+    Time time;
+    uint8_t device;
+} pending_event;
+
+/* XRecord only sees core events, which carry no device.  The server also sends
+ * every master device raw event to this display, tagged with the slave device
+ * that produced it and the same timestamp as the core event.  Owned by the
+ * hook thread.
+ */
+typedef struct _device_source {
+    Display *display;
+    int opcode;
+    Atom pressure;
+    size_t count;
+    pending_event pending[PENDING_EVENTS_SIZE];
+    uint8_t held[32];           // Key codes pressed according to the recorded events.
+    unsigned int release_detail;
+    Time release_time;          // Time of the last recorded key release.
+} device_source;
+static device_source source;
+
+static int raw_to_core_type(int evtype) {
+    switch (evtype) {
+        case XI_RawKeyPress:      return KeyPress;
+        case XI_RawKeyRelease:    return KeyRelease;
+        case XI_RawButtonPress:   return ButtonPress;
+        case XI_RawButtonRelease: return ButtonRelease;
+        case XI_RawMotion:        return MotionNotify;
+        default:                  return 0;
+    }
+}
+
+static bool name_contains(const char *name, const char *word) {
+    size_t length = strlen(word);
+    for (; *name != '\0'; name++) {
+        if (strncasecmp(name, word, length) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static uint8_t classify_device(const XIDeviceInfo *info) {
+    if (info->use == XISlaveKeyboard) {
+        return DEVICE_CLASS_KEYBOARD;
+    }
+
+    bool pressure = false;
+    for (int i = 0; i < info->num_classes; i++) {
+        if (info->classes[i]->type == XITouchClass) {
+            // Touchpads report touches that depend on the pointer, touchscreens report them directly.
+            XITouchClassInfo *touch = (XITouchClassInfo *) info->classes[i];
+            return touch->mode == XIDirectTouch ? DEVICE_CLASS_TOUCHSCREEN : DEVICE_CLASS_TOUCHPAD;
+        } else if (info->classes[i]->type == XIValuatorClass) {
+            XIValuatorClassInfo *valuator = (XIValuatorClassInfo *) info->classes[i];
+            if (source.pressure != None && valuator->label == source.pressure) {
+                pressure = true;
+            }
+        }
+    }
+
+    // Drivers without multitouch support only identify touchpads by name.
+    if (name_contains(info->name, "touchpad")) {
+        return DEVICE_CLASS_TOUCHPAD;
+    } else if (pressure) {
+        return DEVICE_CLASS_TABLET;
+    }
+
+    return DEVICE_CLASS_MOUSE;
+}
+
+// Query the slave devices and pass them to the dispatcher.
+static void load_device_table() {
+    device_info devices[UINT8_MAX];
+    uint8_t count = 0;
+
+    int total = 0;
+    XIDeviceInfo *info = XIQueryDevice(source.display, XIAllDevices, &total);
+    if (info != NULL) {
+        for (int i = 0; i < total && count < UINT8_MAX; i++) {
+            // Master devices never produce input and floating slaves are not attached to one.
+            if (info[i].use != XISlaveKeyboard && info[i].use != XISlavePointer) {
+                continue;
+            } else if (info[i].deviceid <= DEVICE_UNDEFINED || info[i].deviceid > UINT8_MAX) {
+                logger(LOG_LEVEL_WARN, "%s [%u]: Ignoring device id %d out of range!\n",
+                        __FUNCTION__, __LINE__, info[i].deviceid);
+                continue;
+            }
+
+            devices[count].id = (uint8_t) info[i].deviceid;
+            devices[count].device_class = classify_device(&info[i]);
+            strncpy(devices[count].name, info[i].name, DEVICE_NAME_SIZE - 1);
+            devices[count].name[DEVICE_NAME_SIZE - 1] = '\0';
+
+            logger(LOG_LEVEL_DEBUG, "%s [%u]: Device %u class %u: %s.\n",
+                    __FUNCTION__, __LINE__, devices[count].id, devices[count].device_class, devices[count].name);
+            count++;
+        }
+
+        XIFreeDeviceInfo(info);
+    } else {
+        logger(LOG_LEVEL_WARN, "%s [%u]: XIQueryDevice failed!\n",
+                __FUNCTION__, __LINE__);
+    }
+
+    dispatch_set_devices(devices, count);
+}
+
+static void push_pending(int type, unsigned int detail, Time time, int device) {
+    if (source.count == PENDING_EVENTS_SIZE) {
+        // The oldest raw event can no longer be matched.
+        memmove(&source.pending[0], &source.pending[1], sizeof(pending_event) * (PENDING_EVENTS_SIZE - 1));
+        source.count--;
+    }
+
+    pending_event *pending = &source.pending[source.count++];
+    pending->type = type;
+    pending->detail = detail;
+    pending->time = time;
+    pending->device = device > DEVICE_UNDEFINED && device <= UINT8_MAX ? (uint8_t) device : DEVICE_UNDEFINED;
+}
+
+// Read the events already received without blocking, reloading the devices if the hierarchy changed.
+static void read_device_events() {
+    bool hierarchy_changed = false;
+
+    while (XEventsQueued(source.display, QueuedAfterReading) > 0) {
+        XEvent event;
+        XNextEvent(source.display, &event);
+
+        // Xlib allocates the data of every generic event as it is read.
+        XGenericEventCookie *cookie = &event.xcookie;
+        if (cookie->type != GenericEvent || cookie->extension != source.opcode || !XGetEventData(source.display, cookie)) {
+            continue;
+        }
+
+        if (cookie->evtype == XI_HierarchyChanged) {
+            hierarchy_changed = true;
+        } else {
+            XIRawEvent *raw = (XIRawEvent *) cookie->data;
+            push_pending(raw_to_core_type(raw->evtype), (unsigned int) raw->detail, raw->time, raw->sourceid);
+        }
+
+        XFreeEventData(source.display, cookie);
+    }
+
+    if (hierarchy_changed) {
+        load_device_table();
+    }
+}
+
+/* Find the raw event of a recorded event.  Raw buttons are not mapped, so a
+ * raw event with the same type and time is used when no detail matches.
+ * Returns source.count if there is none.  Raw events older than the recorded
+ * event were never recorded, stale is set to the number of those.
+ */
+static size_t find_pending(int type, unsigned int detail, Time time, size_t *stale, bool *newer) {
+    size_t match = source.count;
+    *stale = 0;
+    *newer = false;
+    for (size_t i = 0; i < source.count; i++) {
+        const pending_event *pending = &source.pending[i];
+        int32_t delta = (int32_t) ((uint32_t) pending->time - (uint32_t) time);
+        if (delta < 0) {
+            *stale = i + 1;
+        } else if (delta > 0) {
+            *newer = true;
+        } else if (pending->type == type) {
+            if (pending->detail == detail) {
+                match = i;
+                break;
+            } else if (match == source.count) {
+                match = i;
+            }
+        }
+    }
+
+    return match;
+}
+
+/* Returns false for recorded events that may have no raw event.  Auto-repeat
+ * is generated by the server as a release and press pair with the same time,
+ * or a press of a key that is still held, and pointer warps only produce
+ * motion.  Releases are never waited for because a repeated release looks
+ * like any other release until the press that follows it.
+ */
+static bool expect_raw_event(int type, unsigned int detail, Time time) {
+    bool expected = false;
+    uint8_t bit = (uint8_t) (1 << (detail % 8));
+
+    switch (type) {
+        case KeyPress:
+            expected = !(source.held[detail / 8] & bit)
+                    && !(detail == source.release_detail && time == source.release_time);
+            source.held[detail / 8] |= bit;
+            break;
+
+        case KeyRelease:
+            source.held[detail / 8] &= (uint8_t) ~bit;
+            source.release_detail = detail;
+            source.release_time = time;
+            break;
+
+        case ButtonPress:
+        case ButtonRelease:
+            expected = true;
+            break;
+    }
+
+    return expected;
+}
+
+uint8_t lookup_input_device(int type, unsigned int detail, Time time) {
+    if (source.display == NULL) {
+        return DEVICE_UNDEFINED;
+    }
+
+    bool expected = detail < sizeof(source.held) * 8 && expect_raw_event(type, detail, time);
+
+    read_device_events();
+
+    size_t stale;
+    bool newer;
+    size_t match = find_pending(type, detail, time, &stale, &newer);
+
+    /* The raw event is sent to a different connection and may not have been
+     * read yet.  Raw events are sent in order, so there is nothing to wait
+     * for once a later one arrived.
+     */
+    if (match == source.count && !newer && expected) {
+        struct pollfd pfd = { .fd = ConnectionNumber(source.display), .events = POLLIN };
+        if (poll(&pfd, 1, RAW_EVENT_TIMEOUT) > 0) {
+            read_device_events();
+            match = find_pending(type, detail, time, &stale, &newer);
+        }
+    }
+
+    uint8_t device = DEVICE_UNDEFINED;
+    if (match < source.count) {
+        device = source.pending[match].device;
+        memmove(&source.pending[match], &source.pending[match + 1], sizeof(pending_event) * (source.count - match - 1));
+        source.count--;
+    }
+
+    if (stale > 0) {
+        memmove(&source.pending[0], &source.pending[stale], sizeof(pending_event) * (source.count - stale));
+        source.count -= stale;
+    }
+
+    return device;
+}
+
+bool load_input_devices() {
+    source.count = 0;
+    memset(source.held, 0, sizeof(source.held));
+    source.release_time = CurrentTime;
+    source.display = XOpenDisplay(NULL);
+    if (source.display == NULL) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: XOpenDisplay failure!\n",
+                __FUNCTION__, __LINE__);
+        return false;
+    }
+
+    int event, error, major = 2, minor = 2;
+    if (!XQueryExtension(source.display, "XInputExtension", &source.opcode, &event, &error)
+            || XIQueryVersion(source.display, &major, &minor) != Success) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: XInput2 2.2 is not available!\n",
+                __FUNCTION__, __LINE__);
+
+        XCloseDisplay(source.display);
+        source.display = NULL;
+        return false;
+    }
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: XInput2 version: %i.%i.\n",
+            __FUNCTION__, __LINE__, major, minor);
+
+    // Raw events from master devices are sent to the root window even while another client holds a grab.
+    unsigned char hierarchy_mask[XIMaskLen(XI_LASTEVENT)] = { 0 };
+    XISetMask(hierarchy_mask, XI_HierarchyChanged);
+
+    unsigned char raw_mask[XIMaskLen(XI_LASTEVENT)] = { 0 };
+    XISetMask(raw_mask, XI_RawKeyPress);
+    XISetMask(raw_mask, XI_RawKeyRelease);
+    XISetMask(raw_mask, XI_RawButtonPress);
+    XISetMask(raw_mask, XI_RawButtonRelease);
+    XISetMask(raw_mask, XI_RawMotion);
+
+    XIEventMask masks[] = {
+        { .deviceid = XIAllDevices, .mask_len = sizeof(hierarchy_mask), .mask = hierarchy_mask },
+        { .deviceid = XIAllMasterDevices, .mask_len = sizeof(raw_mask), .mask = raw_mask }
+    };
+    XISelectEvents(source.display, DefaultRootWindow(source.display), masks, sizeof(masks) / sizeof(masks[0]));
+
+    source.pressure = XInternAtom(source.display, "Abs Pressure", True);
+
+    // The query is a round trip, so the selection is active once the table is loaded.
+    load_device_table();
+
+    return true;
+}
+
+void unload_input_devices() {
+    if (source.display != NULL) {
+        XCloseDisplay(source.display);
+        source.display = NULL;
+    }
+
+    source.count = 0;
+    dispatch_set_devices(NULL, 0);
+}
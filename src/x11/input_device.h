@@ -0,0 +1,46 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _included_input_device
+#define _included_input_device
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <X11/Xlib.h>
+
+/* Open the device display, select XInput2 raw and hierarchy events and pass
+ * the device list to the dispatcher.  Returns false if XInput2 2.2 is not
+ * available, events are then dispatched without a source device.  This method
+ * is called by the hook thread before recording starts.
+ */
+extern bool load_input_devices();
+
+// Close the device display and forget the pending raw events.
+extern void unload_input_devices();
+
+/* Returns the source device of a recorded core event by matching it with the
+ * raw event the server sent for the same input, or DEVICE_UNDEFINED if there
+ * is no match.  Device hierarchy changes queued before the event are applied
+ * first.  If the raw event has not arrived yet, this waits for it for at most
+ * a few milliseconds, but only for button events and key presses that are not
+ * auto-repeated.  Other events are matched against the raw events already
+ * received without blocking.
+ */
+extern uint8_t lookup_input_device(int type, unsigned int detail, Time time);
+
+#endif
@@ -16,12 +16,14 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <X11/keysym.h>
 #include <X11/Xlib.h>
+#include <X11/Xutil.h>
 
 #ifdef USE_EVDEV
 #include <linux/input.h>
@@ -55,6 +57,34 @@ static struct xkb_rule_names xkb_names = {
 static unsigned char *mouse_button_map;
 Display *helper_disp;
 
+#define KEYSYM_CACHE_SIZE 256
+
+// Client side copy of the core keyboard mapping used to resolve key symbols.
+static KeySym *keysym_map = NULL;
+static int keysym_map_min = 0, keysym_map_max = 0, keysym_map_width = 0;
+
+// Direct mapped cache of recently resolved key symbols.
+static struct keysym_cache_entry {
+    KeySym keysym;
+    KeyCode keycode;
+    unsigned char level;
+} keysym_cache[KEYSYM_CACHE_SIZE];
+
+// Unused key codes that may be temporarily bound to unmapped key symbols.
+static struct spare_keycode {
+    KeyCode keycode;
+    KeySym keysym;
+} *spare_keycodes = NULL;
+static unsigned int spare_keycode_count = 0, spare_keycode_next = 0;
+
+/* Key codes changed on the server since the keyboard mapping was loaded, one
+ * bit per key code, reported by the settings thread through
+ * invalidate_keysym_map().
+ */
+static pthread_mutex_t keysym_map_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t keysym_map_stale[32];
+static bool keysym_map_changed = false;
+
 /* The following two tables are based on QEMU's x_keymap.c, under the following
  * terms:
  *
@@ -1641,6 +1671,25 @@ KeyCode scancode_to_keycode(uint16_t scancode) {
     return keycode;
 }
 
+#ifdef USE_EVDEV
+uint16_t scancode_to_evdev(uint16_t scancode) {
+    uint16_t code = 0x0000;
+
+    unsigned short evdev_size = sizeof(evdev_scancode_table) / sizeof(evdev_scancode_table[0]);
+    if (scancode >= 128) {
+        // Offset is the lower order bits + 128
+        scancode = (scancode & 0x007F) | 0x80;
+    }
+
+    // The evdev X11 key codes are offset by 8 from the kernel input codes.
+    if (scancode < evdev_size && evdev_scancode_table[scancode][1] >= 8) {
+        code = evdev_scancode_table[scancode][1] - 8;
+    }
+
+    return code;
+}
+#endif
+
 #ifdef USE_XKB_COMMON
 struct xkb_state * create_xkb_state(struct xkb_context *context, xcb_connection_t *connection) {
     struct xkb_keymap *keymap = NULL;
@@ -1657,6 +1706,11 @@ struct xkb_state * create_xkb_state(struct xkb_context *context, xcb_connection_
         logger(LOG_LEVEL_WARN, "%s [%u]: Unable to retrieve core keyboard device id! (%d)\n",
                 __FUNCTION__, __LINE__, device_id);
 
+        // Compiling from names requires the default include paths.
+        if (xkb_context_num_include_paths(context) == 0) {
+            xkb_context_include_path_append_default(context);
+        }
+
         keymap = xkb_keymap_new_from_names(context, &xkb_names, XKB_KEYMAP_COMPILE_NO_FLAGS);
         state = xkb_state_new(keymap);
     }
@@ -1757,6 +1811,263 @@ KeySym keycode_to_keysym(KeyCode keycode, unsigned int modifier_mask) {
 }
 #endif
 
+// Load a client side copy of the core keyboard mapping and locate the spare key codes.
+static bool load_keysym_map() {
+    if (helper_disp == NULL) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: XDisplay helper_disp is unavailable!\n",
+            __FUNCTION__, __LINE__);
+        return false;
+    }
+
+    XDisplayKeycodes(helper_disp, &keysym_map_min, &keysym_map_max);
+    keysym_map = XGetKeyboardMapping(helper_disp, keysym_map_min, keysym_map_max - keysym_map_min + 1, &keysym_map_width);
+    if (keysym_map == NULL) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: XGetKeyboardMapping failed to return the keyboard mapping!\n",
+                __FUNCTION__, __LINE__);
+        return false;
+    }
+
+    memset(keysym_cache, 0x00, sizeof(keysym_cache));
+
+    // Any key code without a single key symbol may be bound on demand.
+    unsigned int count = 0;
+    KeySym *spare_map = malloc(sizeof(KeySym) * (keysym_map_max - keysym_map_min + 1));
+    for (int i = 0; spare_map != NULL && i <= keysym_map_max - keysym_map_min; i++) {
+        int j = 0;
+        while (j < keysym_map_width && keysym_map[i * keysym_map_width + j] == NoSymbol) {
+            j++;
+        }
+
+        if (j == keysym_map_width) {
+            spare_map[count++] = keysym_map_min + i;
+        }
+    }
+
+    if (count > 0) {
+        spare_keycodes = malloc(sizeof(struct spare_keycode) * count);
+        if (spare_keycodes != NULL) {
+            for (unsigned int i = 0; i < count; i++) {
+                spare_keycodes[i].keycode = (KeyCode) spare_map[i];
+                spare_keycodes[i].keysym = NoSymbol;
+            }
+
+            spare_keycode_count = count;
+        }
+    }
+
+    if (spare_map != NULL) {
+        free(spare_map);
+    }
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Loaded keyboard mapping for key codes %i - %i with %u spare key code(s).\n",
+            __FUNCTION__, __LINE__, keysym_map_min, keysym_map_max, spare_keycode_count);
+
+    return true;
+}
+
+// Release the keyboard mapping without restoring the spare key codes.
+static void drop_keysym_map() {
+    if (spare_keycodes != NULL) {
+        free(spare_keycodes);
+        spare_keycodes = NULL;
+    }
+
+    spare_keycode_count = 0;
+    spare_keycode_next = 0;
+
+    if (keysym_map != NULL) {
+        XFree(keysym_map);
+        keysym_map = NULL;
+    }
+}
+
+// True if the key code is a spare key code bound by bind_spare_keycode().
+static bool is_spare_binding(unsigned int keycode) {
+    for (unsigned int i = 0; i < spare_keycode_count; i++) {
+        if (spare_keycodes[i].keycode == keycode) {
+            return spare_keycodes[i].keysym != NoSymbol;
+        }
+    }
+
+    return false;
+}
+
+/* Unbind the spare key codes bound by bind_spare_keycode().  With
+ * only_unchanged, key codes the server no longer maps to the bound key symbol
+ * were rebound by someone else and are left alone.
+ */
+static void restore_spare_keycodes(bool only_unchanged) {
+    if (spare_keycodes == NULL || helper_disp == NULL) {
+        return;
+    }
+
+    KeySym no_symbols[2] = { NoSymbol, NoSymbol };
+    for (unsigned int i = 0; i < spare_keycode_count; i++) {
+        if (spare_keycodes[i].keysym == NoSymbol) {
+            continue;
+        }
+
+        bool bound = true;
+        if (only_unchanged) {
+            int width = 0;
+            KeySym *current = XGetKeyboardMapping(helper_disp, spare_keycodes[i].keycode, 1, &width);
+            bound = current != NULL && width >= 2
+                    && current[0] == spare_keycodes[i].keysym && current[1] == spare_keycodes[i].keysym;
+
+            if (current != NULL) {
+                XFree(current);
+            }
+        }
+
+        if (bound) {
+            XChangeKeyboardMapping(helper_disp, spare_keycodes[i].keycode, 2, no_symbols, 1);
+        }
+        spare_keycodes[i].keysym = NoSymbol;
+    }
+
+    XFlush(helper_disp);
+}
+
+/* Drop the keyboard mapping if it changed since it was loaded so it is rebuilt
+ * on the next lookup.  Changes to the spare key codes bound by
+ * bind_spare_keycode() are our own and ignored.
+ */
+static void check_keysym_map() {
+    uint8_t stale[sizeof(keysym_map_stale)];
+
+    pthread_mutex_lock(&keysym_map_mutex);
+    bool changed = keysym_map_changed;
+    memcpy(stale, keysym_map_stale, sizeof(stale));
+    memset(keysym_map_stale, 0x00, sizeof(keysym_map_stale));
+    keysym_map_changed = false;
+    pthread_mutex_unlock(&keysym_map_mutex);
+
+    if (!changed || keysym_map == NULL) {
+        return;
+    }
+
+    unsigned int keycode = 0;
+    while (keycode < sizeof(stale) * 8 && (!(stale[keycode / 8] & (1 << (keycode % 8))) || is_spare_binding(keycode))) {
+        keycode++;
+    }
+
+    if (keycode < sizeof(stale) * 8) {
+        logger(LOG_LEVEL_DEBUG, "%s [%u]: Keyboard mapping changed for key code %u, reloading.\n",
+                __FUNCTION__, __LINE__, keycode);
+
+        // Spare bindings outlive a partial mapping change, so unbind those that are still ours.
+        restore_spare_keycodes(true);
+        drop_keysym_map();
+    }
+}
+
+void invalidate_keysym_map(int first_keycode, int count) {
+    pthread_mutex_lock(&keysym_map_mutex);
+    for (int keycode = first_keycode; keycode < first_keycode + (count > 0 ? count : 1); keycode++) {
+        if (keycode >= 0 && keycode < (int) sizeof(keysym_map_stale) * 8) {
+            keysym_map_stale[keycode / 8] |= 1 << (keycode % 8);
+            keysym_map_changed = true;
+        }
+    }
+    pthread_mutex_unlock(&keysym_map_mutex);
+}
+
+// Restore any temporarily bound key codes and release the keyboard mapping.
+static void unload_keysym_map() {
+    restore_spare_keycodes(false);
+    drop_keysym_map();
+}
+
+// Bind a key symbol to the least recently bound spare key code.
+static KeyCode bind_spare_keycode(KeySym keysym) {
+    for (unsigned int i = 0; i < spare_keycode_count; i++) {
+        if (spare_keycodes[i].keysym == keysym) {
+            return spare_keycodes[i].keycode;
+        }
+    }
+
+    if (spare_keycode_count == 0) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: No spare key code available for key symbol %#lX!\n",
+                __FUNCTION__, __LINE__, (unsigned long) keysym);
+        return 0x00;
+    }
+
+    struct spare_keycode *spare = &spare_keycodes[spare_keycode_next];
+    spare_keycode_next = (spare_keycode_next + 1) % spare_keycode_count;
+
+    if (spare->keysym != NoSymbol) {
+        // Events that still reference the previous binding must reach the server first.
+        XSync(helper_disp, False);
+
+        struct keysym_cache_entry *entry = &keysym_cache[spare->keysym % KEYSYM_CACHE_SIZE];
+        if (entry->keycode == spare->keycode) {
+            entry->keycode = 0x00;
+        }
+    }
+
+    // Bind both shift levels so the current modifier state does not matter.
+    KeySym symbols[2] = { keysym, keysym };
+    XChangeKeyboardMapping(helper_disp, spare->keycode, 2, symbols, 1);
+    spare->keysym = keysym;
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Bound key symbol %#lX to spare key code %u.\n",
+            __FUNCTION__, __LINE__, (unsigned long) keysym, spare->keycode);
+
+    return spare->keycode;
+}
+
+KeyCode keysym_to_keycode(KeySym keysym, unsigned int *level) {
+    KeyCode keycode = 0x00;
+    *level = 0;
+
+    check_keysym_map();
+    if (keysym == NoSymbol || (keysym_map == NULL && !load_keysym_map())) {
+        return keycode;
+    }
+
+    struct keysym_cache_entry *entry = &keysym_cache[keysym % KEYSYM_CACHE_SIZE];
+    if (entry->keycode != 0x00 && entry->keysym == keysym) {
+        *level = entry->level;
+        return entry->keycode;
+    }
+
+    // Only the unshifted and shifted levels of the first group are considered.
+    KeySym lower, upper;
+    XConvertCase(keysym, &lower, &upper);
+
+    int levels = keysym_map_width < 2 ? keysym_map_width : 2;
+    for (int i = 0; keycode == 0x00 && i <= keysym_map_max - keysym_map_min; i++) {
+        KeySym *symbols = &keysym_map[i * keysym_map_width];
+
+        for (int j = 0; j < levels; j++) {
+            if (symbols[j] == keysym) {
+                keycode = keysym_map_min + i;
+                *level = j;
+                break;
+            }
+        }
+
+        // An upper case symbol is implied if only the lower case symbol is bound.
+        if (keycode == 0x00 && keysym == upper && lower != upper
+                && symbols[0] == lower && (levels < 2 || symbols[1] == NoSymbol)) {
+            keycode = keysym_map_min + i;
+            *level = 1;
+        }
+    }
+
+    if (keycode == 0x00) {
+        keycode = bind_spare_keycode(keysym);
+    }
+
+    if (keycode != 0x00) {
+        entry->keysym = keysym;
+        entry->keycode = keycode;
+        entry->level = *level;
+    }
+
+    return keycode;
+}
+
 unsigned int button_map_lookup(unsigned int button) {
     unsigned int map_button = button;
 
@@ -1799,41 +2110,48 @@ void load_input_helper() {
      * This program is free software; you can redistribute it and/or modify
      * it under the terms of the GNU Lesser General Public License version 2 as
      * published by the Free Software Foundation.
+     *
+     * Only the key codes name is needed to select the scan code table, so it
+     * is fetched into the client map instead of retrieving the whole keyboard.
      */
-    XkbDescPtr desc = XkbGetKeyboard(helper_disp, XkbGBN_AllComponentsMask, XkbUseCoreKbd);
-    if (desc != NULL && desc->names != NULL) {
-        const char *layout_name = XGetAtomName(helper_disp, desc->names->keycodes);
+    keyboard_map = XkbGetMap(helper_disp, XkbAllClientInfoMask, XkbUseCoreKbd);
+    if (keyboard_map != NULL && XkbGetNames(helper_disp, XkbKeycodesNameMask, keyboard_map) == Success
+            && keyboard_map->names != NULL) {
+        char *layout_name = XGetAtomName(helper_disp, keyboard_map->names->keycodes);
         logger(LOG_LEVEL_DEBUG, "%s [%u]: Found keycode atom '%s' (%i)!\n",
-                __FUNCTION__, __LINE__, layout_name, (unsigned int) desc->names->keycodes);
+                __FUNCTION__, __LINE__, layout_name, (unsigned int) keyboard_map->names->keycodes);
 
         const char *prefix_xfree86 = "xfree86_";
         #ifdef USE_EVDEV
         const char *prefix_evdev = "evdev_";
-        if (strncmp(layout_name, prefix_evdev, strlen(prefix_evdev)) == 0) {
+        #endif
+        if (layout_name == NULL) {
+            logger(LOG_LEVEL_ERROR, "%s [%u]: X atom name failure for keyboard_map->names->keycodes!\n",
+                    __FUNCTION__, __LINE__);
+        }
+        #ifdef USE_EVDEV
+        else if (strncmp(layout_name, prefix_evdev, strlen(prefix_evdev)) == 0) {
             is_evdev = true;
-        } else
+        }
         #endif
-        if (strncmp(layout_name, prefix_xfree86, strlen(prefix_xfree86)) != 0) {
+        else if (strncmp(layout_name, prefix_xfree86, strlen(prefix_xfree86)) != 0) {
             logger(LOG_LEVEL_ERROR, "%s [%u]: Unknown keycode name '%s', please file a bug report!\n",
                     __FUNCTION__, __LINE__, layout_name);
-        } else if (layout_name == NULL) {
-            logger(LOG_LEVEL_ERROR, "%s [%u]: X atom name failure for desc->names->keycodes!\n",
-                    __FUNCTION__, __LINE__);
         }
 
-        XkbFreeClientMap(desc, XkbGBN_AllComponentsMask, True);
+        if (layout_name != NULL) {
+            XFree(layout_name);
+        }
     } else {
-        logger(LOG_LEVEL_ERROR, "%s [%u]: XkbGetKeyboard failed to locate a valid keyboard!\n",
+        logger(LOG_LEVEL_ERROR, "%s [%u]: XkbGetMap failed to locate a valid keyboard!\n",
                 __FUNCTION__, __LINE__);
     }
-
-    // Get the map.
-    keyboard_map = XkbGetMap(helper_disp, XkbAllClientInfoMask, XkbUseCoreKbd);
 }
 
 void unload_input_helper() {
     if (keyboard_map != NULL) {
-        XkbFreeClientMap(keyboard_map, XkbAllClientInfoMask, true);
+        XkbFreeKeyboard(keyboard_map, XkbAllComponentsMask, True);
+        keyboard_map = NULL;
         #ifdef USE_EVDEV
         is_evdev = false;
         #endif
@@ -1843,4 +2161,13 @@ void unload_input_helper() {
         free(mouse_button_map);
         mouse_button_map = NULL;
     }
+
+    // Restore any key codes bound for posting text.
+    if (helper_disp != NULL) {
+        XLockDisplay(helper_disp);
+        unload_keysym_map();
+        XUnlockDisplay(helper_disp);
+    } else {
+        unload_keysym_map();
+    }
 }
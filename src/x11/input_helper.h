@@ -61,6 +61,13 @@ extern uint16_t keycode_to_scancode(KeyCode keycode);
  */
 extern KeyCode scancode_to_keycode(uint16_t scancode);
 
+#ifdef USE_EVDEV
+/* Converts a keyboard scan code to the Linux input event code.  Unlike
+ * scancode_to_keycode(), this does not depend on the X11 keyboard layout.
+ */
+extern uint16_t scancode_to_evdev(uint16_t scancode);
+#endif
+
 
 #ifdef USE_XKB_COMMON
 
@@ -87,6 +94,20 @@ extern KeySym keycode_to_keysym(KeyCode keycode, unsigned int modifier_mask);
 
 #endif
 
+/* Converts a X11 key symbol to the X11 key code and shift level, 0 or 1, that
+ * produce it.  Key symbols missing from the first two levels of the first
+ * group, such as AltGr symbols, are temporarily bound to a spare key code
+ * until unload_input_helper() is called or the keyboard mapping changes.
+ * Returns 0x00 if the key symbol could not be mapped.
+ */
+extern KeyCode keysym_to_keycode(KeySym keysym, unsigned int *level);
+
+/* Marks count key codes from first_keycode as changed on the server so the
+ * mapping used by keysym_to_keycode() is rebuilt on its next call.  Called by
+ * the settings thread, safe to call from any thread.
+ */
+extern void invalidate_keysym_map(int first_keycode, int count);
+
 /* Lookup a X11 buttons possible remapping and return that value.
  */
 extern unsigned int button_map_lookup(unsigned int button);
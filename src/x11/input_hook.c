@@ -21,6 +21,8 @@
 
 #ifdef USE_XRECORD_ASYNC
 #include <pthread.h>
+#include <sys/time.h>
+#include <time.h>
 #endif
 
 #include <stdint.h>
@@ -44,8 +46,16 @@
 #pragma message("... Assuming single-head display.")
 #endif
 
-#include "logger.h"
+#include "dispatch_event.h"
+#include "file_source.h"
 #include "input_helper.h"
+#ifdef USE_XINPUT2
+#include "input_device.h"
+#endif
+#include "logger.h"
+#include "system_properties.h"
+#include "trace.h"
+#include "usdt.h"
 
 // Thread and hook handles.
 #ifdef USE_XRECORD_ASYNC
@@ -64,21 +74,6 @@ typedef struct _hook_info {
         Display *display;
         XRecordContext context;
     } ctrl;
-    struct _input {
-        #ifdef USE_XKB_COMMON
-        xcb_connection_t *connection;
-        struct xkb_context *context;
-        #endif
-        uint16_t mask;
-        struct _mouse {
-            bool is_dragged;
-            struct _click {
-                unsigned short int count;
-                long int time;
-                unsigned short int button;
-            } click;
-        } mouse;
-    } input;
 } hook_info;
 static hook_info *hook;
 
@@ -94,52 +89,69 @@ typedef union {
 
 #if defined(USE_XKB_COMMON)
 static struct xkb_state *state = NULL;
-#endif
 
-// Virtual event pointer.
-static uiohook_event event;
+// Kept between runs because hooks are frequently restarted.
+static struct xkb_context *input_context = NULL;
+#endif
 
-// Event dispatch callback.
-static dispatcher_t dispatcher = NULL;
+// Screen layout generation the last EVENT_SCREEN_CHANGED was dispatched for.
+static uint32_t screen_generation = 0;
 
-UIOHOOK_API void hook_set_dispatch_proc(dispatcher_t dispatch_proc) {
-    logger(LOG_LEVEL_DEBUG, "%s [%u]: Setting new dispatch callback to %#p.\n",
-            __FUNCTION__, __LINE__, dispatch_proc);
+// Offset of the first screen, subtracted from root window coordinates.
+static int16_t screen_origin_x = 0;
+static int16_t screen_origin_y = 0;
 
-    dispatcher = dispatch_proc;
-}
+/* Load the current screen layout into the dispatch screen index.  Root window
+ * coordinates are reported relative to the first screen when there is more
+ * than one, so the layout is moved by the same offset.
+ */
+static void load_screens() {
+    screen_data screens[UINT8_MAX];
+    unsigned char count = UINT8_MAX;
+    if (hook_get_screen_info(screens, &count) != UIOHOOK_SUCCESS) {
+        count = 0;
+    }
 
-// Send out an event if a dispatcher was set.
-static inline void dispatch_event(uiohook_event *const event) {
-    if (dispatcher != NULL) {
-        logger(LOG_LEVEL_DEBUG, "%s [%u]: Dispatching event type %u.\n",
-                __FUNCTION__, __LINE__, event->type);
+    screen_origin_x = 0;
+    screen_origin_y = 0;
+    #if defined(USE_XINERAMA) || defined(USE_XRANDR)
+    if (count > 1) {
+        screen_origin_x = screens[0].x;
+        screen_origin_y = screens[0].y;
+    }
+    #endif
 
-        dispatcher(event);
-    } else {
-        logger(LOG_LEVEL_WARN, "%s [%u]: No dispatch callback set!\n",
-                __FUNCTION__, __LINE__);
+    for (unsigned char i = 0; i < count; i++) {
+        screens[i].x -= screen_origin_x;
+        screens[i].y -= screen_origin_y;
     }
-}
 
-// Set the native modifier mask for future events.
-static inline void set_modifier_mask(uint16_t mask) {
-    hook->input.mask |= mask;
+    dispatch_set_screens(screens, count);
 }
 
-// Unset the native modifier mask for future events.
-static inline void unset_modifier_mask(uint16_t mask) {
-    hook->input.mask &= ~mask;
+// Adjust root window coordinates so they are relative to the first screen.
+static inline void translate_root_coordinates(int16_t *x, int16_t *y) {
+    *x -= screen_origin_x;
+    *y -= screen_origin_y;
 }
 
-// Get the current native modifier mask state.
-static inline uint16_t get_modifiers() {
-    return hook->input.mask;
+// Dispatch EVENT_SCREEN_CHANGED ahead of the current event if the screen layout changed.
+static inline void check_screen_generation(uint64_t timestamp) {
+    uint32_t generation = get_screen_generation();
+    if (generation != screen_generation) {
+        screen_generation = generation;
+        load_screens();
+        dispatch_screen_changed(timestamp);
+    }
 }
 
 // Initialize the modifier lock masks.
-static void initialize_locks() {
+static void initialize_locks(Display *display) {
     #ifdef USE_XKB_COMMON
+    if (state == NULL) {
+        return;
+    }
+
     if (xkb_state_led_name_is_active(state, XKB_LED_NAME_CAPS)) {
         set_modifier_mask(MASK_CAPS_LOCK);
     } else {
@@ -159,7 +171,7 @@ static void initialize_locks() {
     }
     #else
     unsigned int led_mask = 0x00;
-    if (XkbGetIndicatorState(hook->ctrl.display, XkbUseCoreKbd, &led_mask) == Success) {
+    if (display != NULL && XkbGetIndicatorState(display, XkbUseCoreKbd, &led_mask) == Success) {
         if (led_mask & 0x01) {
             set_modifier_mask(MASK_CAPS_LOCK);
         } else {
@@ -184,99 +196,151 @@ static void initialize_locks() {
     #endif
 }
 
+// Set the modifier mask if the key bound to the key symbol is held in the key map.
+static inline void set_held_modifier(const char *keymap, KeySym keysym, uint16_t mask) {
+    KeyCode keycode = XKeysymToKeycode(hook->ctrl.display, keysym);
+    if (keymap[keycode / 8] & (1 << (keycode % 8))) {
+        set_modifier_mask(mask);
+    }
+}
+
 // Initialize the modifier mask to the current modifiers.
 static void initialize_modifiers() {
-    hook->input.mask = 0x0000;
+    Window unused_win;
+    int root_x, root_y, unused_int;
+    unsigned int mask = 0x00;
+    if (XQueryPointer(hook->ctrl.display, DefaultRootWindow(hook->ctrl.display), &unused_win, &unused_win, &root_x, &root_y, &unused_int, &unused_int, &mask)) {
+        int16_t x = (int16_t) root_x, y = (int16_t) root_y;
+        translate_root_coordinates(&x, &y);
+        set_pointer_position(x, y);
+    } else {
+        logger(LOG_LEVEL_WARN, "%s [%u]: XQueryPointer failed to get current modifiers!\n",
+                __FUNCTION__, __LINE__);
 
-    KeyCode keycode;
+        // Fallback to checking every modifier key.
+        mask = ShiftMask | ControlMask | Mod1Mask | Mod4Mask;
+    }
+
+    // Seed the input snapshot with every key that is already held.
     char keymap[32];
     XQueryKeymap(hook->ctrl.display, keymap);
+    for (unsigned int keycode = 0; keycode < sizeof(keymap) * 8; keycode++) {
+        if (keymap[keycode / 8] & (1 << (keycode % 8))) {
+            set_key_state(keycode, true);
+        }
+    }
 
-      Window unused_win;
-    int unused_int;
-    unsigned int mask;
-    if (XQueryPointer(hook->ctrl.display, DefaultRootWindow(hook->ctrl.display), &unused_win, &unused_win, &unused_int, &unused_int, &unused_int, &unused_int, &mask)) {
+    /* The pointer mask does not say which side of a modifier is held, so the
+     * keyboard mapping behind XKeysymToKeycode() is only fetched when a
+     * modifier is actually down.
+     */
+    if (mask & (ShiftMask | ControlMask | Mod1Mask | Mod4Mask)) {
         if (mask & ShiftMask) {
-            keycode = XKeysymToKeycode(hook->ctrl.display, XK_Shift_L);
-            if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_SHIFT_L); }
-            keycode = XKeysymToKeycode(hook->ctrl.display, XK_Shift_R);
-            if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_SHIFT_R); }
+            set_held_modifier(keymap, XK_Shift_L, MASK_SHIFT_L);
+            set_held_modifier(keymap, XK_Shift_R, MASK_SHIFT_R);
         }
         if (mask & ControlMask) {
-            keycode = XKeysymToKeycode(hook->ctrl.display, XK_Control_L);
-            if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_CTRL_L);  }
-            keycode = XKeysymToKeycode(hook->ctrl.display, XK_Control_R);
-            if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_CTRL_R);  }
+            set_held_modifier(keymap, XK_Control_L, MASK_CTRL_L);
+            set_held_modifier(keymap, XK_Control_R, MASK_CTRL_R);
         }
         if (mask & Mod1Mask) {
-            keycode = XKeysymToKeycode(hook->ctrl.display, XK_Alt_L);
-            if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_ALT_L);   }
-            keycode = XKeysymToKeycode(hook->ctrl.display, XK_Alt_R);
-            if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_ALT_R);   }
+            set_held_modifier(keymap, XK_Alt_L, MASK_ALT_L);
+            set_held_modifier(keymap, XK_Alt_R, MASK_ALT_R);
         }
         if (mask & Mod4Mask) {
-            keycode = XKeysymToKeycode(hook->ctrl.display, XK_Super_L);
-            if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_META_L);  }
-            keycode = XKeysymToKeycode(hook->ctrl.display, XK_Super_R);
-            if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_META_R);  }
+            set_held_modifier(keymap, XK_Super_L, MASK_META_L);
+            set_held_modifier(keymap, XK_Super_R, MASK_META_R);
         }
+    }
 
-        if (mask & Button1Mask) { set_modifier_mask(MASK_BUTTON1); }
-        if (mask & Button2Mask) { set_modifier_mask(MASK_BUTTON2); }
-        if (mask & Button3Mask) { set_modifier_mask(MASK_BUTTON3); }
-        if (mask & Button4Mask) { set_modifier_mask(MASK_BUTTON4); }
-        if (mask & Button5Mask) { set_modifier_mask(MASK_BUTTON5); }
-    } else {
-        logger(LOG_LEVEL_WARN, "%s [%u]: XQueryPointer failed to get current modifiers!\n",
-                __FUNCTION__, __LINE__);
+    if (mask & Button1Mask) { set_modifier_mask(MASK_BUTTON1); }
+    if (mask & Button2Mask) { set_modifier_mask(MASK_BUTTON2); }
+    if (mask & Button3Mask) { set_modifier_mask(MASK_BUTTON3); }
+    if (mask & Button4Mask) { set_modifier_mask(MASK_BUTTON4); }
+    if (mask & Button5Mask) { set_modifier_mask(MASK_BUTTON5); }
+
+    initialize_locks(hook->ctrl.display);
+}
 
-        keycode = XKeysymToKeycode(hook->ctrl.display, XK_Shift_L);
-        if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_SHIFT_L); }
-        keycode = XKeysymToKeycode(hook->ctrl.display, XK_Shift_R);
-        if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_SHIFT_R); }
-        keycode = XKeysymToKeycode(hook->ctrl.display, XK_Control_L);
-        if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_CTRL_L);  }
-        keycode = XKeysymToKeycode(hook->ctrl.display, XK_Control_R);
-        if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_CTRL_R);  }
-        keycode = XKeysymToKeycode(hook->ctrl.display, XK_Alt_L);
-        if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_ALT_L);   }
-        keycode = XKeysymToKeycode(hook->ctrl.display, XK_Alt_R);
-        if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_ALT_R);   }
-        keycode = XKeysymToKeycode(hook->ctrl.display, XK_Super_L);
-        if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_META_L);  }
-        keycode = XKeysymToKeycode(hook->ctrl.display, XK_Super_R);
-        if (keymap[keycode / 8] & (1 << (keycode % 8))) { set_modifier_mask(MASK_META_R);  }
+// Convert a mapped X11 button to its virtual mouse button.
+static inline uint16_t button_to_mouse_button(unsigned int map_button) {
+    /* This information is all static for X11, its up to the WM to
+     * decide how to interpret the wheel events.
+     */
+    switch (map_button) {
+        case Button1:  return MOUSE_BUTTON1;
+        case Button2:  return MOUSE_BUTTON2;
+        case Button3:  return MOUSE_BUTTON3;
+        case XButton1: return MOUSE_BUTTON4;
+        case XButton2: return MOUSE_BUTTON5;
+        default:       return MOUSE_NOBUTTON;
     }
+}
 
-    initialize_locks();
+/* Create the xkbcommon state hook_event_proc() translates key codes with.
+ * Called by xrecord_start(), and by the benchmarks and tests that drive
+ * hook_event_proc() without running the hook.  Does nothing without
+ * USE_XKB_COMMON.
+ */
+void load_input_state(Display *display) {
+    #ifdef USE_XKB_COMMON
+    xcb_connection_t *connection = XGetXCBConnection(display);
+    int xcb_status = xcb_connection_has_error(connection);
+    if (xcb_status > 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: xcb_connect failure! (%d)\n",
+                __FUNCTION__, __LINE__, xcb_status);
+        return;
+    }
+
+    /* Initialize xkbcommon context.  The keymap is read from the server so
+     * the include paths are only added by the create_xkb_state() fallback
+     * when they are actually needed.
+     */
+    if (input_context == NULL) {
+        input_context = xkb_context_new(XKB_CONTEXT_NO_DEFAULT_INCLUDES | XKB_CONTEXT_NO_ENVIRONMENT_NAMES);
+        if (input_context == NULL) {
+            logger(LOG_LEVEL_ERROR, "%s [%u]: xkb_context_new failure!\n",
+                    __FUNCTION__, __LINE__);
+            return;
+        }
+    }
+
+    if (state == NULL) {
+        state = create_xkb_state(input_context, connection);
+    }
+    #else
+    (void) display;
+    #endif
 }
 
+// Release the state created by load_input_state(), the context is kept for the next run.
+void unload_input_state() {
+    #ifdef USE_XKB_COMMON
+    if (state != NULL) {
+        destroy_xkb_state(state);
+        state = NULL;
+    }
+    #endif
+}
+
+/* XRecord intercept callback.  The closeure is the control display used for
+ * indicator lookups and may be NULL, which allows the benchmarks to drive this
+ * function with synthetic data.
+ */
 void hook_event_proc(XPointer closeure, XRecordInterceptData *recorded_data) {
+    TRACE_BEGIN(receipt);
     uint64_t timestamp = (uint64_t) recorded_data->server_time;
+    USDT_PROBE3(xrecord_reply, recorded_data->category, timestamp, recorded_data->data_len);
 
     if (recorded_data->category == XRecordStartOfData) {
         // Initialize native input helper functions.
         load_input_helper();
 
-        // Populate the hook start event.
-        event.time = timestamp;
-        event.reserved = 0x00;
-
-        event.type = EVENT_HOOK_ENABLED;
-        event.mask = 0x00;
-
         // Fire the hook start event.
-        dispatch_event(&event);
+        dispatch_hook_enabled(timestamp);
     } else if (recorded_data->category == XRecordEndOfData) {
-        // Populate the hook stop event.
-        event.time = timestamp;
-        event.reserved = 0x00;
-
-        event.type = EVENT_HOOK_DISABLED;
-        event.mask = 0x00;
-
         // Fire the hook stop event.
-        dispatch_event(&event);
+        dispatch_hook_disabled(timestamp);
 
         // Deinitialize native input helper functions.
         unload_input_helper();
@@ -284,9 +348,16 @@ void hook_event_proc(XPointer closeure, XRecordInterceptData *recorded_data) {
         // Get XRecord data.
         XRecordDatum *data = (XRecordDatum *) recorded_data->data;
 
+        check_screen_generation(timestamp);
+
+        #ifdef USE_XINPUT2
+        dispatch_set_source(lookup_input_device(data->type, data->event.u.u.detail, recorded_data->server_time));
+        #endif
+
         if (data->type == KeyPress) {
             // The X11 KeyCode associated with this event.
             KeyCode keycode = (KeyCode) data->event.u.u.detail;
+            TRACE_BEGIN(translate);
             KeySym keysym = 0x00;
             #if defined(USE_XKB_COMMON)
             if (state != NULL) {
@@ -307,83 +378,23 @@ void hook_event_proc(XPointer closeure, XRecordInterceptData *recorded_data) {
             count = keysym_to_unicode(keysym, buffer, sizeof(buffer) / sizeof(uint16_t));
             #endif
 
-
             unsigned short int scancode = keycode_to_scancode(keycode);
+            USDT_PROBE3(key_translate, keycode, scancode, keysym);
+            TRACE_END(TRACE_STAGE_TRANSLATE, keycode, translate);
 
-            // TODO If you have a better suggestion for this ugly, let me know.
-            if      (scancode == VC_SHIFT_L)   { set_modifier_mask(MASK_SHIFT_L); }
-            else if (scancode == VC_SHIFT_R)   { set_modifier_mask(MASK_SHIFT_R); }
-            else if (scancode == VC_CONTROL_L) { set_modifier_mask(MASK_CTRL_L);  }
-            else if (scancode == VC_CONTROL_R) { set_modifier_mask(MASK_CTRL_R);  }
-            else if (scancode == VC_ALT_L)     { set_modifier_mask(MASK_ALT_L);   }
-            else if (scancode == VC_ALT_R)     { set_modifier_mask(MASK_ALT_R);   }
-            else if (scancode == VC_META_L)    { set_modifier_mask(MASK_META_L);  }
-            else if (scancode == VC_META_R)    { set_modifier_mask(MASK_META_R);  }
             #ifdef USE_XKB_COMMON
-            xkb_state_update_key(state, keycode, XKB_KEY_DOWN);
-            #endif
-            initialize_locks();
-
-
-            if ((get_modifiers() & MASK_NUM_LOCK) == 0) {
-                switch (scancode) {
-                    case VC_KP_SEPARATOR:
-                    case VC_KP_1:
-                    case VC_KP_2:
-                    case VC_KP_3:
-                    case VC_KP_4:
-                    case VC_KP_5:
-                    case VC_KP_6:
-                    case VC_KP_7:
-                    case VC_KP_8:
-                    case VC_KP_0:
-                    case VC_KP_9:
-                        scancode |= 0xEE00;
-                        break;
-                }
+            if (state != NULL) {
+                xkb_state_update_key(state, keycode, XKB_KEY_DOWN);
             }
+            #endif
+            initialize_locks((Display *) closeure);
 
-            // Populate key pressed event.
-            event.time = timestamp;
-            event.reserved = 0x00;
-
-            event.type = EVENT_KEY_PRESSED;
-            event.mask = get_modifiers();
-
-            event.data.keyboard.keycode = scancode;
-            event.data.keyboard.rawcode = keysym;
-            event.data.keyboard.keychar = CHAR_UNDEFINED;
-
-            logger(LOG_LEVEL_DEBUG, "%s [%u]: Key %#X pressed. (%#X)\n",
-                    __FUNCTION__, __LINE__, event.data.keyboard.keycode, event.data.keyboard.rawcode);
-
-            // Fire key pressed event.
-            dispatch_event(&event);
-
-            // If the pressed event was not consumed...
-            if (event.reserved ^ 0x01) {
-                for (unsigned int i = 0; i < count; i++) {
-                    // Populate key typed event.
-                    event.time = timestamp;
-                    event.reserved = 0x00;
-
-                    event.type = EVENT_KEY_TYPED;
-                    event.mask = get_modifiers();
-
-                    event.data.keyboard.keycode = VC_UNDEFINED;
-                    event.data.keyboard.rawcode = keysym;
-                    event.data.keyboard.keychar = buffer[i];
-
-                    logger(LOG_LEVEL_DEBUG, "%s [%u]: Key %#X typed. (%lc)\n",
-                            __FUNCTION__, __LINE__, event.data.keyboard.keycode, (uint16_t) event.data.keyboard.keychar);
-
-                    // Fire key typed event.
-                    dispatch_event(&event);
-                }
-            }
+            set_key_state(keycode, true);
+            dispatch_key_press(timestamp, scancode, keysym, buffer, count);
         } else if (data->type == KeyRelease) {
             // The X11 KeyCode associated with this event.
             KeyCode keycode = (KeyCode) data->event.u.u.detail;
+            TRACE_BEGIN(translate);
             KeySym keysym = 0x00;
             #ifdef USE_XKB_COMMON
             if (state != NULL) {
@@ -393,77 +404,30 @@ void hook_event_proc(XPointer closeure, XRecordInterceptData *recorded_data) {
             keysym = keycode_to_keysym(keycode, data->event.u.keyButtonPointer.state);
             #endif
 
-            // Check to make sure the key is printable.
-            uint16_t buffer[2];
-            #ifdef USE_XKB_COMMON
-            if (state != NULL) {
-                keycode_to_unicode(state, keycode, buffer, sizeof(buffer) / sizeof(uint16_t));
-            }
-            #else
-            keysym_to_unicode(keysym, buffer, sizeof(buffer) / sizeof(uint16_t));
-            #endif
-
             unsigned short int scancode = keycode_to_scancode(keycode);
+            USDT_PROBE3(key_translate, keycode, scancode, keysym);
+            TRACE_END(TRACE_STAGE_TRANSLATE, keycode, translate);
 
-            // TODO If you have a better suggestion for this ugly, let me know.
-            if      (scancode == VC_SHIFT_L)   { unset_modifier_mask(MASK_SHIFT_L); }
-            else if (scancode == VC_SHIFT_R)   { unset_modifier_mask(MASK_SHIFT_R); }
-            else if (scancode == VC_CONTROL_L) { unset_modifier_mask(MASK_CTRL_L);  }
-            else if (scancode == VC_CONTROL_R) { unset_modifier_mask(MASK_CTRL_R);  }
-            else if (scancode == VC_ALT_L)     { unset_modifier_mask(MASK_ALT_L);   }
-            else if (scancode == VC_ALT_R)     { unset_modifier_mask(MASK_ALT_R);   }
-            else if (scancode == VC_META_L)    { unset_modifier_mask(MASK_META_L);  }
-            else if (scancode == VC_META_R)    { unset_modifier_mask(MASK_META_R);  }
             #ifdef USE_XKB_COMMON
-            xkb_state_update_key(state, keycode, XKB_KEY_UP);
-            #endif
-            initialize_locks();
-
-            if ((get_modifiers() & MASK_NUM_LOCK) == 0) {
-                switch (scancode) {
-                    case VC_KP_SEPARATOR:
-                    case VC_KP_1:
-                    case VC_KP_2:
-                    case VC_KP_3:
-                    case VC_KP_4:
-                    case VC_KP_5:
-                    case VC_KP_6:
-                    case VC_KP_7:
-                    case VC_KP_8:
-                    case VC_KP_0:
-                    case VC_KP_9:
-                        scancode |= 0xEE00;
-                        break;
-                }
+            if (state != NULL) {
+                xkb_state_update_key(state, keycode, XKB_KEY_UP);
             }
+            #endif
+            initialize_locks((Display *) closeure);
 
-            // Populate key released event.
-            event.time = timestamp;
-            event.reserved = 0x00;
-
-            event.type = EVENT_KEY_RELEASED;
-            event.mask = get_modifiers();
-
-            event.data.keyboard.keycode = scancode;
-            event.data.keyboard.rawcode = keysym;
-            event.data.keyboard.keychar = CHAR_UNDEFINED;
-
-            logger(LOG_LEVEL_DEBUG, "%s [%u]: Key %#X released. (%#X)\n",
-                    __FUNCTION__, __LINE__, event.data.keyboard.keycode, event.data.keyboard.rawcode);
-
-            // Fire key released event.
-            dispatch_event(&event);
+            set_key_state(keycode, false);
+            dispatch_key_release(timestamp, scancode, keysym);
         } else if (data->type == ButtonPress) {
             unsigned int map_button = button_map_lookup(data->event.u.u.detail);
 
+            int16_t x = data->event.u.keyButtonPointer.rootX;
+            int16_t y = data->event.u.keyButtonPointer.rootY;
+            translate_root_coordinates(&x, &y);
+
             // X11 handles wheel events as button events.
             if (map_button == WheelUp || map_button == WheelDown
                     || map_button == WheelLeft || map_button == WheelRight) {
 
-                // Reset the click count and previous button.
-                hook->input.mouse.click.count = 1;
-                hook->input.mouse.click.button = MOUSE_NOBUTTON;
-
                 /* Scroll wheel release events.
                  * Scroll type: WHEEL_UNIT_SCROLL
                  * Scroll amount: 3 unit increments per notch
@@ -471,156 +435,37 @@ void hook_event_proc(XPointer closeure, XRecordInterceptData *recorded_data) {
                  * Vertical unit increment: 15 pixels
                  */
 
-                // Populate mouse wheel event.
-                event.time = timestamp;
-                event.reserved = 0x00;
-
-                event.type = EVENT_MOUSE_WHEEL;
-                event.mask = get_modifiers();
-
-                event.data.wheel.clicks = hook->input.mouse.click.count;
-                event.data.wheel.x = data->event.u.keyButtonPointer.rootX;
-                event.data.wheel.y = data->event.u.keyButtonPointer.rootY;
-
-                #if defined(USE_XINERAMA) || defined(USE_XRANDR)
-                uint8_t count;
-                screen_data *screens = hook_create_screen_info(&count);
-                if (count > 1) {
-                    event.data.wheel.x -= screens[0].x;
-                    event.data.wheel.y -= screens[0].y;
-                }
-
-                if (screens != NULL) {
-                    free(screens);
-                }
-                #endif
-
-                /* X11 does not have an API call for acquiring the mouse scroll type.  This
-                 * maybe part of the XInput2 (XI2) extention but I will wont know until it
-                 * is available on my platform.  For the time being we will just use the
-                 * unit scroll value.
-                 */
-                event.data.wheel.type = WHEEL_UNIT_SCROLL;
-
-                /* Some scroll wheel properties are available via the new XInput2 (XI2)
-                 * extension.  Unfortunately the extension is not available on my
-                 * development platform at this time.  For the time being we will just
-                 * use the Windows default value of 3.
-                 */
-                event.data.wheel.amount = 3;
-
+                int16_t rotation;
                 if (data->event.u.u.detail == WheelUp || data->event.u.u.detail == WheelLeft) {
                     // Wheel Rotated Up and Away.
-                    event.data.wheel.rotation = -1;
+                    rotation = -1;
                 } else { // data->event.u.u.detail == WheelDown
                     // Wheel Rotated Down and Towards.
-                    event.data.wheel.rotation = 1;
+                    rotation = 1;
                 }
 
+                uint8_t direction;
                 if (data->event.u.u.detail == WheelUp || data->event.u.u.detail == WheelDown) {
                     // Wheel Rotated Up or Down.
-                    event.data.wheel.direction = WHEEL_VERTICAL_DIRECTION;
+                    direction = WHEEL_VERTICAL_DIRECTION;
                 } else { // data->event.u.u.detail == WheelLeft || data->event.u.u.detail == WheelRight
                     // Wheel Rotated Left or Right.
-                    event.data.wheel.direction = WHEEL_HORIZONTAL_DIRECTION;
+                    direction = WHEEL_HORIZONTAL_DIRECTION;
                 }
 
-                logger(LOG_LEVEL_DEBUG, "%s [%u]: Mouse wheel type %u, rotated %i units in the %u direction at %u, %u.\n",
-                        __FUNCTION__, __LINE__, event.data.wheel.type,
-                        event.data.wheel.amount * event.data.wheel.rotation,
-                        event.data.wheel.direction,
-                        event.data.wheel.x, event.data.wheel.y);
-
-                // Fire mouse wheel event.
-                dispatch_event(&event);
-            } else {
-                /* This information is all static for X11, its up to the WM to
-                 * decide how to interpret the wheel events.
+                /* X11 does not have an API call for acquiring the mouse scroll type.  This
+                 * maybe part of the XInput2 (XI2) extention but I will wont know until it
+                 * is available on my platform.  For the time being we will just use the
+                 * unit scroll value.
+                 *
+                 * Some scroll wheel properties are available via the new XInput2 (XI2)
+                 * extension.  Unfortunately the extension is not available on my
+                 * development platform at this time.  For the time being we will just
+                 * use the Windows default value of 3.
                  */
-                uint16_t button = MOUSE_NOBUTTON;
-                switch (map_button) {
-                    case Button1:
-                        button = MOUSE_BUTTON1;
-                        set_modifier_mask(MASK_BUTTON1);
-                        break;
-
-                    case Button2:
-                        button = MOUSE_BUTTON2;
-                        set_modifier_mask(MASK_BUTTON2);
-                        break;
-
-                    case Button3:
-                        button = MOUSE_BUTTON3;
-                        set_modifier_mask(MASK_BUTTON3);
-                        break;
-
-                    case XButton1:
-                        button = MOUSE_BUTTON4;
-                        set_modifier_mask(MASK_BUTTON5);
-                        break;
-
-                    case XButton2:
-                        button = MOUSE_BUTTON5;
-                        set_modifier_mask(MASK_BUTTON5);
-                        break;
-
-                    default:
-                        // Do not set modifier masks past button MASK_BUTTON5.
-                        break;
-                }
-
-
-                // Track the number of clicks, the button must match the previous button.
-                if (button == hook->input.mouse.click.button && (long int) (timestamp - hook->input.mouse.click.time) <= hook_get_multi_click_time()) {
-                    if (hook->input.mouse.click.count < USHRT_MAX) {
-                        hook->input.mouse.click.count++;
-                    } else {
-                        logger(LOG_LEVEL_WARN, "%s [%u]: Click count overflow detected!\n",
-                                __FUNCTION__, __LINE__);
-                    }
-                } else {
-                    // Reset the click count.
-                    hook->input.mouse.click.count = 1;
-
-                    // Set the previous button.
-                    hook->input.mouse.click.button = button;
-                }
-
-                // Save this events time to calculate the hook->input.mouse.click.count.
-                hook->input.mouse.click.time = timestamp;
-
-
-                // Populate mouse pressed event.
-                event.time = timestamp;
-                event.reserved = 0x00;
-
-                event.type = EVENT_MOUSE_PRESSED;
-                event.mask = get_modifiers();
-
-                event.data.mouse.button = button;
-                event.data.mouse.clicks = hook->input.mouse.click.count;
-                event.data.mouse.x = data->event.u.keyButtonPointer.rootX;
-                event.data.mouse.y = data->event.u.keyButtonPointer.rootY;
-
-                #if defined(USE_XINERAMA) || defined(USE_XRANDR)
-                uint8_t count;
-                screen_data *screens = hook_create_screen_info(&count);
-                if (count > 1) {
-                    event.data.mouse.x -= screens[0].x;
-                    event.data.mouse.y -= screens[0].y;
-                }
-
-                if (screens != NULL) {
-                    free(screens);
-                }
-                #endif
-
-                logger(LOG_LEVEL_DEBUG, "%s [%u]: Button %u  pressed %u time(s). (%u, %u)\n",
-                        __FUNCTION__, __LINE__, event.data.mouse.button, event.data.mouse.clicks,
-                        event.data.mouse.x, event.data.mouse.y);
-
-                // Fire mouse pressed event.
-                dispatch_event(&event);
+                dispatch_mouse_wheel(timestamp, x, y, WHEEL_UNIT_SCROLL, 3, rotation, direction);
+            } else {
+                dispatch_mouse_press(timestamp, button_to_mouse_button(map_button), x, y);
             }
         } else if (data->type == ButtonRelease) {
             unsigned int map_button = button_map_lookup(data->event.u.u.detail);
@@ -629,164 +474,18 @@ void hook_event_proc(XPointer closeure, XRecordInterceptData *recorded_data) {
             if (map_button != WheelUp && map_button != WheelDown
                     && map_button != WheelLeft && map_button != WheelRight) {
 
-                /* This information is all static for X11, its up to the WM to
-                 * decide how to interpret the wheel events.
-                 */
-                uint16_t button = MOUSE_NOBUTTON;
-                switch (map_button) {
-                    // FIXME This should use a lookup table to handle button remapping.
-                    case Button1:
-                        button = MOUSE_BUTTON1;
-                        unset_modifier_mask(MASK_BUTTON1);
-                        break;
-
-                    case Button2:
-                        button = MOUSE_BUTTON2;
-                        unset_modifier_mask(MASK_BUTTON2);
-                        break;
-
-                    case Button3:
-                        button = MOUSE_BUTTON3;
-                        unset_modifier_mask(MASK_BUTTON3);
-                        break;
-
-                    case XButton1:
-                        button = MOUSE_BUTTON4;
-                        unset_modifier_mask(MASK_BUTTON5);
-                        break;
-
-                    case XButton2:
-                        button = MOUSE_BUTTON5;
-                        unset_modifier_mask(MASK_BUTTON5);
-                        break;
-
-                    default:
-                        // Do not set modifier masks past button MASK_BUTTON5.
-                        break;
-                }
-
-                // Populate mouse released event.
-                event.time = timestamp;
-                event.reserved = 0x00;
-
-                event.type = EVENT_MOUSE_RELEASED;
-                event.mask = get_modifiers();
-
-                event.data.mouse.button = button;
-                event.data.mouse.clicks = hook->input.mouse.click.count;
-                event.data.mouse.x = data->event.u.keyButtonPointer.rootX;
-                event.data.mouse.y = data->event.u.keyButtonPointer.rootY;
+                int16_t x = data->event.u.keyButtonPointer.rootX;
+                int16_t y = data->event.u.keyButtonPointer.rootY;
+                translate_root_coordinates(&x, &y);
 
-                #if defined(USE_XINERAMA) || defined(USE_XRANDR)
-                uint8_t count;
-                screen_data *screens = hook_create_screen_info(&count);
-                if (count > 1) {
-                    event.data.mouse.x -= screens[0].x;
-                    event.data.mouse.y -= screens[0].y;
-                }
-
-                if (screens != NULL) {
-                    free(screens);
-                }
-                #endif
-
-                logger(LOG_LEVEL_DEBUG, "%s [%u]: Button %u released %u time(s). (%u, %u)\n",
-                        __FUNCTION__, __LINE__, event.data.mouse.button,
-                        event.data.mouse.clicks,
-                        event.data.mouse.x, event.data.mouse.y);
-
-                // Fire mouse released event.
-                dispatch_event(&event);
-
-                // If the pressed event was not consumed...
-                if (event.reserved ^ 0x01 && hook->input.mouse.is_dragged != true) {
-                    // Populate mouse clicked event.
-                    event.time = timestamp;
-                    event.reserved = 0x00;
-
-                    event.type = EVENT_MOUSE_CLICKED;
-                    event.mask = get_modifiers();
-
-                    event.data.mouse.button = button;
-                    event.data.mouse.clicks = hook->input.mouse.click.count;
-                    event.data.mouse.x = data->event.u.keyButtonPointer.rootX;
-                    event.data.mouse.y = data->event.u.keyButtonPointer.rootY;
-
-                    #if defined(USE_XINERAMA) || defined(USE_XRANDR)
-                    uint8_t count;
-                    screen_data *screens = hook_create_screen_info(&count);
-                    if (count > 1) {
-                        event.data.mouse.x -= screens[0].x;
-                        event.data.mouse.y -= screens[0].y;
-                    }
-
-                    if (screens != NULL) {
-                        free(screens);
-                    }
-                    #endif
-
-                    logger(LOG_LEVEL_DEBUG, "%s [%u]: Button %u clicked %u time(s). (%u, %u)\n",
-                            __FUNCTION__, __LINE__, event.data.mouse.button,
-                            event.data.mouse.clicks,
-                            event.data.mouse.x, event.data.mouse.y);
-
-                    // Fire mouse clicked event.
-                    dispatch_event(&event);
-                }
-
-                // Reset the number of clicks.
-                if (button == hook->input.mouse.click.button && (long int) (event.time - hook->input.mouse.click.time) > hook_get_multi_click_time()) {
-                    // Reset the click count.
-                    hook->input.mouse.click.count = 0;
-                }
+                dispatch_mouse_release(timestamp, button_to_mouse_button(map_button), x, y);
             }
         } else if (data->type == MotionNotify) {
-            // Reset the click count.
-            if (hook->input.mouse.click.count != 0 && (long int) (timestamp - hook->input.mouse.click.time) > hook_get_multi_click_time()) {
-                hook->input.mouse.click.count = 0;
-            }
-            
-            // Populate mouse move event.
-            event.time = timestamp;
-            event.reserved = 0x00;
-
-            event.mask = get_modifiers();
-
-            // Check the upper half of virtual modifiers for non-zero values and set the mouse
-            // dragged flag.  The last 3 bits are reserved for lock masks.
-            hook->input.mouse.is_dragged = ((event.mask & 0x1F00) > 0);
-            if (hook->input.mouse.is_dragged) {
-                // Create Mouse Dragged event.
-                event.type = EVENT_MOUSE_DRAGGED;
-            } else {
-                // Create a Mouse Moved event.
-                event.type = EVENT_MOUSE_MOVED;
-            }
-
-            event.data.mouse.button = MOUSE_NOBUTTON;
-            event.data.mouse.clicks = hook->input.mouse.click.count;
-            event.data.mouse.x = data->event.u.keyButtonPointer.rootX;
-            event.data.mouse.y = data->event.u.keyButtonPointer.rootY;
-
-            #if defined(USE_XINERAMA) || defined(USE_XRANDR)
-            uint8_t count;
-            screen_data *screens = hook_create_screen_info(&count);
-            if (count > 1) {
-                event.data.mouse.x -= screens[0].x;
-                event.data.mouse.y -= screens[0].y;
-            }
-
-            if (screens != NULL) {
-                free(screens);
-            }
-            #endif
-
-            logger(LOG_LEVEL_DEBUG, "%s [%u]: Mouse %s to %i, %i. (%#X)\n",
-                    __FUNCTION__, __LINE__, hook->input.mouse.is_dragged ? "dragged" : "moved",
-                    event.data.mouse.x, event.data.mouse.y, event.mask);
+            int16_t x = data->event.u.keyButtonPointer.rootX;
+            int16_t y = data->event.u.keyButtonPointer.rootY;
+            translate_root_coordinates(&x, &y);
 
-            // Fire mouse move event.
-            dispatch_event(&event);
+            dispatch_mouse_move(timestamp, x, y);
         } else {
             // In theory this *should* never execute.
             logger(LOG_LEVEL_DEBUG, "%s [%u]: Unhandled X11 event: %#X.\n",
@@ -799,6 +498,7 @@ void hook_event_proc(XPointer closeure, XRecordInterceptData *recorded_data) {
 
     // TODO There is no way to consume the XRecord event.
 
+    TRACE_END(TRACE_STAGE_RECEIPT, recorded_data->data_len > 0 ? ((XRecordDatum *) recorded_data->data)->type : 0, receipt);
     XRecordFreeData(recorded_data);
 }
 
@@ -818,13 +518,12 @@ static inline bool enable_key_repeate() {
 static inline int xrecord_block() {
     int status = UIOHOOK_FAILURE;
 
-    // Save the data display associated with this hook so it is passed to each event.
-    //XPointer closeure = (XPointer) (ctrl_display);
-    XPointer closeure = NULL;
+    // Save the control display associated with this hook so it is passed to each event.
+    XPointer closeure = (XPointer) hook->ctrl.display;
 
     #ifdef USE_XRECORD_ASYNC
     // Async requires that we loop so that our thread does not return.
-    if (XRecordEnableContextAsync(hook->data.display, context, hook_event_proc, closeure) != 0) {
+    if (XRecordEnableContextAsync(hook->data.display, hook->ctrl.context, hook_event_proc, closeure) != 0) {
         // Time in MS to sleep the runloop.
         int timesleep = 100;
 
@@ -856,7 +555,7 @@ static inline int xrecord_block() {
         pthread_mutex_unlock(&hook_xrecord_mutex);
 
         // Set the exit status.
-        status = NULL;
+        status = UIOHOOK_SUCCESS;
     }
     #else
     // Sync blocks until XRecordDisableContext() is called.
@@ -977,45 +676,27 @@ static int xrecord_start() {
                     __FUNCTION__, __LINE__);
         }
 
-        #if defined(USE_XKB_COMMON)
-        // Open XCB Connection
-        hook->input.connection = XGetXCBConnection(hook->ctrl.display);
-        int xcb_status = xcb_connection_has_error(hook->input.connection);
-        if (xcb_status <= 0) {
-            // Initialize xkbcommon context.
-            struct xkb_context *context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+        load_input_state(hook->ctrl.display);
 
-            if (context != NULL) {
-                hook->input.context = xkb_context_ref(context);
-            } else {
-                logger(LOG_LEVEL_ERROR, "%s [%u]: xkb_context_new failure!\n",
-                        __FUNCTION__, __LINE__);
-            }
-        } else {
-            logger(LOG_LEVEL_ERROR, "%s [%u]: xcb_connect failure! (%d)\n",
-                    __FUNCTION__, __LINE__, xcb_status);
-        }
-        #endif
-
-        #ifdef USE_XKB_COMMON
-        state = create_xkb_state(hook->input.context, hook->input.connection);
-        #endif
+        // Layout changes before this point are already visible to hook_get_screen_info().
+        screen_generation = get_screen_generation();
+        load_screens();
 
         // Initialize starting modifiers.
         initialize_modifiers();
 
-        status = xrecord_query();
+        #ifdef USE_XINPUT2
+        // Events are dispatched without a source device if this fails.
+        load_input_devices();
+        #endif
 
-        #ifdef USE_XKB_COMMON
-        if (state != NULL) {
-            destroy_xkb_state(state);
-        }
+        status = xrecord_query();
 
-        if (hook->input.context != NULL) {
-            xkb_context_unref(hook->input.context);
-            hook->input.context = NULL;
-        }
+        #ifdef USE_XINPUT2
+        unload_input_devices();
         #endif
+
+        unload_input_state();
     } else {
         logger(LOG_LEVEL_ERROR, "%s [%u]: XOpenDisplay failure!\n",
                 __FUNCTION__, __LINE__);
@@ -1039,8 +720,18 @@ static int xrecord_start() {
 }
 
 UIOHOOK_API int hook_run() {
-    // Hook data for future cleanup.
-    hook = malloc(sizeof(hook_info));
+    // Dispatch a recording instead of live input if a replay source was set.
+    if (file_source_enabled()) {
+        return file_source_run();
+    }
+
+    // Open the helper display on first use and refresh the property snapshot.
+    load_library();
+    refresh_system_properties();
+    dispatch_set_multi_click_time(hook_get_multi_click_time());
+
+    // Hook data for future cleanup, zeroed so hook_stop() never sees an unset context.
+    hook = calloc(1, sizeof(hook_info));
     if (hook == NULL) {
         logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to allocate memory for hook structure!\n",
               __FUNCTION__, __LINE__);
@@ -1048,11 +739,8 @@ UIOHOOK_API int hook_run() {
         return UIOHOOK_ERROR_OUT_OF_MEMORY;
     }
 
-    hook->input.mask = 0x0000;
-    hook->input.mouse.is_dragged = false;
-    hook->input.mouse.click.count = 0;
-    hook->input.mouse.click.time = 0;
-    hook->input.mouse.click.button = MOUSE_NOBUTTON;
+    // Reset the shared modifier and click state.
+    dispatch_reset(0x0000);
 
     int status = xrecord_start();
 
@@ -1069,40 +757,35 @@ UIOHOOK_API int hook_run() {
 UIOHOOK_API int hook_stop() {
     int status = UIOHOOK_FAILURE;
 
-    if (hook != NULL && hook->ctrl.display != NULL && hook->ctrl.context != 0) {
-        // We need to make sure the context is still valid.
-        XRecordState *state = malloc(sizeof(XRecordState));
-        if (state != NULL) {
-            if (XRecordGetContext(hook->ctrl.display, hook->ctrl.context, &state) != 0) {
-                // Try to exit the thread naturally.
-                if (state->enabled && XRecordDisableContext(hook->ctrl.display, hook->ctrl.context) != 0) {
-                    #ifdef USE_XRECORD_ASYNC
-                    pthread_mutex_lock(&hook_xrecord_mutex);
-                    running = false;
-                    pthread_cond_signal(&hook_xrecord_cond);
-                    pthread_mutex_unlock(&hook_xrecord_mutex);
-                    #endif
-
-                    // See Bug 42356 for more information.
-                    // https://bugs.freedesktop.org/show_bug.cgi?id=42356#c4
-                    //XFlush(hook->ctrl.display);
-                    XSync(hook->ctrl.display, False);
-
-                    status = UIOHOOK_SUCCESS;
-                }
-            } else {
-                logger(LOG_LEVEL_ERROR, "%s [%u]: XRecordGetContext failure!\n",
-                        __FUNCTION__, __LINE__);
+    if (file_source_stop() == UIOHOOK_SUCCESS) {
+        status = UIOHOOK_SUCCESS;
+    } else if (hook != NULL && hook->ctrl.display != NULL && hook->ctrl.context != 0) {
+        // We need to make sure the context is still valid, the state is allocated by Xtst.
+        XRecordState *state = NULL;
+        if (XRecordGetContext(hook->ctrl.display, hook->ctrl.context, &state) != 0 && state != NULL) {
+            // Try to exit the thread naturally.
+            if (state->enabled && XRecordDisableContext(hook->ctrl.display, hook->ctrl.context) != 0) {
+                #ifdef USE_XRECORD_ASYNC
+                pthread_mutex_lock(&hook_xrecord_mutex);
+                running = false;
+                pthread_cond_signal(&hook_xrecord_cond);
+                pthread_mutex_unlock(&hook_xrecord_mutex);
+                #endif
+
+                // See Bug 42356 for more information.
+                // https://bugs.freedesktop.org/show_bug.cgi?id=42356#c4
+                //XFlush(hook->ctrl.display);
+                XSync(hook->ctrl.display, False);
 
-                status = UIOHOOK_ERROR_X_RECORD_GET_CONTEXT;
+                status = UIOHOOK_SUCCESS;
             }
 
-            free(state);
+            XRecordFreeState(state);
         } else {
-            logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to allocate memory for XRecordState!\n",
+            logger(LOG_LEVEL_ERROR, "%s [%u]: XRecordGetContext failure!\n",
                     __FUNCTION__, __LINE__);
 
-            status = UIOHOOK_ERROR_OUT_OF_MEMORY;
+            status = UIOHOOK_ERROR_X_RECORD_GET_CONTEXT;
         }
     }
 
@@ -19,34 +19,41 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <uiohook.h>
+#include <X11/keysym.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #ifdef USE_XTEST
 #include <X11/extensions/XTest.h>
 #endif
 
+#include "deadline_timer.h"
 #include "input_helper.h"
 #include "logger.h"
+#include "system_properties.h"
+#include "trace.h"
+#include "usdt.h"
+#ifdef USE_UINPUT
+#include "post_uinput.h"
+#endif
 
 #ifndef USE_XTEST
+#include "window_cache.h"
+
 static long current_modifier_mask = NoEventMask;
 #endif
 
-static int post_key_event(uiohook_event * const event) {
-    KeyCode keycode = scancode_to_keycode(event->data.keyboard.keycode);
-    if (keycode == 0x0000) {
-        logger(LOG_LEVEL_WARN, "%s [%u]: Unable to lookup scancode: %li\n",
-                __FUNCTION__, __LINE__, event->data.keyboard.keycode);
+static int post_keycode_event(KeyCode keycode, bool is_pressed, unsigned int state) {
+    #ifdef USE_XTEST
+    if (XTestFakeKeyEvent(helper_disp, keycode, is_pressed ? True : False, 0) == 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: XTestFakeKeyEvent() failed!\n",
+            __FUNCTION__, __LINE__);
         return UIOHOOK_FAILURE;
     }
-
-    #ifdef USE_XTEST
-    Bool is_pressed;
     #else
-    long event_mask;
-
     XKeyEvent key_event = {
+        .type = is_pressed ? KeyPress : KeyRelease,
         .serial = 0x00,
         .time = CurrentTime,
         .same_screen = True,
@@ -54,7 +61,7 @@ static int post_key_event(uiohook_event * const event) {
         .display = helper_disp,
 
         .root = XDefaultRootWindow(helper_disp),
-        .window = None,
+        .window = window_cache_get_focus(),
         .subwindow = None,
 
         .x_root = 0,
@@ -62,21 +69,41 @@ static int post_key_event(uiohook_event * const event) {
         .x = 0,
         .y = 0,
 
-        .state = current_modifier_mask,
+        .state = state,
         .keycode = keycode
     };
 
-    int revert;
-    XGetInputFocus(helper_disp, &(key_event.window), &revert);
+    long event_mask = is_pressed ? KeyPressMask : KeyReleaseMask;
+
+    if (XSendEvent(helper_disp, key_event.window, False, event_mask, (XEvent *) &key_event) == 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: XSendEvent() failed!\n",
+            __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+    #endif
+
+    return UIOHOOK_SUCCESS;
+}
+
+static int post_key_event(uiohook_event * const event) {
+    KeyCode keycode = scancode_to_keycode(event->data.keyboard.keycode);
+    if (keycode == 0x0000) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: Unable to lookup scancode: %li\n",
+                __FUNCTION__, __LINE__, event->data.keyboard.keycode);
+        return UIOHOOK_FAILURE;
+    }
+
+    bool is_pressed;
+    #ifdef USE_XTEST
+    unsigned int state = 0x00;
+    #else
+    unsigned int state = current_modifier_mask;
     #endif
 
     if (event->type == EVENT_KEY_PRESSED) {
-        #ifdef USE_XTEST
-        is_pressed = True;
-        #else
-        key_event.type = KeyPress;
-        event_mask = KeyPressMask;
+        is_pressed = true;
 
+        #ifndef USE_XTEST
         switch (event->data.keyboard.keycode) {
             case VC_SHIFT_L:
             case VC_SHIFT_R:
@@ -99,14 +126,10 @@ static int post_key_event(uiohook_event * const event) {
                 break;
         }
         #endif
-
     } else if (event->type == EVENT_KEY_RELEASED) {
-        #ifdef USE_XTEST
-        is_pressed = False;
-        #else
-        key_event.type = KeyRelease;
-        event_mask = KeyReleaseMask;
+        is_pressed = false;
 
+        #ifndef USE_XTEST
         switch (event->data.keyboard.keycode) {
             case VC_SHIFT_L:
             case VC_SHIFT_R:
@@ -135,22 +158,203 @@ static int post_key_event(uiohook_event * const event) {
         return UIOHOOK_FAILURE;
     }
 
-    #ifdef USE_XTEST
-    if (XTestFakeKeyEvent(helper_disp, keycode, is_pressed, 0) != Success) {
-        logger(LOG_LEVEL_ERROR, "%s [%u]: XTestFakeKeyEvent() failed!\n",
-            __FUNCTION__, __LINE__, event->type);
+    return post_keycode_event(keycode, is_pressed, state);
+}
+
+#ifdef USE_XTEST
+// Shift keys held by the user when hook_post_text() was called.
+#define TYPING_HELD_SHIFT_SIZE 8
+
+// Keyboard state the characters of a single hook_post_text() call are typed against.
+typedef struct _typing_state {
+    KeyCode shift_keycode;          // First key code of the Shift modifier, 0x00 if there is none.
+    KeyCode held_shift[TYPING_HELD_SHIFT_SIZE];
+    unsigned int held_count;
+    bool lock;                      // Lock modifier active, inverts the shift level of letters.
+} typing_state;
+
+// Loaded by hook_post_text() while helper_disp is locked.
+static typing_state typing;
+
+static void load_typing_state() {
+    memset(&typing, 0x00, sizeof(typing_state));
+
+    char keymap[32];
+    XQueryKeymap(helper_disp, keymap);
+
+    // The real Shift key codes, keysym_to_keycode() could bind XK_Shift_L to a spare key code.
+    XModifierKeymap *modifiers = XGetModifierMapping(helper_disp);
+    if (modifiers != NULL) {
+        for (int i = 0; i < modifiers->max_keypermod; i++) {
+            KeyCode keycode = modifiers->modifiermap[ShiftMapIndex * modifiers->max_keypermod + i];
+            if (keycode == 0x00) {
+                continue;
+            }
+
+            if (typing.shift_keycode == 0x00) {
+                typing.shift_keycode = keycode;
+            }
+
+            if (keymap[keycode / 8] & (1 << (keycode % 8)) && typing.held_count < TYPING_HELD_SHIFT_SIZE) {
+                typing.held_shift[typing.held_count++] = keycode;
+            }
+        }
+
+        XFreeModifiermap(modifiers);
+    }
+
+    Window unused_win;
+    int unused_int;
+    unsigned int mask = 0x00;
+    if (XQueryPointer(helper_disp, XDefaultRootWindow(helper_disp), &unused_win, &unused_win,
+            &unused_int, &unused_int, &unused_int, &unused_int, &mask)) {
+        typing.lock = (mask & LockMask) != 0;
+    }
+}
+
+// Press or release the Shift keys held by the user.
+static void post_held_shift(bool is_pressed) {
+    for (unsigned int i = 0; i < typing.held_count; i++) {
+        post_keycode_event(typing.held_shift[i], is_pressed, 0x00);
+    }
+}
+#endif
+
+// Type a single Unicode code point using the current keyboard mapping.
+static int post_unicode_event(uint32_t unicode) {
+    KeySym keysym;
+    switch (unicode) {
+        case '\b':
+            keysym = XK_BackSpace;
+            break;
+
+        case '\t':
+            keysym = XK_Tab;
+            break;
+
+        case '\n':
+        case '\r':
+            keysym = XK_Return;
+            break;
+
+        case 0x1B:
+            keysym = XK_Escape;
+            break;
+
+        case 0x7F:
+            keysym = XK_Delete;
+            break;
+
+        default:
+            if (unicode < 0x20 || (unicode >= 0xD800 && unicode <= 0xDFFF) || unicode > 0x10FFFF) {
+                logger(LOG_LEVEL_WARN, "%s [%u]: Unable to type character: %#X.\n",
+                        __FUNCTION__, __LINE__, unicode);
+                return UIOHOOK_FAILURE;
+            } else if (unicode <= 0xFFFF) {
+                keysym = unicode_to_keysym((uint16_t) unicode);
+            } else {
+                // Characters outside the BMP are directly encoded 24-bit UCS key symbols.
+                keysym = unicode | 0x01000000;
+            }
+            break;
+    }
+
+    unsigned int level;
+    KeyCode keycode = keysym_to_keycode(keysym, &level);
+    if (keycode == 0x00) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: Unable to lookup key symbol: %#lX.\n",
+                __FUNCTION__, __LINE__, (unsigned long) keysym);
+        return UIOHOOK_FAILURE;
+    } else if (level > 1) {
+        // Only reachable with modifiers other than Shift, such as AltGr.
+        logger(LOG_LEVEL_WARN, "%s [%u]: Unsupported shift level %u for key symbol: %#lX.\n",
+                __FUNCTION__, __LINE__, level, (unsigned long) keysym);
         return UIOHOOK_FAILURE;
     }
+
+    int status;
+    #ifdef USE_XTEST
+    // Compensate for the Shift and Lock state of the user's keyboard.
+    KeySym lower, upper;
+    XConvertCase(keysym, &lower, &upper);
+    bool shift = (level > 0) != (typing.lock && lower != upper);
+    bool held = typing.held_count > 0;
+
+    if (shift && !held) {
+        if (typing.shift_keycode == 0x00) {
+            logger(LOG_LEVEL_WARN, "%s [%u]: No key code is bound to the Shift modifier!\n",
+                    __FUNCTION__, __LINE__);
+            return UIOHOOK_FAILURE;
+        }
+
+        post_keycode_event(typing.shift_keycode, true, 0x00);
+    } else if (!shift && held) {
+        post_held_shift(false);
+    }
+
+    status = post_keycode_event(keycode, true, 0x00);
+    if (status == UIOHOOK_SUCCESS) {
+        status = post_keycode_event(keycode, false, 0x00);
+    }
+
+    if (shift && !held) {
+        post_keycode_event(typing.shift_keycode, false, 0x00);
+    } else if (!shift && held) {
+        post_held_shift(true);
+    }
     #else
-    XSelectInput(helper_disp, key_event.window, KeyPressMask | KeyReleaseMask);
-    if (XSendEvent(helper_disp, key_event.window, False, event_mask, (XEvent *) &key_event) == 0) {
-        logger(LOG_LEVEL_ERROR, "%s [%u]: XSendEvent() failed!\n",
-            __FUNCTION__, __LINE__, event->type);
-        return UIOHOOK_FAILURE;
+    // The state of a sent event replaces the keyboard state, so only the shift level matters.
+    unsigned int state = current_modifier_mask & ~(ShiftMask | LockMask);
+    if (level > 0) {
+        state |= ShiftMask;
+    }
+
+    status = post_keycode_event(keycode, true, state);
+    if (status == UIOHOOK_SUCCESS) {
+        status = post_keycode_event(keycode, false, state);
     }
     #endif
 
-    return UIOHOOK_SUCCESS;
+    return status;
+}
+
+// Decode the next UTF-8 sequence, returning the number of bytes consumed.
+static size_t utf8_decode(const unsigned char *utf8, size_t length, uint32_t *unicode) {
+    size_t size;
+    if (utf8[0] < 0x80) {
+        *unicode = utf8[0];
+        return 1;
+    } else if ((utf8[0] & 0xE0) == 0xC0) {
+        *unicode = utf8[0] & 0x1F;
+        size = 2;
+    } else if ((utf8[0] & 0xF0) == 0xE0) {
+        *unicode = utf8[0] & 0x0F;
+        size = 3;
+    } else if ((utf8[0] & 0xF8) == 0xF0) {
+        *unicode = utf8[0] & 0x07;
+        size = 4;
+    } else {
+        return 0;
+    }
+
+    if (size > length) {
+        return 0;
+    }
+
+    for (size_t i = 1; i < size; i++) {
+        if ((utf8[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+
+        *unicode = (*unicode << 6) | (utf8[i] & 0x3F);
+    }
+
+    // Reject overlong encodings.
+    if ((size == 2 && *unicode < 0x80) || (size == 3 && *unicode < 0x800) || (size == 4 && *unicode < 0x10000)) {
+        return 0;
+    }
+
+    return size;
 }
 
 static int post_mouse_button_event(uiohook_event * const event) {
@@ -185,21 +389,11 @@ static int post_mouse_button_event(uiohook_event * const event) {
 
     #ifndef USE_XTEST
     // FIXME This is still not working correctly, clicking on other windows does not yield focus.
-    while (btn_event.subwindow != None)
-    {
-        btn_event.window = btn_event.subwindow;
-        XQueryPointer (
-            btn_event.display,
-            btn_event.window,
-            &btn_event.root,
-            &btn_event.subwindow,
-            &btn_event.x_root,
-            &btn_event.y_root,
-            &btn_event.x,
-            &btn_event.y,
-            &btn_event.state
-        );
-    }
+    btn_event.root = XDefaultRootWindow(helper_disp);
+    btn_event.subwindow = None;
+    btn_event.x_root = event->data.mouse.x;
+    btn_event.y_root = event->data.mouse.y;
+    btn_event.window = window_cache_get_window_at(btn_event.x_root, btn_event.y_root, &btn_event.x, &btn_event.y);
     #endif
 
     switch (event->type) {
@@ -302,21 +496,11 @@ static int post_mouse_wheel_event(uiohook_event * const event) {
 
     #ifndef USE_XTEST
     // FIXME This is still not working correctly, clicking on other windows does not yield focus.
-    while (btn_event.subwindow != None)
-    {
-        btn_event.window = btn_event.subwindow;
-        XQueryPointer (
-            btn_event.display,
-            btn_event.window,
-            &btn_event.root,
-            &btn_event.subwindow,
-            &btn_event.x_root,
-            &btn_event.y_root,
-            &btn_event.x,
-            &btn_event.y,
-            &btn_event.state
-        );
-    }
+    btn_event.root = XDefaultRootWindow(helper_disp);
+    btn_event.subwindow = None;
+    btn_event.x_root = event->data.wheel.x;
+    btn_event.y_root = event->data.wheel.y;
+    btn_event.window = window_cache_get_window_at(btn_event.x_root, btn_event.y_root, &btn_event.x, &btn_event.y);
     #endif
 
     // Wheel events should be the same as click events on X11.
@@ -364,7 +548,7 @@ static void post_mouse_motion_event(uiohook_event * const event) {
         .y = event->data.mouse.y,
 
         .x_root = event->data.mouse.x,                    /* coordinates relative to root */
-        .y_root = event->data.mouse.x,
+        .y_root = event->data.mouse.y,
 
         .state = current_modifier_mask|MotionNotify,      /* key or button mask */
 
@@ -372,44 +556,40 @@ static void post_mouse_motion_event(uiohook_event * const event) {
         .same_screen = True
     };
 
-    int revert;
-    XGetInputFocus(helper_disp, &(mov_event.window), &revert);
+    mov_event.window = window_cache_get_window_at(mov_event.x_root, mov_event.y_root, &mov_event.x, &mov_event.y);
 
     XSendEvent(helper_disp, mov_event.window, False, mov_event.state, (XEvent *) &mov_event);
     #endif
 }
 
-// TODO This should return a status code, UIOHOOK_SUCCESS or otherwise.
-UIOHOOK_API void hook_post_event(uiohook_event * const event) {
-    if (helper_disp == NULL) {
-        logger(LOG_LEVEL_ERROR, "%s [%u]: XDisplay helper_disp is unavailable!\n",
-            __FUNCTION__, __LINE__);
-        return; // UIOHOOK_ERROR_X_OPEN_DISPLAY
-    }
-
-    XLockDisplay(helper_disp);
+static int post_x11_event(uiohook_event * const event) {
+    int status = UIOHOOK_FAILURE;
 
     switch (event->type) {
         case EVENT_KEY_PRESSED:
         case EVENT_KEY_RELEASED:
-            post_key_event(event);
+            status = post_key_event(event);
             break;
 
         case EVENT_MOUSE_PRESSED:
         case EVENT_MOUSE_RELEASED:
-            post_mouse_button_event(event);
+            status = post_mouse_button_event(event);
             break;
 
         case EVENT_MOUSE_WHEEL:
-            post_mouse_wheel_event(event);
+            status = post_mouse_wheel_event(event);
             break;
 
         case EVENT_MOUSE_MOVED:
         case EVENT_MOUSE_DRAGGED:
             post_mouse_motion_event(event);
+            status = UIOHOOK_SUCCESS;
             break;
 
         case EVENT_KEY_TYPED:
+            status = post_unicode_event(event->data.keyboard.keychar);
+            break;
+
         case EVENT_MOUSE_CLICKED:
 
         case EVENT_HOOK_ENABLED:
@@ -421,7 +601,356 @@ UIOHOOK_API void hook_post_event(uiohook_event * const event) {
             break;
     }
 
+    return status;
+}
+
+/* Lock helper_disp for posting.  Without XTest, events are sent to cached
+ * windows that may be destroyed at any time, so BadWindow errors are trapped
+ * until unlock_post_display() synchronizes with the X server.
+ */
+static void lock_post_display() {
+    XLockDisplay(helper_disp);
+
+    #ifndef USE_XTEST
+    window_cache_trap_errors(helper_disp);
+    #endif
+}
+
+static void unlock_post_display() {
+    #ifndef USE_XTEST
+    window_cache_untrap_errors();
+    #endif
+
+    XUnlockDisplay(helper_disp);
+}
+
+static int post_event(uiohook_event * const event) {
+    #ifdef USE_UINPUT
+    // Events supported by the virtual devices do not go through the X server.
+    if (uinput_post_event(event) == UIOHOOK_SUCCESS) {
+        return UIOHOOK_SUCCESS;
+    }
+    #endif
+
+    return post_x11_event(event);
+}
+
+// TODO This should return a status code, UIOHOOK_SUCCESS or otherwise.
+UIOHOOK_API void hook_post_event(uiohook_event * const event) {
+    USDT_PROBE2(post_begin, event->type, event->time);
+    TRACE_BEGIN(span);
+    load_library();
+
+    #ifdef USE_UINPUT
+    if (uinput_post_event(event) == UIOHOOK_SUCCESS) {
+        TRACE_END(TRACE_STAGE_POST, event->type, span);
+        USDT_PROBE2(post_end, event->type, event->time);
+        return;
+    }
+    #endif
+
+    if (helper_disp == NULL) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: XDisplay helper_disp is unavailable!\n",
+            __FUNCTION__, __LINE__);
+        TRACE_END(TRACE_STAGE_POST, event->type, span);
+        USDT_PROBE2(post_end, event->type, event->time);
+        return; // UIOHOOK_ERROR_X_OPEN_DISPLAY
+    }
+
+    lock_post_display();
+
+    post_x11_event(event);
+
     // Don't forget to flush!
     XSync(helper_disp, True);
+    unlock_post_display();
+    TRACE_END(TRACE_STAGE_POST, event->type, span);
+    USDT_PROBE2(post_end, event->type, event->time);
+}
+
+UIOHOOK_API int hook_post_text(const char *utf8, size_t length) {
+    load_library();
+
+    if (helper_disp == NULL) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: XDisplay helper_disp is unavailable!\n",
+            __FUNCTION__, __LINE__);
+        return UIOHOOK_ERROR_X_OPEN_DISPLAY;
+    }
+
+    int status = UIOHOOK_SUCCESS;
+
+    lock_post_display();
+
+    #ifdef USE_XTEST
+    load_typing_state();
+    #endif
+
+    // The whole sequence is queued and only synchronized once at the end.
+    size_t i = 0;
+    while (i < length) {
+        uint32_t unicode;
+        size_t size = utf8_decode((const unsigned char *) &utf8[i], length - i, &unicode);
+        if (size == 0) {
+            logger(LOG_LEVEL_WARN, "%s [%u]: Invalid UTF-8 sequence at offset %zu!\n",
+                    __FUNCTION__, __LINE__, i);
+
+            status = UIOHOOK_FAILURE;
+            i++;
+            continue;
+        }
+
+        // Treat CRLF as a single line break.
+        if (unicode == '\r' && i + 1 < length && utf8[i + 1] == '\n') {
+            size++;
+        }
+
+        if (post_unicode_event(unicode) != UIOHOOK_SUCCESS) {
+            status = UIOHOOK_FAILURE;
+        }
+
+        i += size;
+    }
+
+    XSync(helper_disp, False);
+    unlock_post_display();
+
+    return status;
+}
+
+// Evaluate the motion path at t in the range [0, 1].
+static void evaluate_motion_path(const motion_path *path, double *scratch, double t, double *x, double *y) {
+    const motion_point *points = path->points;
+
+    switch (path->type) {
+        case MOTION_PATH_LINE:
+            *x = points[0].x + (points[1].x - points[0].x) * t;
+            *y = points[0].y + (points[1].y - points[0].y) * t;
+            break;
+
+        case MOTION_PATH_BEZIER:
+            // De Casteljau's algorithm, reducing the control polygon in place.
+            for (size_t i = 0; i < path->count; i++) {
+                scratch[i * 2] = points[i].x;
+                scratch[i * 2 + 1] = points[i].y;
+            }
+
+            for (size_t n = path->count - 1; n > 0; n--) {
+                for (size_t i = 0; i < n; i++) {
+                    scratch[i * 2] += (scratch[(i + 1) * 2] - scratch[i * 2]) * t;
+                    scratch[i * 2 + 1] += (scratch[(i + 1) * 2 + 1] - scratch[i * 2 + 1]) * t;
+                }
+            }
+
+            *x = scratch[0];
+            *y = scratch[1];
+            break;
+
+        case MOTION_PATH_POINTS:
+            {
+                double position = t * (path->count - 1);
+                size_t segment = (size_t) position;
+                if (segment >= path->count - 1) {
+                    segment = path->count - 2;
+                }
+
+                double s = position - segment;
+                *x = points[segment].x + (points[segment + 1].x - points[segment].x) * s;
+                *y = points[segment].y + (points[segment + 1].y - points[segment].y) * s;
+            }
+            break;
+    }
+}
+
+static int16_t round_coordinate(double value) {
+    return (int16_t) (value < 0 ? value - 0.5 : value + 0.5);
+}
+
+UIOHOOK_API int hook_post_motion_path(const motion_path *path) {
+    load_library();
+
+    if (helper_disp == NULL) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: XDisplay helper_disp is unavailable!\n",
+            __FUNCTION__, __LINE__);
+        return UIOHOOK_ERROR_X_OPEN_DISPLAY;
+    }
+
+    if (path == NULL || path->points == NULL || path->count < 2 || path->rate == 0
+            || path->type < MOTION_PATH_LINE || path->type > MOTION_PATH_POINTS
+            || (path->type == MOTION_PATH_LINE && path->count != 2)) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: Invalid motion path!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+
+    double *scratch = NULL;
+    if (path->type == MOTION_PATH_BEZIER) {
+        scratch = (double *) malloc(sizeof(double) * path->count * 2);
+        if (scratch == NULL) {
+            logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to allocate memory for motion path!\n",
+                    __FUNCTION__, __LINE__);
+            return UIOHOOK_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    deadline_timer timer;
+    if (!deadline_timer_init(&timer)) {
+        free(scratch);
+        return UIOHOOK_FAILURE;
+    }
+
+    // The first event is posted immediately and the last lands exactly on the end of the path.
+    uint64_t steps = (uint64_t) path->duration * path->rate / 1000;
+    if (steps == 0) {
+        steps = 1;
+    }
+
+    uint64_t duration = (uint64_t) path->duration * 1000000;
+    uint64_t interval = duration / steps, remainder = duration % steps;
+    uint64_t start = deadline_timer_now();
+
+    uiohook_event event = {
+        .type = EVENT_MOUSE_MOVED,
+        .mask = 0x00
+    };
+
+    int status = UIOHOOK_SUCCESS;
+    bool posted = false;
+    for (uint64_t i = 0; i <= steps; i++) {
+        // Deadlines are relative to the start so scheduling latency never accumulates.
+        if (!deadline_timer_wait(&timer, start + interval * i + remainder * i / steps)) {
+            status = UIOHOOK_FAILURE;
+            break;
+        }
+
+        double x, y;
+        evaluate_motion_path(path, scratch, (double) i / steps, &x, &y);
+
+        int16_t point_x = round_coordinate(x), point_y = round_coordinate(y);
+        if (posted && point_x == event.data.mouse.x && point_y == event.data.mouse.y) {
+            continue;
+        }
+
+        event.data.mouse.x = point_x;
+        event.data.mouse.y = point_y;
+
+        lock_post_display();
+        post_event(&event);
+        XFlush(helper_disp);
+        unlock_post_display();
+
+        posted = true;
+    }
+
+    deadline_timer_destroy(&timer);
+    free(scratch);
+
+    return status;
+}
+
+static int compare_schedule_error(const void *a, const void *b) {
+    int64_t x = *((const int64_t *) a), y = *((const int64_t *) b);
+
+    return (x > y) - (x < y);
+}
+
+UIOHOOK_API int hook_replay_events(const uiohook_event *events, size_t count, double speed, replay_stats *stats) {
+    load_library();
+
+    if (helper_disp == NULL) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: XDisplay helper_disp is unavailable!\n",
+            __FUNCTION__, __LINE__);
+        return UIOHOOK_ERROR_X_OPEN_DISPLAY;
+    }
+
+    if (events == NULL || !(speed > 0)) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: Invalid replay parameters!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+
+    int64_t *errors = NULL;
+    if (stats != NULL) {
+        memset(stats, 0, sizeof(replay_stats));
+
+        if (count > 0) {
+            errors = (int64_t *) malloc(sizeof(int64_t) * count);
+            if (errors == NULL) {
+                logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to allocate memory for replay statistics!\n",
+                        __FUNCTION__, __LINE__);
+                return UIOHOOK_ERROR_OUT_OF_MEMORY;
+            }
+        }
+    }
+
+    deadline_timer timer;
+    if (!deadline_timer_init(&timer)) {
+        free(errors);
+        return UIOHOOK_FAILURE;
+    }
+
+    int status = UIOHOOK_SUCCESS;
+    size_t posted = 0;
+    uint64_t start = deadline_timer_now();
+    for (size_t i = 0; i < count; i++) {
+        // Typed and clicked events are synthesized from the press and release events they follow.
+        if (events[i].type == EVENT_KEY_TYPED || events[i].type == EVENT_MOUSE_CLICKED
+                || events[i].type == EVENT_HOOK_ENABLED || events[i].type == EVENT_HOOK_DISABLED) {
+            continue;
+        }
+
+        // Deadlines are relative to the first event so scheduling latency never accumulates.
+        uint64_t offset = events[i].time > events[0].time ? events[i].time - events[0].time : 0;
+        uint64_t deadline = start + (uint64_t) (offset * 1000000 / speed);
+        if (!deadline_timer_wait(&timer, deadline)) {
+            status = UIOHOOK_FAILURE;
+            break;
+        }
+
+        /* Requests are only flushed so injection never waits on a server round
+         * trip, except without XTest where errors must be collected while
+         * they are trapped.
+         */
+        lock_post_display();
+        uiohook_event event = events[i];
+        if (post_event(&event) != UIOHOOK_SUCCESS) {
+            status = UIOHOOK_FAILURE;
+        }
+        XFlush(helper_disp);
+        unlock_post_display();
+
+        if (errors != NULL) {
+            errors[posted] = (int64_t) (deadline_timer_now() - deadline);
+        }
+        posted++;
+    }
+
+    XLockDisplay(helper_disp);
+    XSync(helper_disp, False);
     XUnlockDisplay(helper_disp);
+
+    deadline_timer_destroy(&timer);
+
+    if (stats != NULL && posted > 0) {
+        qsort(errors, posted, sizeof(int64_t), compare_schedule_error);
+
+        int64_t total = 0;
+        for (size_t i = 0; i < posted; i++) {
+            total += errors[i];
+        }
+
+        stats->count = posted;
+        stats->min = errors[0];
+        stats->mean = total / (int64_t) posted;
+        stats->p50 = errors[posted * 50 / 100];
+        stats->p90 = errors[posted * 90 / 100];
+        stats->p99 = errors[posted * 99 / 100];
+        stats->max = errors[posted - 1];
+
+        logger(LOG_LEVEL_DEBUG, "%s [%u]: Replayed %zu events, schedule error p50 %lli ns, p99 %lli ns, max %lli ns.\n",
+                __FUNCTION__, __LINE__, posted, (long long) stats->p50, (long long) stats->p99, (long long) stats->max);
+    }
+
+    free(errors);
+
+    return status;
 }
@@ -0,0 +1,277 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <uiohook.h>
+#include <unistd.h>
+#include <X11/Xlib.h>
+
+#include "input_helper.h"
+#include "logger.h"
+#include "post_uinput.h"
+
+// Largest batch written for a single event: position, button and SYN_REPORT.
+#define UINPUT_BATCH_SIZE 4
+
+/* Milliseconds to wait after creating the devices.  Events written before
+ * the display server has opened the new evdev nodes are silently lost.
+ */
+#define UINPUT_SETTLE_TIME 100
+
+static pthread_once_t devices_once = PTHREAD_ONCE_INIT;
+static int keyboard_fd = -1;
+static int mouse_fd = -1;
+
+static const uint16_t button_codes[] = {
+    [MOUSE_BUTTON1] = BTN_LEFT,
+    [MOUSE_BUTTON2] = BTN_RIGHT,
+    [MOUSE_BUTTON3] = BTN_MIDDLE,
+    [MOUSE_BUTTON4] = BTN_SIDE,
+    [MOUSE_BUTTON5] = BTN_EXTRA
+};
+
+static inline void set_input_event(struct input_event *event, uint16_t type, uint16_t code, int32_t value) {
+    memset(event, 0, sizeof(struct input_event));
+    event->type = type;
+    event->code = code;
+    event->value = value;
+}
+
+// Write the batch with a single system call, the kernel delivers it as one frame.
+static int write_batch(int fd, struct input_event *batch, size_t count) {
+    set_input_event(&batch[count++], EV_SYN, SYN_REPORT, 0);
+
+    ssize_t size = sizeof(struct input_event) * count;
+    if (write(fd, batch, size) != size) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to write uinput events! (%d)\n",
+                __FUNCTION__, __LINE__, errno);
+        return UIOHOOK_FAILURE;
+    }
+
+    return UIOHOOK_SUCCESS;
+}
+
+int uinput_post_event(uiohook_event * const event) {
+    struct input_event batch[UINPUT_BATCH_SIZE];
+    size_t count = 0;
+    int fd;
+
+    if (!load_uinput_devices()) {
+        return UIOHOOK_FAILURE;
+    }
+
+    switch (event->type) {
+        case EVENT_KEY_PRESSED:
+        case EVENT_KEY_RELEASED:
+            {
+                uint16_t code = scancode_to_evdev(event->data.keyboard.keycode);
+                if (code == 0x0000) {
+                    logger(LOG_LEVEL_WARN, "%s [%u]: Unable to lookup scancode: %#X\n",
+                            __FUNCTION__, __LINE__, event->data.keyboard.keycode);
+                    return UIOHOOK_FAILURE;
+                }
+
+                fd = keyboard_fd;
+                set_input_event(&batch[count++], EV_KEY, code, event->type == EVENT_KEY_PRESSED ? 1 : 0);
+            }
+            break;
+
+        case EVENT_MOUSE_PRESSED:
+        case EVENT_MOUSE_RELEASED:
+            if (event->data.mouse.button < MOUSE_BUTTON1 || event->data.mouse.button > MOUSE_BUTTON5) {
+                logger(LOG_LEVEL_WARN, "%s [%u]: Invalid button specified for mouse event! (%u)\n",
+                        __FUNCTION__, __LINE__, event->data.mouse.button);
+                return UIOHOOK_FAILURE;
+            }
+
+            fd = mouse_fd;
+            set_input_event(&batch[count++], EV_ABS, ABS_X, event->data.mouse.x);
+            set_input_event(&batch[count++], EV_ABS, ABS_Y, event->data.mouse.y);
+            set_input_event(&batch[count++], EV_KEY, button_codes[event->data.mouse.button],
+                    event->type == EVENT_MOUSE_PRESSED ? 1 : 0);
+            break;
+
+        case EVENT_MOUSE_MOVED:
+        case EVENT_MOUSE_DRAGGED:
+            fd = mouse_fd;
+            set_input_event(&batch[count++], EV_ABS, ABS_X, event->data.mouse.x);
+            set_input_event(&batch[count++], EV_ABS, ABS_Y, event->data.mouse.y);
+            break;
+
+        case EVENT_MOUSE_WHEEL:
+            // Negative rotation is up or left, REL_WHEEL is positive when scrolling up.
+            fd = mouse_fd;
+            if (event->data.wheel.direction == WHEEL_HORIZONTAL_DIRECTION) {
+                set_input_event(&batch[count++], EV_REL, REL_HWHEEL, event->data.wheel.rotation);
+            } else {
+                set_input_event(&batch[count++], EV_REL, REL_WHEEL, -event->data.wheel.rotation);
+            }
+            break;
+
+        default:
+            return UIOHOOK_FAILURE;
+    }
+
+    if (fd < 0) {
+        return UIOHOOK_FAILURE;
+    }
+
+    return write_batch(fd, batch, count);
+}
+
+static int create_device(const char *name, uint16_t product) {
+    int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: Failed to open /dev/uinput! (%d)\n",
+                __FUNCTION__, __LINE__, errno);
+        return -1;
+    }
+
+    struct uinput_setup setup;
+    memset(&setup, 0, sizeof(setup));
+    setup.id.bustype = BUS_VIRTUAL;
+    setup.id.vendor = 0x0000;
+    setup.id.product = product;
+    setup.id.version = 1;
+    strncpy(setup.name, name, UINPUT_MAX_NAME_SIZE - 1);
+
+    if (ioctl(fd, UI_DEV_SETUP, &setup) < 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: UI_DEV_SETUP failed! (%d)\n",
+                __FUNCTION__, __LINE__, errno);
+
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static bool create_keyboard() {
+    int fd = create_device(UINPUT_KEYBOARD_NAME, 0x0001);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool success = ioctl(fd, UI_SET_EVBIT, EV_KEY) >= 0;
+    for (uint16_t code = KEY_ESC; success && code <= KEY_MICMUTE; code++) {
+        success = ioctl(fd, UI_SET_KEYBIT, code) >= 0;
+    }
+
+    if (!success || ioctl(fd, UI_DEV_CREATE) < 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to create uinput keyboard! (%d)\n",
+                __FUNCTION__, __LINE__, errno);
+
+        close(fd);
+        return false;
+    }
+
+    keyboard_fd = fd;
+    return true;
+}
+
+static bool create_mouse() {
+    // Absolute coordinates map directly to the default screen.
+    int32_t width = INT16_MAX, height = INT16_MAX;
+    if (helper_disp != NULL) {
+        XLockDisplay(helper_disp);
+        width = DisplayWidth(helper_disp, DefaultScreen(helper_disp));
+        height = DisplayHeight(helper_disp, DefaultScreen(helper_disp));
+        XUnlockDisplay(helper_disp);
+    }
+
+    int fd = create_device(UINPUT_MOUSE_NAME, 0x0002);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool success = ioctl(fd, UI_SET_EVBIT, EV_KEY) >= 0
+            && ioctl(fd, UI_SET_EVBIT, EV_REL) >= 0
+            && ioctl(fd, UI_SET_EVBIT, EV_ABS) >= 0
+            && ioctl(fd, UI_SET_RELBIT, REL_WHEEL) >= 0
+            && ioctl(fd, UI_SET_RELBIT, REL_HWHEEL) >= 0;
+
+    for (size_t i = MOUSE_BUTTON1; success && i <= MOUSE_BUTTON5; i++) {
+        success = ioctl(fd, UI_SET_KEYBIT, button_codes[i]) >= 0;
+    }
+
+    struct uinput_abs_setup abs_setup;
+    memset(&abs_setup, 0, sizeof(abs_setup));
+
+    abs_setup.code = ABS_X;
+    abs_setup.absinfo.maximum = width - 1;
+    success = success && ioctl(fd, UI_ABS_SETUP, &abs_setup) >= 0;
+
+    abs_setup.code = ABS_Y;
+    abs_setup.absinfo.maximum = height - 1;
+    success = success && ioctl(fd, UI_ABS_SETUP, &abs_setup) >= 0;
+
+    if (!success || ioctl(fd, UI_DEV_CREATE) < 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to create uinput mouse! (%d)\n",
+                __FUNCTION__, __LINE__, errno);
+
+        close(fd);
+        return false;
+    }
+
+    mouse_fd = fd;
+    return true;
+}
+
+static void create_devices() {
+    if (!create_keyboard() || !create_mouse()) {
+        unload_uinput_devices();
+        return;
+    }
+
+    struct timespec settle = {
+        .tv_sec = UINPUT_SETTLE_TIME / 1000,
+        .tv_nsec = (UINPUT_SETTLE_TIME % 1000) * 1000000
+    };
+    while (nanosleep(&settle, &settle) != 0 && errno == EINTR);
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Successfully created uinput devices.\n",
+            __FUNCTION__, __LINE__);
+}
+
+bool load_uinput_devices() {
+    pthread_once(&devices_once, create_devices);
+
+    return keyboard_fd >= 0 && mouse_fd >= 0;
+}
+
+void unload_uinput_devices() {
+    if (keyboard_fd >= 0) {
+        ioctl(keyboard_fd, UI_DEV_DESTROY);
+        close(keyboard_fd);
+        keyboard_fd = -1;
+    }
+
+    if (mouse_fd >= 0) {
+        ioctl(mouse_fd, UI_DEV_DESTROY);
+        close(mouse_fd);
+        mouse_fd = -1;
+    }
+}
@@ -0,0 +1,49 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _included_post_uinput
+#define _included_post_uinput
+
+#include <stdbool.h>
+#include <uiohook.h>
+
+// Names of the virtual devices created through /dev/uinput.
+#define UINPUT_KEYBOARD_NAME "libuiohook virtual keyboard"
+#define UINPUT_MOUSE_NAME    "libuiohook virtual mouse"
+
+/* Post a key, button, wheel or motion event through the virtual devices as a
+ * single batch of input events terminated by SYN_REPORT.  Returns
+ * UIOHOOK_FAILURE if the devices are unavailable or the event type is not
+ * supported, in which case the caller should fall back to the X11 path.
+ */
+extern int uinput_post_event(uiohook_event * const event);
+
+/* Create the virtual keyboard and mouse once and wait for them to settle,
+ * returning false if /dev/uinput is unavailable.  Absolute pointer
+ * coordinates span the default screen when an X display is available,
+ * otherwise the full int16_t range.  This method is called by the first
+ * uinput_post_event(), so the devices only exist once events are posted.
+ */
+extern bool load_uinput_devices();
+
+/* Destroy the virtual keyboard and mouse.  This method is called by
+ * on_library_unload().
+ */
+extern void unload_uinput_devices();
+
+#endif
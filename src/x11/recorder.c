@@ -0,0 +1,441 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <uiohook.h>
+#include <unistd.h>
+#include <X11/Xlib.h>
+
+#include "input_helper.h"
+#include "logger.h"
+#include "recorder.h"
+
+#ifdef USE_RECORDER
+#define RECORDER_DEFAULT_BUFFER_SIZE    65536
+#define RECORDER_DEFAULT_SYNC_INTERVAL  1000
+
+// Upper bound on how long recorded events wait in the ring buffer.
+#define RECORDER_DRAIN_INTERVAL         100
+
+// Time one in every RECORDER_SAMPLE_RATE calls to estimate the per-event overhead.
+#define RECORDER_SAMPLE_RATE            64
+
+typedef struct _recorder {
+    int fd;
+    recorder_sync_policy sync;
+    uint64_t sync_interval;
+    uint64_t last_sync;
+
+    recording_record *ring;
+    uint64_t capacity;              // Power of two.
+    uint64_t head;                  // Written by the hook thread only.
+    uint64_t tail;                  // Written by the writer thread only.
+
+    pthread_t writer_id;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool running;
+
+    // Producer side statistics, only touched by the hook thread.
+    uint64_t recorded;
+    uint64_t dropped;
+    uint64_t samples;
+    uint64_t sample_ns;
+
+    // Consumer side statistics, only touched by the writer thread.
+    uint64_t written;
+    bool failed;
+} recorder;
+
+static recorder *active = NULL;
+static unsigned int active_users = 0;
+
+
+static uint64_t get_monotonic_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+void recorder_record(const uiohook_event * const event) {
+    __atomic_add_fetch(&active_users, 1, __ATOMIC_ACQUIRE);
+
+    recorder *rec = __atomic_load_n(&active, __ATOMIC_ACQUIRE);
+    if (rec != NULL) {
+        bool sample = (rec->recorded + rec->dropped) % RECORDER_SAMPLE_RATE == 0;
+        uint64_t start = sample ? get_monotonic_ns() : 0;
+
+        uint64_t head = rec->head;
+        uint64_t tail = __atomic_load_n(&rec->tail, __ATOMIC_ACQUIRE);
+        if (head - tail < rec->capacity) {
+            recording_record *record = &rec->ring[head & (rec->capacity - 1)];
+            record->time = event->time;
+            record->type = (uint16_t) event->type;
+            record->mask = event->mask;
+            record->reserved = event->reserved;
+            memcpy(record->data, &event->data, sizeof(record->data));
+
+            __atomic_store_n(&rec->head, head + 1, __ATOMIC_RELEASE);
+            rec->recorded++;
+
+            // Wake the writer early once half of the ring buffer is in use.
+            if (head + 1 - tail == rec->capacity / 2) {
+                pthread_cond_signal(&rec->cond);
+            }
+        } else {
+            rec->dropped++;
+        }
+
+        if (sample) {
+            rec->sample_ns += get_monotonic_ns() - start;
+            rec->samples++;
+        }
+    }
+
+    __atomic_sub_fetch(&active_users, 1, __ATOMIC_RELEASE);
+}
+
+static bool write_fully(int fd, const void *buffer, size_t size) {
+    const uint8_t *data = (const uint8_t *) buffer;
+    while (size > 0) {
+        ssize_t count = write(fd, data, size);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to write recording! (%d)\n",
+                    __FUNCTION__, __LINE__, errno);
+            return false;
+        }
+
+        data += count;
+        size -= (size_t) count;
+    }
+
+    return true;
+}
+
+// Write everything currently in the ring buffer as at most two sequential writes.
+static void drain_ring(recorder *rec) {
+    uint64_t tail = rec->tail;
+    uint64_t head = __atomic_load_n(&rec->head, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return;
+    }
+
+    while (tail < head && !rec->failed) {
+        uint64_t offset = tail & (rec->capacity - 1);
+        uint64_t count = head - tail;
+        if (offset + count > rec->capacity) {
+            count = rec->capacity - offset;
+        }
+
+        size_t size = sizeof(recording_record) * count;
+        if (write_fully(rec->fd, &rec->ring[offset], size)) {
+            rec->written += size;
+        } else {
+            rec->failed = true;
+        }
+
+        tail += count;
+        __atomic_store_n(&rec->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    uint64_t now = get_monotonic_ns();
+    if (rec->sync == RECORDER_SYNC_ALWAYS
+            || (rec->sync == RECORDER_SYNC_INTERVAL && now - rec->last_sync >= rec->sync_interval)) {
+        if (fsync(rec->fd) != 0) {
+            logger(LOG_LEVEL_WARN, "%s [%u]: fsync() failed! (%d)\n",
+                    __FUNCTION__, __LINE__, errno);
+        }
+
+        rec->last_sync = now;
+    }
+}
+
+static void *writer_thread_proc(void *arg) {
+    recorder *rec = (recorder *) arg;
+
+    pthread_mutex_lock(&rec->mutex);
+    while (rec->running) {
+        struct timespec timeout;
+        clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_nsec += RECORDER_DRAIN_INTERVAL * 1000000L;
+        if (timeout.tv_nsec >= 1000000000L) {
+            timeout.tv_sec++;
+            timeout.tv_nsec -= 1000000000L;
+        }
+
+        pthread_cond_timedwait(&rec->cond, &rec->mutex, &timeout);
+        pthread_mutex_unlock(&rec->mutex);
+
+        drain_ring(rec);
+
+        pthread_mutex_lock(&rec->mutex);
+    }
+    pthread_mutex_unlock(&rec->mutex);
+
+    // Flush whatever the hook thread added before recording stopped.
+    drain_ring(rec);
+
+    if (rec->sync != RECORDER_SYNC_NONE && fsync(rec->fd) != 0) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: fsync() failed! (%d)\n",
+                __FUNCTION__, __LINE__, errno);
+    }
+
+    return NULL;
+}
+
+// Write the header, screen layout and keyboard mapping.
+static bool write_header(int fd) {
+    recording_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+    header.version = RECORDING_VERSION;
+    header.byte_order = RECORDING_BYTE_ORDER;
+    header.record_size = sizeof(recording_record);
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    header.created = (uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000;
+    header.multi_click_time = (uint32_t) hook_get_multi_click_time();
+
+    unsigned char screen_count = 0;
+    screen_data *screens = hook_create_screen_info(&screen_count);
+    header.screen_count = screens != NULL ? screen_count : 0;
+
+    KeySym *keysyms = NULL;
+    int min_keycode = 0, max_keycode = -1, width = 0;
+    if (helper_disp != NULL) {
+        XLockDisplay(helper_disp);
+        XDisplayKeycodes(helper_disp, &min_keycode, &max_keycode);
+        keysyms = XGetKeyboardMapping(helper_disp, (KeyCode) min_keycode, max_keycode - min_keycode + 1, &width);
+        XUnlockDisplay(helper_disp);
+    }
+
+    size_t keycode_count = 0;
+    if (keysyms != NULL) {
+        keycode_count = (size_t) (max_keycode - min_keycode + 1);
+        header.min_keycode = (uint8_t) min_keycode;
+        header.max_keycode = (uint8_t) max_keycode;
+        header.keysyms_per_keycode = 2;
+    }
+
+    size_t size = sizeof(recording_header)
+            + sizeof(recording_screen) * header.screen_count
+            + sizeof(uint32_t) * keycode_count * header.keysyms_per_keycode;
+    header.header_size = (uint16_t) ((size + 7) & ~((size_t) 7));
+
+    uint8_t *buffer = (uint8_t *) calloc(header.header_size, 1);
+    if (buffer == NULL) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to allocate memory for recording header!\n",
+                __FUNCTION__, __LINE__);
+
+        free(screens);
+        if (keysyms != NULL) {
+            XFree(keysyms);
+        }
+        return false;
+    }
+
+    memcpy(buffer, &header, sizeof(header));
+
+    recording_screen *screen = (recording_screen *) (buffer + sizeof(recording_header));
+    for (uint16_t i = 0; i < header.screen_count; i++) {
+        screen[i].number = screens[i].number;
+        screen[i].x = screens[i].x;
+        screen[i].y = screens[i].y;
+        screen[i].width = screens[i].width;
+        screen[i].height = screens[i].height;
+    }
+
+    // Only the first two levels of the first group are kept.
+    uint32_t *keymap = (uint32_t *) (screen + header.screen_count);
+    for (size_t i = 0; i < keycode_count; i++) {
+        keymap[i * 2] = (uint32_t) keysyms[i * width];
+        keymap[i * 2 + 1] = width > 1 ? (uint32_t) keysyms[i * width + 1] : NoSymbol;
+    }
+
+    bool success = write_fully(fd, buffer, header.header_size);
+
+    free(buffer);
+    free(screens);
+    if (keysyms != NULL) {
+        XFree(keysyms);
+    }
+
+    return success;
+}
+
+UIOHOOK_API int hook_recorder_start(const char *path, const recorder_options *options) {
+    if (__atomic_load_n(&active, __ATOMIC_ACQUIRE) != NULL) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: A recording is already in progress!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+
+    recorder *rec = (recorder *) calloc(1, sizeof(recorder));
+    if (rec == NULL) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to allocate memory for recorder!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_ERROR_OUT_OF_MEMORY;
+    }
+
+    size_t buffer_size = RECORDER_DEFAULT_BUFFER_SIZE;
+    rec->sync = RECORDER_SYNC_NONE;
+    rec->sync_interval = (uint64_t) RECORDER_DEFAULT_SYNC_INTERVAL * 1000000;
+    if (options != NULL) {
+        if (options->buffer_size > 0) {
+            buffer_size = options->buffer_size;
+        }
+
+        rec->sync = options->sync;
+        if (options->sync_interval > 0) {
+            rec->sync_interval = (uint64_t) options->sync_interval * 1000000;
+        }
+    }
+
+    // Round up to a power of two so the ring index is a mask.
+    rec->capacity = 2;
+    while (rec->capacity < buffer_size) {
+        rec->capacity <<= 1;
+    }
+
+    rec->ring = (recording_record *) calloc(rec->capacity, sizeof(recording_record));
+    if (rec->ring == NULL) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to allocate memory for recorder ring buffer!\n",
+                __FUNCTION__, __LINE__);
+
+        free(rec);
+        return UIOHOOK_ERROR_OUT_OF_MEMORY;
+    }
+
+    rec->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (rec->fd < 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to open recording: %s! (%d)\n",
+                __FUNCTION__, __LINE__, path, errno);
+
+        free(rec->ring);
+        free(rec);
+        return UIOHOOK_FAILURE;
+    }
+
+    if (!write_header(rec->fd)) {
+        close(rec->fd);
+        free(rec->ring);
+        free(rec);
+        return UIOHOOK_FAILURE;
+    }
+
+    pthread_mutex_init(&rec->mutex, NULL);
+    pthread_cond_init(&rec->cond, NULL);
+    rec->running = true;
+    rec->last_sync = get_monotonic_ns();
+
+    if (pthread_create(&rec->writer_id, NULL, writer_thread_proc, rec) != 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to create recorder writer thread!\n",
+                __FUNCTION__, __LINE__);
+
+        pthread_cond_destroy(&rec->cond);
+        pthread_mutex_destroy(&rec->mutex);
+        close(rec->fd);
+        free(rec->ring);
+        free(rec);
+        return UIOHOOK_FAILURE;
+    }
+
+    __atomic_store_n(&active, rec, __ATOMIC_RELEASE);
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Recording to %s with a %llu event ring buffer.\n",
+            __FUNCTION__, __LINE__, path, (unsigned long long) rec->capacity);
+
+    return UIOHOOK_SUCCESS;
+}
+
+UIOHOOK_API int hook_recorder_stop(recorder_stats *stats) {
+    recorder *rec = __atomic_exchange_n(&active, NULL, __ATOMIC_ACQ_REL);
+    if (rec == NULL) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: No recording is in progress!\n",
+                __FUNCTION__, __LINE__);
+        return UIOHOOK_FAILURE;
+    }
+
+    // Wait for the hook thread to leave recorder_record().
+    while (__atomic_load_n(&active_users, __ATOMIC_ACQUIRE) > 0) {
+        sched_yield();
+    }
+
+    pthread_mutex_lock(&rec->mutex);
+    rec->running = false;
+    pthread_cond_signal(&rec->cond);
+    pthread_mutex_unlock(&rec->mutex);
+
+    pthread_join(rec->writer_id, NULL);
+
+    int status = rec->failed ? UIOHOOK_FAILURE : UIOHOOK_SUCCESS;
+    if (close(rec->fd) != 0) {
+        status = UIOHOOK_FAILURE;
+    }
+
+    if (stats != NULL) {
+        stats->recorded = rec->recorded;
+        stats->dropped = rec->dropped;
+        stats->written = rec->written;
+        stats->overhead = rec->samples > 0 ? rec->sample_ns / rec->samples : 0;
+    }
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Recorded %llu events, dropped %llu.\n",
+            __FUNCTION__, __LINE__, (unsigned long long) rec->recorded, (unsigned long long) rec->dropped);
+
+    pthread_cond_destroy(&rec->cond);
+    pthread_mutex_destroy(&rec->mutex);
+    free(rec->ring);
+    free(rec);
+
+    return status;
+}
+#else
+UIOHOOK_API int hook_recorder_start(const char *path, const recorder_options *options) {
+    (void) path;
+    (void) options;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Recording requires USE_RECORDER!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
+
+UIOHOOK_API int hook_recorder_stop(recorder_stats *stats) {
+    (void) stats;
+
+    logger(LOG_LEVEL_WARN, "%s [%u]: Recording requires USE_RECORDER!\n",
+            __FUNCTION__, __LINE__);
+
+    return UIOHOOK_FAILURE;
+}
+#endif
@@ -0,0 +1,77 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _included_recorder
+#define _included_recorder
+
+#include <stdint.h>
+#include <uiohook.h>
+
+/* Recording file layout, all values in host byte order as identified by
+ * byte_order:
+ *
+ *    recording_header
+ *    recording_screen[screen_count]
+ *    uint32_t keysyms[(max_keycode - min_keycode + 1) * keysyms_per_keycode]
+ *    padding up to header_size
+ *    recording_record[...]
+ */
+#define RECORDING_MAGIC         "UIOHREC"
+#define RECORDING_VERSION       3
+#define RECORDING_BYTE_ORDER    0x0102
+
+typedef struct _recording_header {
+    char magic[8];
+    uint16_t version;
+    uint16_t byte_order;
+    uint16_t header_size;           // Offset of the first record, a multiple of 8.
+    uint16_t record_size;
+    uint64_t created;               // Milliseconds since the epoch.
+    uint16_t screen_count;
+    uint8_t min_keycode;
+    uint8_t max_keycode;
+    uint8_t keysyms_per_keycode;
+    uint8_t reserved[3];
+    uint32_t multi_click_time;      // Milliseconds, clicks are counted again when replayed.
+    uint8_t padding[4];
+} recording_header;
+
+typedef struct _recording_screen {
+    uint8_t number;
+    uint8_t reserved;
+    int16_t x;
+    int16_t y;
+    uint16_t width;
+    uint16_t height;
+} recording_screen;
+
+typedef struct _recording_record {
+    uint64_t time;
+    uint16_t type;
+    uint16_t mask;
+    uint16_t reserved;
+    uint8_t data[sizeof(((uiohook_event *) 0)->data)]; // Raw copy of the uiohook_event data union.
+} recording_record;
+
+/* Copy an event into the active recording's ring buffer.  Never blocks; the
+ * event is counted as dropped if the ring buffer is full.  Called by the hook
+ * thread before dispatching each event.
+ */
+extern void recorder_record(const uiohook_event * const event);
+
+#endif
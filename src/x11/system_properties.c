@@ -16,12 +16,17 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <limits.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <uiohook.h>
+#include <X11/Xatom.h>
 #include <X11/Xlib.h>
 #include <X11/XKBlib.h>
+#include <X11/Xresource.h>
 
 #ifdef USE_XF86MISC
 #include <X11/extensions/xf86misc.h>
@@ -31,409 +36,494 @@
 #if defined(USE_XINERAMA) && !defined(USE_XRANDR)
 #include <X11/extensions/Xinerama.h>
 #elif defined(USE_XRANDR)
-#include <pthread.h>
 #include <X11/extensions/Xrandr.h>
 #endif
 
 #ifdef USE_XT
 #include <X11/Intrinsic.h>
 
+static pthread_once_t xt_once = PTHREAD_ONCE_INIT;
 static XtAppContext xt_context;
 static Display *xt_disp;
 #endif
 
+#include "dispatch_event.h"
+#include "file_source.h"
 #include "input_helper.h"
 #include "logger.h"
+#include "seqlock.h"
+#include "system_properties.h"
+#ifdef USE_UINPUT
+#include "post_uinput.h"
+#endif
+#ifndef USE_XTEST
+#include "window_cache.h"
+#endif
 
-#ifdef USE_XRANDR
-static pthread_mutex_t xrandr_mutex = PTHREAD_MUTEX_INITIALIZER;
-static XRRScreenResources *xrandr_resources = NULL;
-
-static void settings_cleanup_proc(void *arg) {
-    if (pthread_mutex_trylock(&xrandr_mutex) == 0) {
-        if (xrandr_resources != NULL) {
-            XRRFreeScreenResources(xrandr_resources);
-            xrandr_resources = NULL;
-        }
-
-        if (arg != NULL) {
-            XCloseDisplay((Display *) arg);
-            arg = NULL;
-        }
-
-        pthread_mutex_unlock(&xrandr_mutex);
-    }
-}
-
-static void *settings_thread_proc(void *arg) {
-    Display *settings_disp = XOpenDisplay(XDisplayName(NULL));;
-    if (settings_disp != NULL) {
-        logger(LOG_LEVEL_DEBUG, "%s [%u]: %s\n",
-                __FUNCTION__, __LINE__, "XOpenDisplay success.");
-
-        pthread_cleanup_push(settings_cleanup_proc, settings_disp);
-
-        int event_base = 0;
-        int error_base = 0;
-        if (XRRQueryExtension(settings_disp, &event_base, &error_base)) {
-            Window root = XDefaultRootWindow(settings_disp);
-            unsigned long event_mask = RRScreenChangeNotifyMask;
-            XRRSelectInput(settings_disp, root, event_mask);
+static pthread_once_t library_once = PTHREAD_ONCE_INIT;
 
-            XEvent ev;
+/* Property snapshot published by load_settings() and the settings thread, and
+ * read without locking by hook_get_system_properties().  Writers serialize on
+ * properties_mutex.
+ */
+static pthread_once_t settings_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t properties_mutex = PTHREAD_MUTEX_INITIALIZER;
+static seqlock properties_lock = SEQLOCK_INITIALIZER;
+static system_properties properties = {
+    .auto_repeat_rate = -1,
+    .auto_repeat_delay = -1,
+    .pointer_acceleration_multiplier = -1,
+    .pointer_acceleration_threshold = -1,
+    .pointer_sensitivity = -1,
+    .multi_click_time = 200
+};
+
+/* Screen layout published by update_screen_layout() and read without locking
+ * by hook_get_screen_info().  The sequence of layout_lock only changes when the
+ * layout does, so it is also reported as the layout generation.
+ */
+typedef struct _screen_layout {
+    uint8_t count;
+    screen_data screens[UINT8_MAX];
+} screen_layout;
+static seqlock layout_lock = SEQLOCK_INITIALIZER;
+static screen_layout layout;
 
-            while(settings_disp != NULL) {
-                XNextEvent(settings_disp, &ev);
+#ifdef USE_XRANDR
+// True if the server supports RandR 1.5, which reports every active monitor with a single request.
+static bool xrandr_monitors = false;
+#endif
 
-                if (ev.type == event_base + RRScreenChangeNotifyMask) {
-                    logger(LOG_LEVEL_DEBUG, "%s [%u]: Received XRRScreenChangeNotifyEvent.\n",
-                            __FUNCTION__, __LINE__);
+// Query the keyboard auto repeat rate and delay.
+static void query_auto_repeat(Display *display, system_properties *values) {
+    bool successful = false;
+    unsigned int delay = 0, rate = 0;
 
-                    pthread_mutex_lock(&xrandr_mutex);
-                    if (xrandr_resources != NULL) {
-                        XRRFreeScreenResources(xrandr_resources);
-                    }
+    // Attempt to acquire the keyboard auto repeat rate using the XKB extension.
+    if (!successful) {
+        successful = XkbGetAutoRepeatRate(display, XkbUseCoreKbd, &delay, &rate);
 
-                    xrandr_resources = XRRGetScreenResources(settings_disp, root);
-                    if (xrandr_resources == NULL) {
-                        logger(LOG_LEVEL_WARN, "%s [%u]: XRandR could not get screen resources!\n",
-                                __FUNCTION__, __LINE__);
-                    }
-                    pthread_mutex_unlock(&xrandr_mutex);
-                } else {
-                    logger(LOG_LEVEL_WARN, "%s [%u]: XRandR is not currently available!\n",
-                            __FUNCTION__, __LINE__);
-                }
-            }
+        if (successful) {
+            logger(LOG_LEVEL_DEBUG, "%s [%u]: XkbGetAutoRepeatRate: %u, %u.\n",
+                    __FUNCTION__, __LINE__, rate, delay);
         }
+    }
 
-        // Execute the thread cleanup handler.
-        pthread_cleanup_pop(1);
+    #ifdef USE_XF86MISC
+    // Fallback to the XF86 Misc extension if available and other efforts failed.
+    if (!successful) {
+        XF86MiscKbdSettings kb_info;
+        successful = (bool) XF86MiscGetKbdSettings(display, &kb_info);
+        if (successful) {
+            logger(LOG_LEVEL_DEBUG, "%s [%u]: XF86MiscGetKbdSettings: %i, %i.\n",
+                    __FUNCTION__, __LINE__, kb_info.rate, kb_info.delay);
+
+            delay = (unsigned int) kb_info.delay;
+            rate = (unsigned int) kb_info.rate;
+        }
+    }
+    #endif
 
+    if (successful) {
+        values->auto_repeat_rate = (long int) rate;
+        values->auto_repeat_delay = (long int) delay;
     } else {
-        logger(LOG_LEVEL_ERROR, "%s [%u]: XOpenDisplay failure!\n",
-                __FUNCTION__, __LINE__);
+        values->auto_repeat_rate = -1;
+        values->auto_repeat_delay = -1;
     }
-
-    return NULL;
 }
-#endif
 
-UIOHOOK_API screen_data* hook_create_screen_info(unsigned char *count) {
-    *count = 0;
-    screen_data *screens = NULL;
-
-    // Check and make sure we could connect to the x server.
-    if (helper_disp != NULL) {
-        #if defined(USE_XINERAMA) && !defined(USE_XRANDR)
-        if (XineramaIsActive(helper_disp)) {
-            int xine_count = 0;
-            XineramaScreenInfo *xine_info = XineramaQueryScreens(helper_disp, &xine_count);
+// Query the pointer acceleration and threshold with a single request.
+static void query_pointer_control(Display *display, system_properties *values) {
+    int accel_numerator = -1, accel_denominator = -1, threshold = -1;
 
-            if (xine_info != NULL) {
-                if (xine_count > UINT8_MAX) {
-                    *count = UINT8_MAX;
+    XGetPointerControl(display, &accel_numerator, &accel_denominator, &threshold);
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: XGetPointerControl: %i, %i, %i.\n",
+            __FUNCTION__, __LINE__, accel_numerator, accel_denominator, threshold);
 
-                    logger(LOG_LEVEL_WARN, "%s [%u]: Screen count overflow detected!\n",
-                            __FUNCTION__, __LINE__);
-                } else {
-                    *count = (uint8_t) xine_count;
-                }
-
-                screens = malloc(sizeof(screen_data) * xine_count);
+    values->pointer_acceleration_multiplier = accel_denominator >= 0 ? (long int) accel_denominator : -1;
+    values->pointer_acceleration_threshold = threshold >= 0 ? (long int) threshold : -1;
+    values->pointer_sensitivity = accel_numerator >= 0 ? (long int) accel_numerator : -1;
+}
 
-                if (screens != NULL) {
-                    for (int i = 0; i < xine_count; i++) {
-                        screens[i] = (screen_data) {
-                            .number = xine_info[i].screen_number,
-                            .x = xine_info[i].x_org,
-                            .y = xine_info[i].y_org,
-                            .width = xine_info[i].width,
-                            .height = xine_info[i].height
-                        };
-                    }
-                }
+#ifdef USE_XT
+static void load_xt() {
+    XtToolkitInitialize();
+    xt_context = XtCreateApplicationContext();
 
-                XFree(xine_info);
-            }
-        }
-        #elif defined(USE_XRANDR)
-        pthread_mutex_lock(&xrandr_mutex);
-        if (xrandr_resources != NULL) {
-            int xrandr_count = xrandr_resources->ncrtc;
-            if (xrandr_count > UINT8_MAX) {
-                *count = UINT8_MAX;
-
-                logger(LOG_LEVEL_WARN, "%s [%u]: Screen count overflow detected!\n",
-                        __FUNCTION__, __LINE__);
-            } else {
-                *count = (uint8_t) xrandr_count;
-            }
+    int argc = 0;
+    char ** argv = { NULL };
+    xt_disp = XtOpenDisplay(xt_context, NULL, "UIOHook", "libuiohook", NULL, 0, &argc, argv);
+}
+#endif
 
-            screens = malloc(sizeof(screen_data) * xrandr_count);
+// Query the multi-click time from the X Toolkit or the X defaults of the helper display.
+static long int query_multi_click_time() {
+    long int value = 200;
+    int click_time;
+    bool successful = false;
 
-            if (screens != NULL) {
-                for (int i = 0; i < xrandr_count; i++) {
-                    XRRCrtcInfo *crtc_info = XRRGetCrtcInfo(helper_disp, xrandr_resources, xrandr_resources->crtcs[i]);
+    #ifdef USE_XT
+    pthread_once(&xt_once, load_xt);
 
-                    if (crtc_info != NULL) {
-                        screens[i] = (screen_data) {
-                            .number = i + 1,
-                            .x = crtc_info->x,
-                            .y = crtc_info->y,
-                            .width = crtc_info->width,
-                            .height = crtc_info->height
-                        };
+    // Check and make sure we could connect to the x server.
+    if (xt_disp != NULL) {
+        // Try and use the Xt extention to get the current multi-click.
+        if (!successful) {
+            // Fall back to the X Toolkit extension if available and other efforts failed.
+            click_time = XtGetMultiClickTime(xt_disp);
+            if (click_time >= 0) {
+                logger(LOG_LEVEL_DEBUG, "%s [%u]: XtGetMultiClickTime: %i.\n",
+                        __FUNCTION__, __LINE__, click_time);
 
-                        XRRFreeCrtcInfo(crtc_info);
-                    } else {
-                        logger(LOG_LEVEL_WARN, "%s [%u]: XRandr failed to return crtc information! (%#X)\n",
-                                __FUNCTION__, __LINE__, xrandr_resources->crtcs[i]);
-                    }
-                }
-            }
-        }
-        pthread_mutex_unlock(&xrandr_mutex);
-        #else
-        Screen* default_screen = DefaultScreenOfDisplay(helper_disp);
-
-        if (default_screen->width > 0 && default_screen->height > 0) {
-            screens = malloc(sizeof(screen_data));
-
-            if (screens != NULL) {
-                *count = 1;
-                screens[0] = (screen_data) {
-                    .number = 1,
-                    .x = 0,
-                    .y = 0,
-                    .width = default_screen->width,
-                    .height = default_screen->height
-                };
+                successful = true;
             }
         }
-        #endif
     } else {
-        logger(LOG_LEVEL_WARN, "%s [%u]: XDisplay helper_disp is unavailable!\n",
-            __FUNCTION__, __LINE__);
+        logger(LOG_LEVEL_ERROR, "%s [%u]: %s\n",
+                __FUNCTION__, __LINE__, "XOpenDisplay failure!");
     }
-
-    return screens;
-}
-
-UIOHOOK_API long int hook_get_auto_repeat_rate() {
-    bool successful = false;
-    long int value = -1;
-    unsigned int delay = 0, rate = 0;
+    #endif
 
     // Check and make sure we could connect to the x server.
     if (helper_disp != NULL) {
-        // Attempt to acquire the keyboard auto repeat rate using the XKB extension.
+        // Try and acquire the multi-click time from the user defined X defaults.
         if (!successful) {
-            successful = XkbGetAutoRepeatRate(helper_disp, XkbUseCoreKbd, &delay, &rate);
+            char *xprop = XGetDefault(helper_disp, "*", "multiClickTime");
+            if (xprop != NULL && sscanf(xprop, "%4i", &click_time) != EOF) {
+                logger(LOG_LEVEL_DEBUG, "%s [%u]: X default 'multiClickTime' property: %i.\n",
+                        __FUNCTION__, __LINE__, click_time);
 
-            if (successful) {
-                logger(LOG_LEVEL_DEBUG, "%s [%u]: XkbGetAutoRepeatRate: %u.\n",
-                        __FUNCTION__, __LINE__, rate);
+                successful = true;
             }
         }
 
-        #ifdef USE_XF86MISC
-        // Fallback to the XF86 Misc extension if available and other efforts failed.
         if (!successful) {
-            XF86MiscKbdSettings kb_info;
-            successful = (bool) XF86MiscGetKbdSettings(helper_disp, &kb_info);
-            if (successful) {
-                logger(LOG_LEVEL_DEBUG, "%s [%u]: XF86MiscGetKbdSettings: %i.\n",
-                        __FUNCTION__, __LINE__, kbdinfo.rate);
-
-                delay = (unsigned int) kbdinfo.delay;
-                rate = (unsigned int) kbdinfo.rate;
+            char *xprop = XGetDefault(helper_disp, "OpenWindows", "MultiClickTimeout");
+            if (xprop != NULL && sscanf(xprop, "%4i", &click_time) != EOF) {
+                logger(LOG_LEVEL_DEBUG, "%s [%u]: X default 'MultiClickTimeout' property: %i.\n",
+                        __FUNCTION__, __LINE__, click_time);
+
+                successful = true;
             }
         }
-        #endif
     } else {
         logger(LOG_LEVEL_WARN, "%s [%u]: XDisplay helper_disp is unavailable!\n",
             __FUNCTION__, __LINE__);
     }
 
     if (successful) {
-        value = (long int) rate;
+        value = (long int) click_time;
     }
 
     return value;
 }
 
-UIOHOOK_API long int hook_get_auto_repeat_delay() {
+/* Read the multi-click time from the current RESOURCE_MANAGER property.  The X
+ * defaults and the X Toolkit only load the resource database when the display
+ * is opened, so this is used when the property changes.
+ */
+static bool query_resource_multi_click_time(Display *display, long int *value) {
     bool successful = false;
-    long int value = -1;
-    unsigned int delay = 0, rate = 0;
 
-    // Check and make sure we could connect to the x server.
-    if (helper_disp != NULL) {
-        // Attempt to acquire the keyboard auto repeat rate using the XKB extension.
-        if (!successful) {
-            successful = XkbGetAutoRepeatRate(helper_disp, XkbUseCoreKbd, &delay, &rate);
-
-            if (successful) {
-                logger(LOG_LEVEL_DEBUG, "%s [%u]: XkbGetAutoRepeatRate: %u.\n",
-                        __FUNCTION__, __LINE__, delay);
+    Atom type;
+    int format;
+    unsigned long count, remaining;
+    unsigned char *data = NULL;
+    if (XGetWindowProperty(display, XDefaultRootWindow(display), XA_RESOURCE_MANAGER, 0, LONG_MAX, False,
+            XA_STRING, &type, &format, &count, &remaining, &data) == Success && data != NULL) {
+        XrmDatabase database = XrmGetStringDatabase((const char *) data);
+        if (database != NULL) {
+            char *resource_type;
+            XrmValue resource;
+            if (XrmGetResource(database, "uiohook.multiClickTime", "UIOHook.MultiClickTime", &resource_type, &resource)
+                    || XrmGetResource(database, "OpenWindows.MultiClickTimeout", "OpenWindows.MultiClickTimeout", &resource_type, &resource)) {
+                int click_time;
+                if (resource.addr != NULL && sscanf(resource.addr, "%4i", &click_time) == 1) {
+                    logger(LOG_LEVEL_DEBUG, "%s [%u]: X resource multi-click time: %i.\n",
+                            __FUNCTION__, __LINE__, click_time);
+
+                    *value = (long int) click_time;
+                    successful = true;
+                }
             }
-        }
 
-        #ifdef USE_XF86MISC
-        // Fallback to the XF86 Misc extension if available and other efforts failed.
-        if (!successful) {
-            XF86MiscKbdSettings kb_info;
-            successful = (bool) XF86MiscGetKbdSettings(helper_disp, &kb_info);
-            if (successful) {
-                logger(LOG_LEVEL_DEBUG, "%s [%u]: XF86MiscGetKbdSettings: %i.\n",
-                        __FUNCTION__, __LINE__, kbdinfo.delay);
-
-                delay = (unsigned int) kbdinfo.delay;
-                rate = (unsigned int) kbdinfo.rate;
-            }
+            XrmDestroyDatabase(database);
         }
-        #endif
-    } else {
-        logger(LOG_LEVEL_WARN, "%s [%u]: XDisplay helper_disp is unavailable!\n",
-            __FUNCTION__, __LINE__);
-    }
 
-    if (successful) {
-        value = (long int) delay;
+        XFree(data);
     }
 
-    return value;
+    return successful;
 }
 
-UIOHOOK_API long int hook_get_pointer_acceleration_multiplier() {
-    long int value = -1;
-    int accel_numerator, accel_denominator, threshold;
+// Publish a modified copy of the property snapshot.
+static void update_properties(void (*update)(Display *, system_properties *), Display *display) {
+    pthread_mutex_lock(&properties_mutex);
+    system_properties values = properties;
+    update(display, &values);
+    seqlock_write(&properties_lock, &properties, &values, sizeof(system_properties));
+    pthread_mutex_unlock(&properties_mutex);
+}
 
-    // Check and make sure we could connect to the x server.
-    if (helper_disp != NULL) {
-        XGetPointerControl(helper_disp, &accel_numerator, &accel_denominator, &threshold);
-        if (accel_denominator >= 0) {
-            logger(LOG_LEVEL_DEBUG, "%s [%u]: XGetPointerControl: %i.\n",
-                    __FUNCTION__, __LINE__, accel_denominator);
+static void update_multi_click_time(Display *display, system_properties *values) {
+    query_resource_multi_click_time(display, &values->multi_click_time);
+}
+
+// Query the active monitors into buffer and return how many were found.
+static uint8_t query_screen_layout(Display *display, screen_data *buffer) {
+    int found = 0;
+    uint8_t count = 0;
+
+    #if defined(USE_XINERAMA) && !defined(USE_XRANDR)
+    if (XineramaIsActive(display)) {
+        XineramaScreenInfo *xine_info = XineramaQueryScreens(display, &found);
+
+        if (xine_info != NULL) {
+            for (int i = 0; i < found && count < UINT8_MAX; i++) {
+                buffer[count++] = (screen_data) {
+                    .number = xine_info[i].screen_number,
+                    .x = xine_info[i].x_org,
+                    .y = xine_info[i].y_org,
+                    .width = xine_info[i].width,
+                    .height = xine_info[i].height
+                };
+            }
 
-            value = (long int) accel_denominator;
+            XFree(xine_info);
         }
-    } else {
-        logger(LOG_LEVEL_WARN, "%s [%u]: XDisplay helper_disp is unavailable!\n",
-            __FUNCTION__, __LINE__);
     }
+    #elif defined(USE_XRANDR)
+    if (xrandr_monitors) {
+        XRRMonitorInfo *monitors = XRRGetMonitors(display, XDefaultRootWindow(display), True, &found);
+
+        if (monitors != NULL) {
+            for (int i = 0; i < found && count < UINT8_MAX; i++) {
+                buffer[count] = (screen_data) {
+                    .number = count + 1,
+                    .x = monitors[i].x,
+                    .y = monitors[i].y,
+                    .width = monitors[i].width,
+                    .height = monitors[i].height
+                };
+                count++;
+            }
 
-    return value;
-}
+            XRRFreeMonitors(monitors);
+        }
+    } else {
+        // Servers older than RandR 1.5 require a request per CRTC.
+        XRRScreenResources *resources = XRRGetScreenResourcesCurrent(display, XDefaultRootWindow(display));
+
+        if (resources != NULL) {
+            for (int i = 0; i < resources->ncrtc && count < UINT8_MAX; i++) {
+                XRRCrtcInfo *crtc_info = XRRGetCrtcInfo(display, resources, resources->crtcs[i]);
+
+                if (crtc_info != NULL) {
+                    // Disabled CRTCs have no mode and do not belong to a screen.
+                    if (crtc_info->mode != None && crtc_info->noutput > 0) {
+                        buffer[count] = (screen_data) {
+                            .number = count + 1,
+                            .x = crtc_info->x,
+                            .y = crtc_info->y,
+                            .width = crtc_info->width,
+                            .height = crtc_info->height
+                        };
+                        count++;
+                    }
 
-UIOHOOK_API long int hook_get_pointer_acceleration_threshold() {
-    long int value = -1;
-    int accel_numerator, accel_denominator, threshold;
+                    XRRFreeCrtcInfo(crtc_info);
+                } else {
+                    logger(LOG_LEVEL_WARN, "%s [%u]: XRandr failed to return crtc information! (%#X)\n",
+                            __FUNCTION__, __LINE__, resources->crtcs[i]);
+                }
+            }
 
-    // Check and make sure we could connect to the x server.
-    if (helper_disp != NULL) {
-        XGetPointerControl(helper_disp, &accel_numerator, &accel_denominator, &threshold);
-        if (threshold >= 0) {
-            logger(LOG_LEVEL_DEBUG, "%s [%u]: XGetPointerControl: %i.\n",
-                    __FUNCTION__, __LINE__, threshold);
+            XRRFreeScreenResources(resources);
+        } else {
+            logger(LOG_LEVEL_WARN, "%s [%u]: XRandR could not get screen resources!\n",
+                    __FUNCTION__, __LINE__);
+        }
+    }
+    #endif
+
+    if (found > UINT8_MAX) {
+        logger(LOG_LEVEL_WARN, "%s [%u]: Screen count overflow detected!\n",
+                __FUNCTION__, __LINE__);
+    }
 
-            value = (long int) threshold;
+    // Fallback to the root window when no extension reported a monitor.
+    if (count == 0) {
+        Window root;
+        int x, y;
+        unsigned int width, height, border, depth;
+        if (XGetGeometry(display, XDefaultRootWindow(display), &root, &x, &y, &width, &height, &border, &depth)
+                && width > 0 && height > 0) {
+            buffer[count++] = (screen_data) {
+                .number = 1,
+                .x = 0,
+                .y = 0,
+                .width = (uint16_t) width,
+                .height = (uint16_t) height
+            };
         }
-    } else {
-        logger(LOG_LEVEL_WARN, "%s [%u]: XDisplay helper_disp is unavailable!\n",
-            __FUNCTION__, __LINE__);
     }
 
-    return value;
+    return count;
 }
 
-UIOHOOK_API long int hook_get_pointer_sensitivity() {
-    long int value = -1;
-    int accel_numerator, accel_denominator, threshold;
+// Publish the current screen layout if it differs from the cached one.
+static void update_screen_layout(Display *display) {
+    screen_layout values;
+    values.count = query_screen_layout(display, values.screens);
 
-    // Check and make sure we could connect to the x server.
-    if (helper_disp != NULL) {
-        XGetPointerControl(helper_disp, &accel_numerator, &accel_denominator, &threshold);
-        if (accel_numerator >= 0) {
-            logger(LOG_LEVEL_DEBUG, "%s [%u]: XGetPointerControl: %i.\n",
-                    __FUNCTION__, __LINE__, accel_numerator);
+    pthread_mutex_lock(&properties_mutex);
+    if (values.count != layout.count
+            || memcmp(values.screens, layout.screens, sizeof(screen_data) * values.count) != 0) {
+        logger(LOG_LEVEL_DEBUG, "%s [%u]: Screen layout changed, %u screen(s).\n",
+                __FUNCTION__, __LINE__, values.count);
 
-            value = (long int) accel_numerator;
-        }
-    } else {
-        logger(LOG_LEVEL_WARN, "%s [%u]: XDisplay helper_disp is unavailable!\n",
-            __FUNCTION__, __LINE__);
+        seqlock_write(&layout_lock, &layout, &values, sizeof(screen_layout));
     }
+    pthread_mutex_unlock(&properties_mutex);
+}
 
-    return value;
+static void settings_cleanup_proc(void *arg) {
+    if (arg != NULL) {
+        XCloseDisplay((Display *) arg);
+        arg = NULL;
+    }
 }
 
-UIOHOOK_API long int hook_get_multi_click_time() {
-    long int value = 200;
-    int click_time;
-    bool successful = false;
+/* Listen for the notifications that change the property snapshot on a
+ * dedicated display.  The core protocol has no notification for the pointer
+ * control, see refresh_system_properties().
+ */
+static void *settings_thread_proc(void *arg) {
+    Display *settings_disp = XOpenDisplay(XDisplayName(NULL));
+    if (settings_disp != NULL) {
+        logger(LOG_LEVEL_DEBUG, "%s [%u]: %s\n",
+                __FUNCTION__, __LINE__, "XOpenDisplay success.");
 
-    #ifdef USE_XT
-    // Check and make sure we could connect to the x server.
-    if (xt_disp != NULL) {
-        // Try and use the Xt extention to get the current multi-click.
-        if (!successful) {
-            // Fall back to the X Toolkit extension if available and other efforts failed.
-            click_time = XtGetMultiClickTime(xt_disp);
-            if (click_time >= 0) {
-                logger(LOG_LEVEL_DEBUG, "%s [%u]: XtGetMultiClickTime: %i.\n",
-                        __FUNCTION__, __LINE__, click_time);
+        pthread_cleanup_push(settings_cleanup_proc, settings_disp);
 
-                successful = true;
-            }
+        Window root = XDefaultRootWindow(settings_disp);
+
+        /* Keyboard control changes carry the auto repeat rate and delay, keyboard
+         * and map changes invalidate the mapping used by keysym_to_keycode().
+         */
+        int xkb_opcode, xkb_event_base, xkb_error_base, xkb_major = XkbMajorVersion, xkb_minor = XkbMinorVersion;
+        bool has_xkb = XkbQueryExtension(settings_disp, &xkb_opcode, &xkb_event_base, &xkb_error_base, &xkb_major, &xkb_minor);
+        if (has_xkb) {
+            XkbSelectEventDetails(settings_disp, XkbUseCoreKbd, XkbControlsNotify, XkbRepeatKeysMask, XkbRepeatKeysMask);
+            XkbSelectEvents(settings_disp, XkbUseCoreKbd,
+                    XkbNewKeyboardNotifyMask | XkbMapNotifyMask,
+                    XkbNewKeyboardNotifyMask | XkbMapNotifyMask);
+        } else {
+            logger(LOG_LEVEL_WARN, "%s [%u]: XKB is not currently available!\n",
+                    __FUNCTION__, __LINE__);
         }
-    } else {
-        logger(LOG_LEVEL_ERROR, "%s [%u]: %s\n",
-                __FUNCTION__, __LINE__, "XOpenDisplay failure!");
-    }
-    #endif
 
-    // Check and make sure we could connect to the x server.
-    if (helper_disp != NULL) {
-        // Try and acquire the multi-click time from the user defined X defaults.
-        if (!successful) {
-            char *xprop = XGetDefault(helper_disp, "*", "multiClickTime");
-            if (xprop != NULL && sscanf(xprop, "%4i", &click_time) != EOF) {
-                logger(LOG_LEVEL_DEBUG, "%s [%u]: X default 'multiClickTime' property: %i.\n",
-                        __FUNCTION__, __LINE__, click_time);
+        /* Resource database changes carry the multi-click time and root window
+         * configuration changes carry the screen size.
+         */
+        XrmInitialize();
+        XSelectInput(settings_disp, root, PropertyChangeMask | StructureNotifyMask);
+
+        #ifdef USE_XRANDR
+        int xrandr_event_base = 0;
+        int xrandr_error_base = 0;
+        bool has_xrandr = XRRQueryExtension(settings_disp, &xrandr_event_base, &xrandr_error_base);
+        if (has_xrandr) {
+            XRRSelectInput(settings_disp, root, RRScreenChangeNotifyMask | RRCrtcChangeNotifyMask);
+        } else {
+            logger(LOG_LEVEL_WARN, "%s [%u]: XRandR is not currently available!\n",
+                    __FUNCTION__, __LINE__);
+        }
+        #endif
 
-                successful = true;
+        XEvent ev;
+        while (settings_disp != NULL) {
+            XNextEvent(settings_disp, &ev);
+
+            if (has_xkb && ev.type == xkb_event_base && ((XkbAnyEvent *) &ev)->xkb_type == XkbControlsNotify) {
+                logger(LOG_LEVEL_DEBUG, "%s [%u]: Received XkbControlsNotifyEvent.\n",
+                        __FUNCTION__, __LINE__);
+
+                update_properties(query_auto_repeat, settings_disp);
+            } else if (has_xkb && ev.type == xkb_event_base && ((XkbAnyEvent *) &ev)->xkb_type == XkbNewKeyboardNotify) {
+                logger(LOG_LEVEL_DEBUG, "%s [%u]: Received XkbNewKeyboardNotifyEvent.\n",
+                        __FUNCTION__, __LINE__);
+
+                XkbNewKeyboardNotifyEvent *xkb_event = (XkbNewKeyboardNotifyEvent *) &ev;
+                invalidate_keysym_map(xkb_event->min_key_code, xkb_event->max_key_code - xkb_event->min_key_code + 1);
+            } else if (has_xkb && ev.type == xkb_event_base && ((XkbAnyEvent *) &ev)->xkb_type == XkbMapNotify) {
+                logger(LOG_LEVEL_DEBUG, "%s [%u]: Received XkbMapNotifyEvent.\n",
+                        __FUNCTION__, __LINE__);
+
+                XkbMapNotifyEvent *xkb_event = (XkbMapNotifyEvent *) &ev;
+                if (xkb_event->changed & XkbKeyTypesMask) {
+                    // Key type changes shift the level of every key.
+                    invalidate_keysym_map(xkb_event->min_key_code, xkb_event->max_key_code - xkb_event->min_key_code + 1);
+                } else if (xkb_event->changed & XkbKeySymsMask) {
+                    invalidate_keysym_map(xkb_event->first_key_sym, xkb_event->num_key_syms);
+                }
+            } else if (ev.type == MappingNotify && ev.xmapping.request == MappingKeyboard) {
+                logger(LOG_LEVEL_DEBUG, "%s [%u]: Received keyboard MappingNotify.\n",
+                        __FUNCTION__, __LINE__);
+
+                XRefreshKeyboardMapping(&ev.xmapping);
+                invalidate_keysym_map(ev.xmapping.first_keycode, ev.xmapping.count);
+            } else if (ev.type == PropertyNotify && ev.xproperty.atom == XA_RESOURCE_MANAGER) {
+                logger(LOG_LEVEL_DEBUG, "%s [%u]: Received RESOURCE_MANAGER PropertyNotify.\n",
+                        __FUNCTION__, __LINE__);
+
+                update_properties(update_multi_click_time, settings_disp);
+
+                // A replayed recording keeps counting clicks with the recorded time.
+                if (!file_source_running()) {
+                    dispatch_set_multi_click_time(hook_get_multi_click_time());
+                }
             }
-        }
+            #ifdef USE_XRANDR
+            else if (has_xrandr && (ev.type == xrandr_event_base + RRScreenChangeNotify || ev.type == xrandr_event_base + RRNotify)) {
+                logger(LOG_LEVEL_DEBUG, "%s [%u]: Received XRandR change notification.\n",
+                        __FUNCTION__, __LINE__);
 
-        if (!successful) {
-            char *xprop = XGetDefault(helper_disp, "OpenWindows", "MultiClickTimeout");
-            if (xprop != NULL && sscanf(xprop, "%4i", &click_time) != EOF) {
-                logger(LOG_LEVEL_DEBUG, "%s [%u]: X default 'MultiClickTimeout' property: %i.\n",
-                        __FUNCTION__, __LINE__, click_time);
+                XRRUpdateConfiguration(&ev);
+                update_screen_layout(settings_disp);
+            }
+            #else
+            else if (ev.type == ConfigureNotify && ev.xconfigure.window == root) {
+                logger(LOG_LEVEL_DEBUG, "%s [%u]: Received root window ConfigureNotify.\n",
+                        __FUNCTION__, __LINE__);
 
-                successful = true;
+                update_screen_layout(settings_disp);
             }
+            #endif
         }
-    } else {
-        logger(LOG_LEVEL_WARN, "%s [%u]: XDisplay helper_disp is unavailable!\n",
-            __FUNCTION__, __LINE__);
-    }
 
-    if (successful) {
-        value = (long int) click_time;
+        // Execute the thread cleanup handler.
+        pthread_cleanup_pop(1);
+
+    } else {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: XOpenDisplay failure!\n",
+                __FUNCTION__, __LINE__);
     }
 
-    return value;
+    return NULL;
 }
 
-// Create a shared object constructor.
+/* Create a shared object constructor.  XInitThreads() must run before any
+ * other Xlib call in the process, everything else waits for load_library().
+ */
 __attribute__ ((constructor))
 void on_library_load() {
     // Make sure we are initialized for threading.
     XInitThreads();
+}
 
+static void open_library() {
     // Open local display.
     helper_disp = XOpenDisplay(XDisplayName(NULL));
     if (helper_disp == NULL) {
@@ -444,10 +534,49 @@ void on_library_load() {
                 __FUNCTION__, __LINE__, "XOpenDisplay success.");
     }
 
-    #ifdef USE_XRANDR
+    #ifndef USE_XTEST
+    // Without XTest, events are sent directly to the windows tracked by the cache.
+    load_window_cache();
+    #endif
+}
+
+void load_library() {
+    pthread_once(&library_once, open_library);
+}
+
+// Fill the property snapshot and start the settings thread that keeps it current.
+static void load_settings() {
+    load_library();
+
+    system_properties values = properties;
+    if (helper_disp != NULL) {
+        query_auto_repeat(helper_disp, &values);
+        query_pointer_control(helper_disp, &values);
+    } else {
+        logger(LOG_LEVEL_WARN, "%s [%u]: XDisplay helper_disp is unavailable!\n",
+            __FUNCTION__, __LINE__);
+    }
+    values.multi_click_time = query_multi_click_time();
+
+    pthread_mutex_lock(&properties_mutex);
+    seqlock_write(&properties_lock, &properties, &values, sizeof(system_properties));
+    pthread_mutex_unlock(&properties_mutex);
+
+    if (helper_disp != NULL) {
+        #ifdef USE_XRANDR
+        int major = 0, minor = 0;
+        if (XRRQueryVersion(helper_disp, &major, &minor)) {
+            xrandr_monitors = major > 1 || (major == 1 && minor >= 5);
+        }
+        #endif
+
+        update_screen_layout(helper_disp);
+    }
+
     // Create the thread attribute.
     pthread_attr_t settings_thread_attr;
     pthread_attr_init(&settings_thread_attr);
+    pthread_attr_setdetachstate(&settings_thread_attr, PTHREAD_CREATE_DETACHED);
 
     pthread_t settings_thread_id;
     if (pthread_create(&settings_thread_id, &settings_thread_attr, settings_thread_proc, NULL) == 0) {
@@ -460,16 +589,120 @@ void on_library_load() {
 
     // Make sure the thread attribute is removed.
     pthread_attr_destroy(&settings_thread_attr);
-    #endif
+}
 
-    #ifdef USE_XT
-    XtToolkitInitialize();
-    xt_context = XtCreateApplicationContext();
+void refresh_system_properties() {
+    pthread_once(&settings_once, load_settings);
 
-    int argc = 0;
-    char ** argv = { NULL };
-    xt_disp = XtOpenDisplay(xt_context, NULL, "UIOHook", "libuiohook", NULL, 0, &argc, argv);
-    #endif
+    if (helper_disp != NULL) {
+        update_properties(query_pointer_control, helper_disp);
+    }
+}
+
+// The pointer control has no change notification, so its getters query the server on every call.
+static void get_pointer_control(system_properties *values) {
+    refresh_system_properties();
+    hook_get_system_properties(values);
+}
+
+uint32_t get_screen_generation() {
+    return seqlock_read_begin(&layout_lock);
+}
+
+UIOHOOK_API int hook_get_screen_info(screen_data *screens, unsigned char *count) {
+    if (count == NULL || (screens == NULL && *count > 0)) {
+        return UIOHOOK_FAILURE;
+    }
+
+    // The settings thread tracks the layout once screen info has been requested.
+    pthread_once(&settings_once, load_settings);
+
+    uint8_t size = *count, total;
+    uint32_t sequence;
+    do {
+        sequence = seqlock_read_begin(&layout_lock);
+        total = __atomic_load_n(&layout.count, __ATOMIC_RELAXED);
+        seqlock_copy_from(screens, layout.screens, sizeof(screen_data) * (total < size ? total : size));
+    } while (seqlock_read_retry(&layout_lock, sequence));
+
+    *count = total;
+
+    return UIOHOOK_SUCCESS;
+}
+
+UIOHOOK_API screen_data* hook_create_screen_info(unsigned char *count) {
+    screen_data buffer[UINT8_MAX];
+    screen_data *screens = NULL;
+
+    *count = UINT8_MAX;
+    if (hook_get_screen_info(buffer, count) == UIOHOOK_SUCCESS && *count > 0) {
+        screens = malloc(sizeof(screen_data) * *count);
+        if (screens != NULL) {
+            memcpy(screens, buffer, sizeof(screen_data) * *count);
+        } else {
+            logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to allocate memory for screen info!\n",
+                    __FUNCTION__, __LINE__);
+        }
+    }
+
+    if (screens == NULL) {
+        *count = 0;
+    }
+
+    return screens;
+}
+
+UIOHOOK_API int hook_get_system_properties(system_properties *values) {
+    if (values == NULL) {
+        return UIOHOOK_FAILURE;
+    }
+
+    pthread_once(&settings_once, load_settings);
+    seqlock_read(&properties_lock, values, &properties, sizeof(system_properties));
+
+    return UIOHOOK_SUCCESS;
+}
+
+UIOHOOK_API long int hook_get_auto_repeat_rate() {
+    system_properties values;
+    hook_get_system_properties(&values);
+
+    return values.auto_repeat_rate;
+}
+
+UIOHOOK_API long int hook_get_auto_repeat_delay() {
+    system_properties values;
+    hook_get_system_properties(&values);
+
+    return values.auto_repeat_delay;
+}
+
+UIOHOOK_API long int hook_get_pointer_acceleration_multiplier() {
+    system_properties values;
+    get_pointer_control(&values);
+
+    return values.pointer_acceleration_multiplier;
+}
+
+UIOHOOK_API long int hook_get_pointer_acceleration_threshold() {
+    system_properties values;
+    get_pointer_control(&values);
+
+    return values.pointer_acceleration_threshold;
+}
+
+UIOHOOK_API long int hook_get_pointer_sensitivity() {
+    system_properties values;
+    get_pointer_control(&values);
+
+    return values.pointer_sensitivity;
+}
+
+UIOHOOK_API long int hook_get_multi_click_time() {
+    system_properties values;
+    hook_get_system_properties(&values);
+
+    return values.multi_click_time;
 }
 
 // Create a shared object destructor.
@@ -481,9 +714,24 @@ void on_library_unload() {
     // Cleanup.
     unload_input_helper();
 
+    #ifndef USE_XTEST
+    unload_window_cache();
+    #endif
+
+    #ifdef USE_UINPUT
+    unload_uinput_devices();
+    #endif
+
     #ifdef USE_XT
-    XtCloseDisplay(xt_disp);
-    XtDestroyApplicationContext(xt_context);
+    if (xt_disp != NULL) {
+        XtCloseDisplay(xt_disp);
+        xt_disp = NULL;
+    }
+
+    if (xt_context != NULL) {
+        XtDestroyApplicationContext(xt_context);
+        xt_context = NULL;
+    }
     #endif
 
     // Destroy the native displays.
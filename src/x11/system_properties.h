@@ -0,0 +1,43 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _included_system_properties
+#define _included_system_properties
+
+#include <stdint.h>
+
+/* Open helper_disp and the event posting subsystems the first time it is
+ * called.  This method is safe to call from any thread and must be called by
+ * every public function that uses helper_disp.  The library constructor only
+ * calls XInitThreads(), nothing is opened when the library is loaded.
+ */
+extern void load_library();
+
+/* Re-query the properties the X server sends no notification for, currently
+ * the pointer control.  The rest of the snapshot returned by
+ * hook_get_system_properties() is kept current by the settings thread.  This
+ * method is called by hook_run() and the hook_get_pointer_*() getters.
+ */
+extern void refresh_system_properties();
+
+/* Returns a value that changes each time the settings thread publishes a new
+ * screen layout, used by the hook to dispatch EVENT_SCREEN_CHANGED.
+ */
+extern uint32_t get_screen_generation();
+
+#endif
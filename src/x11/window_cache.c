@@ -0,0 +1,551 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uiohook.h>
+#include <unistd.h>
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+
+#include "logger.h"
+#include "window_cache.h"
+
+// Events selected on every window in the tree.
+#define WINDOW_CACHE_EVENT_MASK (SubstructureNotifyMask | FocusChangeMask)
+
+typedef struct _window_entry {
+    Window window;
+    Window parent;
+    int x;              // Outer corner relative to the parent's origin.
+    int y;
+    int width;          // Inner size, excluding the border.
+    int height;
+    int border_width;
+    bool mapped;
+} window_entry;
+
+// Guards the cached tree and focus state shared with the post event functions.
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Siblings appear in stacking order, bottom to top.
+static window_entry *entries = NULL;
+static size_t entry_count = 0, entry_capacity = 0;
+
+static Window root_window = None;
+static Window focus_window = None;
+static Window active_window = None;
+
+static Display *cache_disp = NULL;
+static Atom net_active_window = None;
+static pthread_t cache_thread_id;
+static bool cache_thread_running = false;
+static int stop_pipe[2] = { -1, -1 };
+
+// Serializes error traps, Xlib only has a single error handler per process.
+static pthread_mutex_t trap_mutex = PTHREAD_MUTEX_INITIALIZER;
+static Display *trap_disp = NULL;
+static int (*previous_error_handler)(Display *, XErrorEvent *) = NULL;
+
+
+// Windows may disappear before their DestroyNotify is processed.
+static int trap_error_handler(Display *disp, XErrorEvent *error) {
+    if (disp == trap_disp && error->error_code == BadWindow) {
+        logger(LOG_LEVEL_DEBUG, "%s [%u]: Ignoring BadWindow error for window: %#lX.\n",
+                __FUNCTION__, __LINE__, error->resourceid);
+        return 0;
+    }
+
+    if (previous_error_handler != NULL) {
+        return previous_error_handler(disp, error);
+    }
+
+    return 0;
+}
+
+void window_cache_trap_errors(Display *disp) {
+    pthread_mutex_lock(&trap_mutex);
+
+    // Errors from earlier requests still go to the application's handler.
+    XSync(disp, False);
+    trap_disp = disp;
+    previous_error_handler = XSetErrorHandler(trap_error_handler);
+}
+
+void window_cache_untrap_errors() {
+    // Collect the errors of the trapped requests before restoring the handler.
+    XSync(trap_disp, False);
+    XSetErrorHandler(previous_error_handler);
+    previous_error_handler = NULL;
+    trap_disp = NULL;
+
+    pthread_mutex_unlock(&trap_mutex);
+}
+
+static long find_entry(Window window) {
+    for (size_t i = 0; i < entry_count; i++) {
+        if (entries[i].window == window) {
+            return (long) i;
+        }
+    }
+
+    return -1;
+}
+
+static void remove_entry_at(size_t index) {
+    memmove(&entries[index], &entries[index + 1], sizeof(window_entry) * (entry_count - index - 1));
+    entry_count--;
+}
+
+static void insert_entry_at(size_t index, const window_entry *entry) {
+    if (entry_count >= entry_capacity) {
+        size_t capacity = entry_capacity > 0 ? entry_capacity * 2 : 64;
+        window_entry *buffer = (window_entry *) realloc(entries, sizeof(window_entry) * capacity);
+        if (buffer == NULL) {
+            logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to allocate memory for window cache!\n",
+                    __FUNCTION__, __LINE__);
+            return;
+        }
+
+        entries = buffer;
+        entry_capacity = capacity;
+    }
+
+    memmove(&entries[index + 1], &entries[index], sizeof(window_entry) * (entry_count - index));
+    entries[index] = *entry;
+    entry_count++;
+}
+
+// Place an entry directly above its sibling, or below all siblings if sibling is None.
+static void restack_entry(Window window, Window sibling) {
+    long index = find_entry(window);
+    if (index < 0) {
+        return;
+    }
+
+    window_entry entry = entries[index];
+    remove_entry_at((size_t) index);
+
+    size_t position = entry_count;
+    if (sibling != None) {
+        long above = find_entry(sibling);
+        if (above >= 0) {
+            position = (size_t) above + 1;
+        }
+    } else {
+        for (size_t i = 0; i < entry_count; i++) {
+            if (entries[i].parent == entry.parent) {
+                position = i;
+                break;
+            }
+        }
+    }
+
+    insert_entry_at(position, &entry);
+}
+
+// Add a new window on top of its siblings, or update the existing entry.
+static void update_entry(const window_entry *entry) {
+    long index = find_entry(entry->window);
+    if (index >= 0) {
+        remove_entry_at((size_t) index);
+    }
+
+    insert_entry_at(entry_count, entry);
+}
+
+static void remove_entry(Window window) {
+    // Children are normally destroyed first, but make sure nothing is orphaned.
+    size_t i = 0;
+    while (i < entry_count) {
+        if (entries[i].parent == window) {
+            remove_entry(entries[i].window);
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+
+    long index = find_entry(window);
+    if (index >= 0) {
+        remove_entry_at((size_t) index);
+    }
+
+    if (focus_window == window) {
+        focus_window = None;
+    }
+
+    if (active_window == window) {
+        active_window = None;
+    }
+}
+
+static void scan_window_tree(Window window) {
+    XSelectInput(cache_disp, window, window == root_window ? WINDOW_CACHE_EVENT_MASK | PropertyChangeMask : WINDOW_CACHE_EVENT_MASK);
+
+    Window root, parent, *children = NULL;
+    unsigned int count = 0;
+    if (XQueryTree(cache_disp, window, &root, &parent, &children, &count) != 0) {
+        // Children are returned in stacking order, bottom to top.
+        for (unsigned int i = 0; i < count; i++) {
+            XWindowAttributes attributes;
+            if (XGetWindowAttributes(cache_disp, children[i], &attributes) != 0) {
+                window_entry entry = {
+                    .window = children[i],
+                    .parent = window,
+                    .x = attributes.x,
+                    .y = attributes.y,
+                    .width = attributes.width,
+                    .height = attributes.height,
+                    .border_width = attributes.border_width,
+                    .mapped = attributes.map_state != IsUnmapped
+                };
+
+                pthread_mutex_lock(&cache_mutex);
+                update_entry(&entry);
+                pthread_mutex_unlock(&cache_mutex);
+
+                scan_window_tree(children[i]);
+            }
+        }
+
+        if (children != NULL) {
+            XFree(children);
+        }
+    }
+}
+
+static void refresh_active_window() {
+    Atom type;
+    int format;
+    unsigned long count, remaining;
+    unsigned char *data = NULL;
+
+    Window window = None;
+    if (XGetWindowProperty(cache_disp, root_window, net_active_window, 0, 1, False, XA_WINDOW,
+            &type, &format, &count, &remaining, &data) == Success) {
+        if (type == XA_WINDOW && format == 32 && count == 1) {
+            window = (Window) *((unsigned long *) data);
+        }
+
+        if (data != NULL) {
+            XFree(data);
+        }
+    }
+
+    pthread_mutex_lock(&cache_mutex);
+    active_window = window;
+    pthread_mutex_unlock(&cache_mutex);
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Active window changed: %#lX.\n",
+            __FUNCTION__, __LINE__, window);
+}
+
+static void process_event(XEvent *event) {
+    switch (event->type) {
+        case CreateNotify:
+            {
+                XCreateWindowEvent *create = &event->xcreatewindow;
+                window_entry entry = {
+                    .window = create->window,
+                    .parent = create->parent,
+                    .x = create->x,
+                    .y = create->y,
+                    .width = create->width,
+                    .height = create->height,
+                    .border_width = create->border_width,
+                    .mapped = false
+                };
+
+                pthread_mutex_lock(&cache_mutex);
+                update_entry(&entry);
+                pthread_mutex_unlock(&cache_mutex);
+
+                // Pick up any children created before the selection took effect.
+                window_cache_trap_errors(cache_disp);
+                scan_window_tree(create->window);
+                window_cache_untrap_errors();
+            }
+            break;
+
+        case DestroyNotify:
+            pthread_mutex_lock(&cache_mutex);
+            remove_entry(event->xdestroywindow.window);
+            pthread_mutex_unlock(&cache_mutex);
+            break;
+
+        case ConfigureNotify:
+            {
+                XConfigureEvent *configure = &event->xconfigure;
+
+                pthread_mutex_lock(&cache_mutex);
+                long index = find_entry(configure->window);
+                if (index >= 0) {
+                    entries[index].x = configure->x;
+                    entries[index].y = configure->y;
+                    entries[index].width = configure->width;
+                    entries[index].height = configure->height;
+                    entries[index].border_width = configure->border_width;
+
+                    restack_entry(configure->window, configure->above);
+                }
+                pthread_mutex_unlock(&cache_mutex);
+            }
+            break;
+
+        case MapNotify:
+        case UnmapNotify:
+            {
+                Window window = event->type == MapNotify ? event->xmap.window : event->xunmap.window;
+
+                pthread_mutex_lock(&cache_mutex);
+                long index = find_entry(window);
+                if (index >= 0) {
+                    entries[index].mapped = event->type == MapNotify;
+                }
+                pthread_mutex_unlock(&cache_mutex);
+            }
+            break;
+
+        case ReparentNotify:
+            {
+                XReparentEvent *reparent = &event->xreparent;
+
+                pthread_mutex_lock(&cache_mutex);
+                long index = find_entry(reparent->window);
+                if (index >= 0) {
+                    window_entry entry = entries[index];
+                    entry.parent = reparent->parent;
+                    entry.x = reparent->x;
+                    entry.y = reparent->y;
+
+                    update_entry(&entry);
+                }
+                pthread_mutex_unlock(&cache_mutex);
+            }
+            break;
+
+        case CirculateNotify:
+            pthread_mutex_lock(&cache_mutex);
+            if (event->xcirculate.place == PlaceOnTop) {
+                long index = find_entry(event->xcirculate.window);
+                if (index >= 0) {
+                    window_entry entry = entries[index];
+                    update_entry(&entry);
+                }
+            } else {
+                restack_entry(event->xcirculate.window, None);
+            }
+            pthread_mutex_unlock(&cache_mutex);
+            break;
+
+        case FocusIn:
+            pthread_mutex_lock(&cache_mutex);
+            switch (event->xfocus.detail) {
+                case NotifyAncestor:
+                case NotifyInferior:
+                case NotifyNonlinear:
+                    focus_window = event->xfocus.window;
+                    break;
+
+                case NotifyPointerRoot:
+                case NotifyDetailNone:
+                    focus_window = None;
+                    break;
+            }
+            pthread_mutex_unlock(&cache_mutex);
+            break;
+
+        case FocusOut:
+            pthread_mutex_lock(&cache_mutex);
+            if (event->xfocus.window == focus_window && event->xfocus.detail != NotifyPointer) {
+                focus_window = None;
+            }
+            pthread_mutex_unlock(&cache_mutex);
+            break;
+
+        case PropertyNotify:
+            if (event->xproperty.window == root_window && event->xproperty.atom == net_active_window) {
+                refresh_active_window();
+            }
+            break;
+    }
+}
+
+static void *cache_thread_proc(void *arg) {
+    net_active_window = XInternAtom(cache_disp, "_NET_ACTIVE_WINDOW", False);
+
+    window_cache_trap_errors(cache_disp);
+    scan_window_tree(root_window);
+    window_cache_untrap_errors();
+
+    refresh_active_window();
+
+    Window focus;
+    int revert;
+    XGetInputFocus(cache_disp, &focus, &revert);
+    if (focus != None && focus != PointerRoot) {
+        pthread_mutex_lock(&cache_mutex);
+        focus_window = focus;
+        pthread_mutex_unlock(&cache_mutex);
+    }
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Window cache loaded with %zu windows.\n",
+            __FUNCTION__, __LINE__, entry_count);
+
+    struct pollfd fds[2] = {
+        { .fd = ConnectionNumber(cache_disp), .events = POLLIN },
+        { .fd = stop_pipe[0], .events = POLLIN }
+    };
+
+    XEvent event;
+    while (true) {
+        while (XPending(cache_disp) > 0) {
+            XNextEvent(cache_disp, &event);
+            process_event(&event);
+        }
+
+        if (poll(fds, 2, -1) < 0 && errno != EINTR) {
+            logger(LOG_LEVEL_ERROR, "%s [%u]: poll() failed! (%d)\n",
+                    __FUNCTION__, __LINE__, errno);
+            break;
+        }
+
+        if (fds[1].revents != 0) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+Window window_cache_get_focus() {
+    pthread_mutex_lock(&cache_mutex);
+    Window window = focus_window;
+    if (window == None) {
+        window = active_window != None ? active_window : root_window;
+    }
+    pthread_mutex_unlock(&cache_mutex);
+
+    return window;
+}
+
+Window window_cache_get_window_at(int x_root, int y_root, int *x, int *y) {
+    pthread_mutex_lock(&cache_mutex);
+    Window window = root_window;
+
+    // Descend into the top most mapped child containing the point.
+    bool found = true;
+    while (found) {
+        found = false;
+        for (size_t i = entry_count; i-- > 0;) {
+            window_entry *entry = &entries[i];
+            if (entry->parent == window && entry->mapped
+                    && x_root >= entry->x && x_root < entry->x + entry->width + entry->border_width * 2
+                    && y_root >= entry->y && y_root < entry->y + entry->height + entry->border_width * 2) {
+                window = entry->window;
+                x_root -= entry->x + entry->border_width;
+                y_root -= entry->y + entry->border_width;
+                found = true;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&cache_mutex);
+
+    *x = x_root;
+    *y = y_root;
+
+    return window;
+}
+
+bool load_window_cache() {
+    if (cache_thread_running) {
+        return true;
+    }
+
+    cache_disp = XOpenDisplay(XDisplayName(NULL));
+    if (cache_disp == NULL) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: XOpenDisplay failure!\n",
+                __FUNCTION__, __LINE__);
+        return false;
+    }
+
+    if (pipe(stop_pipe) != 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to create window cache pipe! (%d)\n",
+                __FUNCTION__, __LINE__, errno);
+
+        XCloseDisplay(cache_disp);
+        cache_disp = NULL;
+        return false;
+    }
+
+    fcntl(stop_pipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(stop_pipe[1], F_SETFD, FD_CLOEXEC);
+
+    root_window = XDefaultRootWindow(cache_disp);
+
+    if (pthread_create(&cache_thread_id, NULL, cache_thread_proc, NULL) != 0) {
+        logger(LOG_LEVEL_ERROR, "%s [%u]: Failed to create window cache thread!\n",
+                __FUNCTION__, __LINE__);
+
+        unload_window_cache();
+        return false;
+    }
+
+    logger(LOG_LEVEL_DEBUG, "%s [%u]: Successfully created window cache thread.\n",
+            __FUNCTION__, __LINE__);
+
+    cache_thread_running = true;
+    return true;
+}
+
+void unload_window_cache() {
+    if (cache_thread_running) {
+        if (write(stop_pipe[1], "\0", 1) != 1) {
+            logger(LOG_LEVEL_WARN, "%s [%u]: Failed to signal window cache thread! (%d)\n",
+                    __FUNCTION__, __LINE__, errno);
+        }
+
+        pthread_join(cache_thread_id, NULL);
+        cache_thread_running = false;
+    }
+
+    if (stop_pipe[0] >= 0) {
+        close(stop_pipe[0]);
+        close(stop_pipe[1]);
+        stop_pipe[0] = stop_pipe[1] = -1;
+    }
+
+    if (cache_disp != NULL) {
+        XCloseDisplay(cache_disp);
+        cache_disp = NULL;
+    }
+
+    pthread_mutex_lock(&cache_mutex);
+    free(entries);
+    entries = NULL;
+    entry_count = entry_capacity = 0;
+    focus_window = active_window = None;
+    pthread_mutex_unlock(&cache_mutex);
+}
@@ -0,0 +1,60 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _included_window_cache
+#define _included_window_cache
+
+#include <stdbool.h>
+#include <X11/Xlib.h>
+
+/* Returns the window that currently holds the keyboard focus.  The value is
+ * maintained from FocusIn / FocusOut events and the _NET_ACTIVE_WINDOW root
+ * property, so no request is sent to the X server.
+ */
+extern Window window_cache_get_focus();
+
+/* Returns the deepest mapped window containing the root coordinates x_root
+ * and y_root and stores the coordinates relative to that window in x and y.
+ * The lookup is done against the cached window tree without querying the X
+ * server.
+ */
+extern Window window_cache_get_window_at(int x_root, int y_root, int *x, int *y);
+
+/* Ignore BadWindow errors caused by requests on disp until
+ * window_cache_untrap_errors(), because cached windows may be destroyed at any
+ * time.  Both calls synchronize with the X server and the process error
+ * handler is only replaced in between, so keep the trapped section short.
+ * Other errors and errors on other displays reach the previous handler.
+ */
+extern void window_cache_trap_errors(Display *disp);
+
+// Restore the error handler replaced by window_cache_trap_errors().
+extern void window_cache_untrap_errors();
+
+/* Start the thread that maintains the focus and window tree cache on its own
+ * display connection.  This method is called by load_library() when XTest
+ * is not available.
+ */
+extern bool load_window_cache();
+
+/* Stop the window cache thread and release the cached window tree.  This
+ * method is called by on_library_unload().
+ */
+extern void unload_window_cache();
+
+#endif
@@ -0,0 +1,80 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Counts every allocation made while counting is set, including the ones made
+ * inside Xlib and the extension libraries, by interposing the glibc
+ * allocation functions for the whole process.  Include from a single
+ * translation unit of the executable.
+ */
+
+#ifndef _included_alloc_counter
+#define _included_alloc_counter
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Allocations may come from the hook thread, the counter is only read once it is idle.
+static bool counting = false;
+static uint64_t allocations = 0;
+
+#ifdef __GLIBC__
+extern void * __libc_malloc(size_t size);
+extern void * __libc_calloc(size_t count, size_t size);
+extern void * __libc_realloc(void *ptr, size_t size);
+extern void * __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void *ptr);
+
+static inline void count_allocation() {
+    if (__atomic_load_n(&counting, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void * malloc(size_t size) {
+    count_allocation();
+    return __libc_malloc(size);
+}
+
+void * calloc(size_t count, size_t size) {
+    count_allocation();
+    return __libc_calloc(count, size);
+}
+
+void * realloc(void *ptr, size_t size) {
+    count_allocation();
+    return __libc_realloc(ptr, size);
+}
+
+void * memalign(size_t alignment, size_t size) {
+    count_allocation();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+    count_allocation();
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr != NULL ? 0 : 12;
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
+#endif
+
+#endif
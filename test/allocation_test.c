@@ -0,0 +1,227 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Fails if the hook allocates memory while dispatching events once it has
+ * warmed up.  The allocation functions are interposed for the whole process,
+ * so allocations made inside Xlib and the extension libraries are counted as
+ * well.  On X11 the hook is driven with synthetic XRecord data, which leaves
+ * out the intercept data Xtst allocates for every recorded event, and a
+ * running X server is required for the keyboard map.
+ *
+ * usage: uiohook_alloc_test [rounds]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uiohook.h>
+
+#include "alloc_counter.h"
+
+#ifdef USE_VIRTUAL
+#include <linux/input-event-codes.h>
+#include <pthread.h>
+#include <time.h>
+#else
+#include <X11/keysym.h>
+
+#include "input_helper.h"
+#include "system_properties.h"
+#include "xrecord_fixture.h"
+#endif
+
+#define ALLOC_DEFAULT_ROUNDS 1000
+
+static uint64_t dispatched = 0;
+static uint64_t typed = 0;
+
+static bool enabled = false;
+
+static void dispatch_proc(uiohook_event * const event) {
+    if (event->type == EVENT_HOOK_ENABLED) {
+        __atomic_store_n(&enabled, true, __ATOMIC_RELEASE);
+    } else if (event->type == EVENT_KEY_TYPED) {
+        __atomic_add_fetch(&typed, 1, __ATOMIC_RELAXED);
+    }
+
+    __atomic_add_fetch(&dispatched, 1, __ATOMIC_RELAXED);
+}
+
+#ifdef USE_VIRTUAL
+static int hook_status = UIOHOOK_FAILURE;
+
+static void * hook_thread_proc(void *arg) {
+    hook_status = hook_run();
+
+    return arg;
+}
+
+// Typing, clicking, dragging and scrolling, leaving every key and button released.
+static const virtual_event round_events[] = {
+    { EV_KEY, KEY_LEFTSHIFT, 1 }, { EV_SYN, SYN_REPORT, 0 },
+    { EV_KEY, KEY_A, 1 }, { EV_SYN, SYN_REPORT, 0 },
+    { EV_KEY, KEY_A, 0 }, { EV_SYN, SYN_REPORT, 0 },
+    { EV_KEY, KEY_LEFTSHIFT, 0 }, { EV_SYN, SYN_REPORT, 0 },
+    { EV_ABS, ABS_X, 100 }, { EV_ABS, ABS_Y, 100 }, { EV_SYN, SYN_REPORT, 0 },
+    { EV_KEY, BTN_LEFT, 1 }, { EV_SYN, SYN_REPORT, 0 },
+    { EV_KEY, BTN_LEFT, 0 }, { EV_SYN, SYN_REPORT, 0 },
+    { EV_KEY, BTN_LEFT, 1 }, { EV_SYN, SYN_REPORT, 0 },
+    { EV_REL, REL_X, 5 }, { EV_REL, REL_Y, 5 }, { EV_SYN, SYN_REPORT, 0 },
+    { EV_KEY, BTN_LEFT, 0 }, { EV_SYN, SYN_REPORT, 0 },
+    { EV_REL, REL_WHEEL, 1 }, { EV_SYN, SYN_REPORT, 0 },
+    { EV_REL, REL_HWHEEL, -1 }, { EV_SYN, SYN_REPORT, 0 }
+};
+
+static bool start_source() {
+    pthread_t hook_thread;
+    if (pthread_create(&hook_thread, NULL, hook_thread_proc, NULL) != 0) {
+        return false;
+    }
+    pthread_detach(hook_thread);
+
+    struct timespec delay = { .tv_sec = 0, .tv_nsec = 1000000 };
+    for (int i = 0; i < 1000; i++) {
+        if (__atomic_load_n(&enabled, __ATOMIC_ACQUIRE)) {
+            return true;
+        }
+        nanosleep(&delay, NULL);
+    }
+
+    return false;
+}
+
+static void send_round(unsigned long round) {
+    // Timestamps come from the virtual clock.
+    (void) round;
+
+    hook_virtual_advance_time(1000);
+    hook_virtual_inject(round_events, sizeof(round_events) / sizeof(round_events[0]));
+}
+
+static void stop_source() {
+    hook_stop();
+}
+#else
+static Display *display = NULL;
+
+static void send_event(unsigned char type, unsigned char detail, int16_t x, int16_t y, Time time) {
+    XRecordDatum datum;
+    set_datum(&datum, type, detail, x, y);
+    send_datum(display, &datum, time);
+}
+
+static bool start_source() {
+    // Open helper_disp the same way hook_run() does.
+    load_library();
+
+    display = XOpenDisplay(NULL);
+    if (display == NULL) {
+        return false;
+    }
+
+    // Translate key codes the same way the running hook does.
+    load_input_state(display);
+    send_category(display, XRecordStartOfData);
+
+    return true;
+}
+
+// Typing, clicking, dragging and scrolling, leaving every key and button released.
+static void send_round(unsigned long round) {
+    KeyCode shift = XKeysymToKeycode(display, XK_Shift_L);
+    KeyCode key = XKeysymToKeycode(display, XK_a);
+    Time time = (Time) round * 1000;
+
+    send_event(KeyPress, shift, 0, 0, time);
+    send_event(KeyPress, key, 0, 0, time);
+    send_event(KeyRelease, key, 0, 0, time);
+    send_event(KeyRelease, shift, 0, 0, time);
+    send_event(MotionNotify, 0, 100, 100, time);
+    send_event(ButtonPress, Button1, 100, 100, time);
+    send_event(ButtonRelease, Button1, 100, 100, time);
+    send_event(ButtonPress, Button1, 100, 100, time);
+    send_event(MotionNotify, 0, 105, 105, time);
+    send_event(ButtonRelease, Button1, 105, 105, time);
+    send_event(ButtonPress, WheelDown, 105, 105, time);
+    send_event(ButtonRelease, WheelDown, 105, 105, time);
+}
+
+static void stop_source() {
+    send_category(display, XRecordEndOfData);
+    unload_input_state();
+    XCloseDisplay(display);
+}
+#endif
+
+int main(int argc, char *argv[]) {
+    unsigned long rounds = ALLOC_DEFAULT_ROUNDS;
+    if (argc > 1) {
+        rounds = strtoul(argv[1], NULL, 10);
+        if (rounds == 0) {
+            fprintf(stderr, "usage: %s [rounds]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    #ifndef __GLIBC__
+    fprintf(stdout, "Allocation interposing requires glibc, skipping.\n");
+    return EXIT_SUCCESS;
+    #endif
+
+    hook_set_dispatch_proc(&dispatch_proc);
+    if (!start_source()) {
+        fprintf(stderr, "Failed to start the hook!\n");
+        return EXIT_FAILURE;
+    }
+
+    // Lazily built state, such as the screen index and the property snapshot, is set up by the first round.
+    send_round(0);
+
+    __atomic_store_n(&dispatched, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&typed, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&counting, true, __ATOMIC_RELAXED);
+    for (unsigned long i = 1; i <= rounds; i++) {
+        send_round(i);
+    }
+    __atomic_store_n(&counting, false, __ATOMIC_RELAXED);
+
+    uint64_t events = __atomic_load_n(&dispatched, __ATOMIC_RELAXED);
+    uint64_t count = __atomic_load_n(&allocations, __ATOMIC_RELAXED);
+    uint64_t characters = __atomic_load_n(&typed, __ATOMIC_RELAXED);
+
+    stop_source();
+
+    fprintf(stdout, "rounds=%lu events=%llu typed=%llu allocations=%llu\n",
+            rounds, (unsigned long long) events, (unsigned long long) characters, (unsigned long long) count);
+
+    if (events == 0) {
+        fprintf(stderr, "No events were dispatched!\n");
+        return EXIT_FAILURE;
+    } else if (characters != rounds) {
+        // Each round types one character, none means the key translation path was skipped.
+        fprintf(stderr, "Typed %llu characters in %lu rounds!\n", (unsigned long long) characters, rounds);
+        return EXIT_FAILURE;
+    } else if (count > 0) {
+        fprintf(stderr, "The hook allocated memory while dispatching events!\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
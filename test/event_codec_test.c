@@ -0,0 +1,106 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <uiohook.h>
+
+#include "minunit.h"
+
+static uiohook_event events[] = {
+    { .type = EVENT_HOOK_ENABLED, .time = 1000 },
+    { .type = EVENT_MOUSE_MOVED, .time = 1004, .device = 2, .device_class = DEVICE_CLASS_MOUSE, .data.mouse = { .button = MOUSE_NOBUTTON, .clicks = 0, .x = 640, .y = 480 } },
+    { .type = EVENT_MOUSE_MOVED, .time = 1012, .device = 2, .device_class = DEVICE_CLASS_MOUSE, .data.mouse = { .button = MOUSE_NOBUTTON, .clicks = 0, .x = 638, .y = 483 } },
+    { .type = EVENT_MOUSE_PRESSED, .time = 1020, .device = 2, .device_class = DEVICE_CLASS_MOUSE, .data.mouse = { .button = MOUSE_BUTTON1, .clicks = 1, .x = 638, .y = 483 } },
+    { .type = EVENT_MOUSE_DRAGGED, .time = 1024, .mask = MASK_BUTTON1, .device = 2, .device_class = DEVICE_CLASS_MOUSE, .data.mouse = { .button = MOUSE_NOBUTTON, .clicks = 1, .x = -12, .y = 500 } },
+    { .type = EVENT_KEY_PRESSED, .time = 1100, .mask = MASK_SHIFT_L, .device = 3, .device_class = DEVICE_CLASS_KEYBOARD, .data.keyboard = { .keycode = VC_A, .rawcode = 0x41, .keychar = CHAR_UNDEFINED } },
+    { .type = EVENT_KEY_TYPED, .time = 1100, .mask = MASK_SHIFT_L, .device = 3, .device_class = DEVICE_CLASS_KEYBOARD, .data.keyboard = { .keycode = VC_UNDEFINED, .rawcode = 0x41, .keychar = 'A' } },
+    { .type = EVENT_KEY_RELEASED, .time = 1090, .reserved = 0x01, .device = 3, .device_class = DEVICE_CLASS_KEYBOARD, .data.keyboard = { .keycode = VC_A, .rawcode = 0x41, .keychar = CHAR_UNDEFINED } },
+    { .type = EVENT_MOUSE_WHEEL, .time = 1200, .device = 2, .device_class = DEVICE_CLASS_MOUSE, .data.wheel = { .clicks = 1, .x = 10, .y = 20, .type = WHEEL_UNIT_SCROLL, .amount = 3, .rotation = -1, .direction = WHEEL_VERTICAL_DIRECTION } },
+    { .type = EVENT_MOUSE_MOVED, .time = 1210, .device = 2, .device_class = DEVICE_CLASS_MOUSE, .data.mouse = { .button = MOUSE_NOBUTTON, .clicks = 0, .x = 2000, .y = 20, .screen = 1, .screen_x = 80, .screen_y = 20 } }
+};
+
+/* Make sure every event survives an encode and decode round trip */
+static char * test_codec_round_trip() {
+    size_t count = sizeof(events) / sizeof(events[0]);
+    uint8_t buffer[sizeof(events) / sizeof(events[0]) * EVENT_CODEC_MAX_SIZE];
+
+    event_codec codec;
+    hook_codec_reset(&codec);
+
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        length += hook_codec_encode(&codec, &events[i], &buffer[length]);
+    }
+
+    printf("Encoded %zu events into %zu bytes\n", count, length);
+    mu_assert("error, encoded stream is not smaller than the raw events", length < sizeof(events));
+
+    hook_codec_reset(&codec);
+
+    size_t offset = 0;
+    for (size_t i = 0; i < count; i++) {
+        uiohook_event event;
+        memset(&event, 0, sizeof(event));
+
+        size_t size = hook_codec_decode(&codec, &buffer[offset], length - offset, &event);
+        mu_assert("error, could not decode event", size > 0);
+        mu_assert("error, decoded event does not match", memcmp(&event, &events[i], sizeof(event)) == 0);
+
+        offset += size;
+    }
+
+    mu_assert("error, decoder did not consume the whole stream", offset == length);
+
+    return NULL;
+}
+
+/* Make sure truncated input is rejected without advancing the codec state */
+static char * test_codec_truncated() {
+    uint8_t buffer[2 * EVENT_CODEC_MAX_SIZE];
+
+    event_codec codec;
+    hook_codec_reset(&codec);
+
+    size_t first = hook_codec_encode(&codec, &events[1], buffer);
+    size_t second = hook_codec_encode(&codec, &events[2], &buffer[first]);
+
+    hook_codec_reset(&codec);
+
+    uiohook_event event;
+    mu_assert("error, could not decode event", hook_codec_decode(&codec, buffer, first, &event) == first);
+
+    // A streaming reader retries the same codec once more bytes arrive.
+    for (size_t i = 0; i < second; i++) {
+        mu_assert("error, truncated event was decoded", hook_codec_decode(&codec, &buffer[first], i, &event) == 0);
+    }
+
+    memset(&event, 0, sizeof(event));
+    mu_assert("error, could not decode event after truncation", hook_codec_decode(&codec, &buffer[first], second, &event) == second);
+    mu_assert("error, truncated event changed the codec state", memcmp(&event, &events[2], sizeof(event)) == 0);
+
+    return NULL;
+}
+
+char * event_codec_tests() {
+    mu_run_test(test_codec_round_trip);
+    mu_run_test(test_codec_truncated);
+
+    return NULL;
+}
@@ -0,0 +1,182 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <uiohook.h>
+
+#include "minunit.h"
+
+#ifdef USE_UINPUT
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "post_uinput.h"
+#include "system_properties.h"
+
+/* The uinput tests inject real input into the running session, so they only
+ * run when UIOHOOK_TEST_POST is set in the environment.
+ */
+static bool can_post_uinput() {
+    const char *enabled = getenv("UIOHOOK_TEST_POST");
+    if (enabled == NULL || *enabled == '\0' || strcmp(enabled, "0") == 0) {
+        fprintf(stdout, "UIOHOOK_TEST_POST is not set, skipping.\n");
+        return false;
+    }
+
+    int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+    if (fd < 0) {
+        fprintf(stdout, "Failed to open /dev/uinput, skipping.\n");
+        return false;
+    }
+    close(fd);
+
+    // The virtual devices are normally created by the first hook_post_event().
+    load_library();
+    load_uinput_devices();
+
+    return true;
+}
+
+// Find the event device created for a virtual device, udev may need a moment to create the node.
+static int open_virtual_device(const char *name) {
+    for (int attempt = 0; attempt < 50; attempt++) {
+        DIR *dir = opendir("/dev/input");
+        if (dir != NULL) {
+            struct dirent *entry;
+            while ((entry = readdir(dir)) != NULL) {
+                if (strncmp(entry->d_name, "event", 5) != 0) {
+                    continue;
+                }
+
+                char path[288];
+                snprintf(path, sizeof(path), "/dev/input/%s", entry->d_name);
+
+                int fd = open(path, O_RDONLY | O_NONBLOCK);
+                if (fd >= 0) {
+                    char device_name[256] = { 0 };
+                    if (ioctl(fd, EVIOCGNAME(sizeof(device_name) - 1), device_name) >= 0 && strcmp(device_name, name) == 0) {
+                        closedir(dir);
+                        return fd;
+                    }
+
+                    close(fd);
+                }
+            }
+
+            closedir(dir);
+        }
+
+        usleep(20 * 1000);
+    }
+
+    return -1;
+}
+
+static bool read_event(int fd, uint16_t type, uint16_t code, int32_t value) {
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+    struct input_event event;
+    if (poll(&pfd, 1, 1000) <= 0 || read(fd, &event, sizeof(event)) != sizeof(event)) {
+        return false;
+    }
+
+    printf("Read input event\ttype %u\tcode %u\tvalue %i\n", event.type, event.code, event.value);
+
+    return event.type == type && event.code == code && event.value == value;
+}
+
+static char * test_uinput_key_event() {
+    if (!can_post_uinput()) {
+        return NULL;
+    }
+
+    int fd = open_virtual_device(UINPUT_KEYBOARD_NAME);
+    mu_assert("error, virtual keyboard was not created", fd >= 0);
+
+    uiohook_event event = {
+        .type = EVENT_KEY_PRESSED,
+        .data.keyboard.keycode = VC_A
+    };
+    hook_post_event(&event);
+
+    event.type = EVENT_KEY_RELEASED;
+    hook_post_event(&event);
+
+    bool success = read_event(fd, EV_KEY, KEY_A, 1)
+            && read_event(fd, EV_SYN, SYN_REPORT, 0)
+            && read_event(fd, EV_KEY, KEY_A, 0)
+            && read_event(fd, EV_SYN, SYN_REPORT, 0);
+
+    close(fd);
+
+    mu_assert("error, virtual keyboard did not report the posted key events", success);
+
+    return NULL;
+}
+
+static char * test_uinput_button_event() {
+    if (!can_post_uinput()) {
+        return NULL;
+    }
+
+    int fd = open_virtual_device(UINPUT_MOUSE_NAME);
+    mu_assert("error, virtual mouse was not created", fd >= 0);
+
+    uiohook_event event = {
+        .type = EVENT_MOUSE_PRESSED,
+        .data.mouse.button = MOUSE_BUTTON1,
+        .data.mouse.x = 10,
+        .data.mouse.y = 20
+    };
+    hook_post_event(&event);
+
+    event.type = EVENT_MOUSE_RELEASED;
+    hook_post_event(&event);
+
+    // The position is only reported once because the kernel drops unchanged absolute values.
+    bool success = read_event(fd, EV_ABS, ABS_X, 10)
+            && read_event(fd, EV_ABS, ABS_Y, 20)
+            && read_event(fd, EV_KEY, BTN_LEFT, 1)
+            && read_event(fd, EV_SYN, SYN_REPORT, 0)
+            && read_event(fd, EV_KEY, BTN_LEFT, 0)
+            && read_event(fd, EV_SYN, SYN_REPORT, 0);
+
+    close(fd);
+
+    mu_assert("error, virtual mouse did not report the posted button events", success);
+
+    return NULL;
+}
+#endif
+
+char * post_event_tests() {
+    #ifdef USE_UINPUT
+    mu_run_test(test_uinput_key_event);
+    mu_run_test(test_uinput_button_event);
+    #endif
+
+    return NULL;
+}
@@ -76,6 +76,19 @@ static char * test_multi_click_time() {
     return NULL;
 }
 
+static char * test_system_properties() {
+    system_properties properties;
+
+    mu_assert("error, system properties accepted a NULL pointer", hook_get_system_properties(NULL) != UIOHOOK_SUCCESS);
+    mu_assert("error, could not get the system properties", hook_get_system_properties(&properties) == UIOHOOK_SUCCESS);
+
+    mu_assert("error, auto repeat rate does not match", properties.auto_repeat_rate == hook_get_auto_repeat_rate());
+    mu_assert("error, auto repeat delay does not match", properties.auto_repeat_delay == hook_get_auto_repeat_delay());
+    mu_assert("error, multi click time does not match", properties.multi_click_time == hook_get_multi_click_time());
+
+    return NULL;
+}
+
 char * system_properties_tests() {
     mu_run_test(test_auto_repeat_rate);
     mu_run_test(test_auto_repeat_delay);
@@ -86,5 +99,7 @@ char * system_properties_tests() {
 
     mu_run_test(test_multi_click_time);
 
+    mu_run_test(test_system_properties);
+
     return NULL;
 }
@@ -0,0 +1,83 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks the handler detection of uiohook.hpp at compile time and, with the
+ * virtual backend, that events reach only the handler methods that exist.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <uiohook.hpp>
+
+#ifdef USE_VIRTUAL
+#include <linux/input-event-codes.h>
+#endif
+
+struct KeyHandler {
+    int pressed = 0;
+    int released = 0;
+    int moved = 0;
+
+    void on_key_pressed(uiohook_event &) { pressed++; }
+    void on_key_released(const uiohook_event &) { released++; }
+    void on_mouse_moved(uiohook_event &) { moved++; }
+};
+
+struct NotAHandler {
+    void on_key_pressed() {}
+    void key_released(uiohook_event &) {}
+};
+
+static_assert(uiohook::Hook<KeyHandler>::handled_events ==
+        (uiohook::event_bit(EVENT_KEY_PRESSED) | uiohook::event_bit(EVENT_KEY_RELEASED) | uiohook::event_bit(EVENT_MOUSE_MOVED)),
+        "handler methods were not detected");
+static_assert(!uiohook::detail::handler_method<NotAHandler, EVENT_KEY_PRESSED>::exists,
+        "method with the wrong signature was detected");
+static_assert(!uiohook::detail::handler_method<NotAHandler, EVENT_KEY_RELEASED>::exists,
+        "method with the wrong name was detected");
+
+#define check(message, test) do { if (!(test)) { std::fprintf(stderr, "error, %s\n", message); return EXIT_FAILURE; } } while (0)
+
+int main() {
+    #ifdef USE_VIRTUAL
+    KeyHandler handler;
+    {
+        uiohook::Hook<KeyHandler> hook(handler);
+        check("hook did not start", hook.start() == UIOHOOK_SUCCESS && hook.running());
+
+        virtual_event input[] = {
+            { EV_KEY, KEY_A, 1 }, { EV_SYN, SYN_REPORT, 0 },
+            { EV_KEY, KEY_A, 0 }, { EV_SYN, SYN_REPORT, 0 },
+            { EV_REL, REL_X, 5 }, { EV_SYN, SYN_REPORT, 0 },
+            { EV_KEY, BTN_LEFT, 1 }, { EV_SYN, SYN_REPORT, 0 },
+            { EV_KEY, BTN_LEFT, 0 }, { EV_SYN, SYN_REPORT, 0 }
+        };
+        hook_virtual_inject(input, sizeof(input) / sizeof(input[0]));
+
+        check("hook did not stop", hook.stop() == UIOHOOK_SUCCESS && !hook.running());
+    }
+
+    check("key press was not dispatched", handler.pressed == 1);
+    check("key release was not dispatched", handler.released == 1);
+    check("mouse motion was not dispatched", handler.moved == 1);
+    #endif
+
+    std::printf("ALL TESTS PASSED\n");
+
+    return EXIT_SUCCESS;
+}
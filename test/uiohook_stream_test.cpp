@@ -0,0 +1,135 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks that EVENT_HOOK_DISABLED is kept when the ring is full and, with the
+ * virtual backend, that a coroutine driven by a poll() loop on
+ * EventStream::fd() receives every event up to EVENT_HOOK_DISABLED.
+ */
+
+#include <coroutine>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <poll.h>
+#include <uiohook_stream.hpp>
+
+#ifdef USE_VIRTUAL
+#include <linux/input-event-codes.h>
+#endif
+
+// Coroutine that starts eagerly and is never awaited.
+struct task {
+    struct promise_type {
+        task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+struct counts {
+    int enabled = 0;
+    int pressed = 0;
+    int released = 0;
+    int moved = 0;
+    int batches = 0;
+    bool done = false;
+};
+
+template <std::size_t Capacity>
+static task consume(uiohook::EventStream<Capacity> &stream, counts &result) {
+    while (!result.done) {
+        uiohook::EventBatch batch = co_await stream.next();
+        result.batches++;
+
+        for (const uiohook_event &event : batch) {
+            switch (event.type) {
+                case EVENT_HOOK_ENABLED:  result.enabled++;  break;
+                case EVENT_KEY_PRESSED:   result.pressed++;  break;
+                case EVENT_KEY_RELEASED:  result.released++; break;
+                case EVENT_MOUSE_MOVED:   result.moved++;    break;
+                case EVENT_HOOK_DISABLED: result.done = true; break;
+                default: break;
+            }
+        }
+    }
+}
+
+#define check(message, test) do { if (!(test)) { std::fprintf(stderr, "error, %s\n", message); return EXIT_FAILURE; } } while (0)
+
+int main() {
+    {
+        // Nobody drains the ring, the terminal event still takes the reserved slot.
+        uiohook::EventStream<4> full;
+        counts result;
+        consume(full, result);
+
+        uiohook_event event = {};
+        event.type = EVENT_MOUSE_MOVED;
+        for (int i = 0; i < 5; i++) {
+            full.push(event);
+        }
+        event.type = EVENT_HOOK_DISABLED;
+        full.push(event);
+
+        full.poll();
+        check("disabled event was dropped from a full ring", result.done && result.moved == 3);
+        check("overflow was not counted", full.dropped() == 2);
+    }
+
+    #ifdef USE_VIRTUAL
+    uiohook::EventStream<> stream;
+    check("stream has no file descriptor", stream.fd() >= 0);
+
+    // Suspends until the hook thread pushes the first event.
+    counts result;
+    consume(stream, result);
+    check("consumer did not suspend", result.batches == 0);
+
+    {
+        uiohook::Hook<uiohook::EventStream<>> hook(stream);
+        check("hook did not start", hook.start() == UIOHOOK_SUCCESS);
+
+        virtual_event input[] = {
+            { EV_KEY, KEY_A, 1 }, { EV_SYN, SYN_REPORT, 0 },
+            { EV_KEY, KEY_A, 0 }, { EV_SYN, SYN_REPORT, 0 },
+            { EV_REL, REL_X, 5 }, { EV_SYN, SYN_REPORT, 0 }
+        };
+        hook_virtual_inject(input, sizeof(input) / sizeof(input[0]));
+
+        check("hook did not stop", hook.stop() == UIOHOOK_SUCCESS);
+    }
+
+    struct pollfd fds = { stream.fd(), POLLIN, 0 };
+    while (!result.done) {
+        check("stream was not signaled", ::poll(&fds, 1, 1000) == 1);
+        stream.poll();
+    }
+
+    check("enabled event was not received", result.enabled == 1);
+    check("key press was not received", result.pressed == 1);
+    check("key release was not received", result.released == 1);
+    check("mouse motion was not received", result.moved == 1);
+    check("events were dropped", stream.dropped() == 0);
+    #endif
+
+    std::printf("ALL TESTS PASSED\n");
+
+    return EXIT_SUCCESS;
+}
@@ -18,24 +18,27 @@
 
 #include <stdio.h>
 
-#if !defined(__APPLE__) && !defined(__MACH__) && !defined(_WIN32)
+#if !defined(__APPLE__) && !defined(__MACH__) && !defined(_WIN32) && !defined(USE_VIRTUAL)
 #include <X11/Xlib.h>
 #endif
 
 #include "input_helper.h"
 #include "minunit.h"
 
+extern char * event_codec_tests();
 extern char * system_properties_tests();
 extern char * input_helper_tests();
+extern char * post_event_tests();
+extern char * virtual_hook_tests();
 
-#if !defined(__APPLE__) && !defined(__MACH__) && !defined(_WIN32)
+#if !defined(__APPLE__) && !defined(__MACH__) && !defined(_WIN32) && !defined(USE_VIRTUAL)
 static Display *disp;
 #endif
 
 int tests_run = 0;
 
 static char * init_tests() {
-    #if !defined(__APPLE__) && !defined(__MACH__) && !defined(_WIN32)
+    #if !defined(__APPLE__) && !defined(__MACH__) && !defined(_WIN32) && !defined(USE_VIRTUAL)
     // TODO Create our own AC_DEFINE for this value.  Currently defaults to X11 platforms.
     Display *disp = XOpenDisplay(XDisplayName(NULL));
     mu_assert("error, could not open X display", disp != NULL);
@@ -49,7 +52,7 @@ static char * init_tests() {
 }
 
 static char * cleanup_tests() {
-    #if !defined(__APPLE__) && !defined(__MACH__) && !defined(_WIN32)
+    #if !defined(__APPLE__) && !defined(__MACH__) && !defined(_WIN32) && !defined(USE_VIRTUAL)
     if (disp != NULL) {
         XCloseDisplay(disp);
         disp = NULL;
@@ -64,8 +67,11 @@ static char * cleanup_tests() {
 static char * all_tests() {
     mu_run_test(init_tests);
 
+    mu_run_test(event_codec_tests);
     mu_run_test(system_properties_tests);
     mu_run_test(input_helper_tests);
+    mu_run_test(post_event_tests);
+    mu_run_test(virtual_hook_tests);
 
     mu_run_test(cleanup_tests);
 
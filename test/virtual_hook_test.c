@@ -0,0 +1,394 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <uiohook.h>
+
+#include "minunit.h"
+
+#ifdef USE_VIRTUAL
+#include <linux/input-event-codes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_EVENTS 64
+
+static pthread_mutex_t events_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t events_cond = PTHREAD_COND_INITIALIZER;
+static uiohook_event events[MAX_EVENTS];
+static size_t event_count = 0;
+static unsigned int dispatch_delay = 0;
+
+static void dispatch_proc(uiohook_event * const event) {
+    unsigned int delay = __atomic_load_n(&dispatch_delay, __ATOMIC_RELAXED);
+    if (delay > 0) {
+        usleep(delay);
+    }
+
+    pthread_mutex_lock(&events_mutex);
+    if (event_count < MAX_EVENTS) {
+        events[event_count++] = *event;
+    }
+    pthread_cond_broadcast(&events_cond);
+    pthread_mutex_unlock(&events_mutex);
+}
+
+static void *hook_thread_proc(void *arg) {
+    *(int *) arg = hook_run();
+
+    return NULL;
+}
+
+static pthread_t hook_thread;
+static int hook_status;
+
+// Start the virtual hook on its own thread and wait for EVENT_HOOK_ENABLED.
+static bool start_hook() {
+    event_count = 0;
+    hook_set_dispatch_proc(&dispatch_proc);
+    hook_virtual_set_time(1000);
+
+    if (pthread_create(&hook_thread, NULL, hook_thread_proc, &hook_status) != 0) {
+        return false;
+    }
+
+    pthread_mutex_lock(&events_mutex);
+    while (event_count == 0) {
+        pthread_cond_wait(&events_cond, &events_mutex);
+    }
+    bool enabled = events[0].type == EVENT_HOOK_ENABLED;
+    event_count = 0;
+    pthread_mutex_unlock(&events_mutex);
+
+    return enabled;
+}
+
+static bool stop_hook() {
+    bool stopped = hook_stop() == UIOHOOK_SUCCESS;
+    pthread_join(hook_thread, NULL);
+    hook_set_dispatch_proc(NULL);
+
+    return stopped && hook_status == UIOHOOK_SUCCESS
+            && event_count > 0 && events[event_count - 1].type == EVENT_HOOK_DISABLED;
+}
+
+static char * test_virtual_key_typed() {
+    mu_assert("error, virtual hook did not start", start_hook());
+
+    virtual_event input[] = {
+        { EV_KEY, KEY_LEFTSHIFT, 1 }, { EV_SYN, SYN_REPORT, 0 },
+        { EV_KEY, KEY_A, 1 }, { EV_SYN, SYN_REPORT, 0 },
+        { EV_KEY, KEY_A, 0 }, { EV_SYN, SYN_REPORT, 0 },
+        { EV_KEY, KEY_LEFTSHIFT, 0 }, { EV_SYN, SYN_REPORT, 0 }
+    };
+    mu_assert("error, could not inject virtual events", hook_virtual_inject(input, sizeof(input) / sizeof(input[0])) == UIOHOOK_SUCCESS);
+
+    // Injection returns after dispatch, so the events are already available.
+    mu_assert("error, unexpected number of key events", event_count == 5);
+    mu_assert("error, shift was not pressed", events[0].type == EVENT_KEY_PRESSED && events[0].data.keyboard.keycode == VC_SHIFT_L);
+    mu_assert("error, key was not pressed", events[1].type == EVENT_KEY_PRESSED && events[1].data.keyboard.keycode == VC_A
+            && (events[1].mask & MASK_SHIFT_L) && events[1].time == 1000);
+    mu_assert("error, key was not typed", events[2].type == EVENT_KEY_TYPED && events[2].data.keyboard.keychar == 'A');
+    mu_assert("error, key was not released", events[3].type == EVENT_KEY_RELEASED && events[3].data.keyboard.keycode == VC_A);
+    mu_assert("error, shift was not released", events[4].type == EVENT_KEY_RELEASED && events[4].mask == 0x0000);
+
+    mu_assert("error, virtual hook did not stop", stop_hook());
+
+    return NULL;
+}
+
+static char * test_virtual_mouse_clicks() {
+    mu_assert("error, virtual hook did not start", start_hook());
+
+    virtual_event click[] = {
+        { EV_ABS, ABS_X, 10 }, { EV_ABS, ABS_Y, 20 }, { EV_SYN, SYN_REPORT, 0 },
+        { EV_KEY, BTN_LEFT, 1 }, { EV_SYN, SYN_REPORT, 0 },
+        { EV_KEY, BTN_LEFT, 0 }, { EV_SYN, SYN_REPORT, 0 }
+    };
+    size_t click_count = sizeof(click) / sizeof(click[0]);
+
+    // Two clicks inside the multi-click time, then a third after it expires.
+    hook_virtual_inject(click, click_count);
+    hook_virtual_advance_time(100);
+    hook_virtual_inject(click, click_count);
+    hook_virtual_advance_time(hook_get_multi_click_time() + 1);
+    hook_virtual_inject(&click[3], click_count - 3);
+
+    mu_assert("error, unexpected number of mouse events", event_count == 10);
+    mu_assert("error, pointer was not moved", events[0].type == EVENT_MOUSE_MOVED && events[0].data.mouse.x == 10 && events[0].data.mouse.y == 20);
+    mu_assert("error, first click was not counted", events[3].type == EVENT_MOUSE_CLICKED && events[3].data.mouse.clicks == 1);
+    mu_assert("error, double click was not counted", events[6].type == EVENT_MOUSE_CLICKED && events[6].data.mouse.clicks == 2
+            && events[6].time == 1100);
+    mu_assert("error, click count was not reset", events[9].type == EVENT_MOUSE_CLICKED && events[9].data.mouse.clicks == 1);
+
+    mu_assert("error, virtual hook did not stop", stop_hook());
+
+    return NULL;
+}
+
+static char * test_virtual_mouse_drag() {
+    mu_assert("error, virtual hook did not start", start_hook());
+
+    virtual_event drag[] = {
+        { EV_KEY, BTN_LEFT, 1 }, { EV_SYN, SYN_REPORT, 0 },
+        { EV_REL, REL_X, 5 }, { EV_REL, REL_Y, -5 }, { EV_SYN, SYN_REPORT, 0 },
+        { EV_KEY, BTN_LEFT, 0 }, { EV_SYN, SYN_REPORT, 0 },
+        { EV_REL, REL_WHEEL, 1 }, { EV_SYN, SYN_REPORT, 0 }
+    };
+    hook_virtual_inject(drag, sizeof(drag) / sizeof(drag[0]));
+
+    // A drag must not produce a clicked event.
+    mu_assert("error, unexpected number of drag events", event_count == 4);
+    mu_assert("error, button was not pressed", events[0].type == EVENT_MOUSE_PRESSED && (events[0].mask & MASK_BUTTON1));
+    mu_assert("error, pointer was not dragged", events[1].type == EVENT_MOUSE_DRAGGED && events[1].data.mouse.x == 5 && events[1].data.mouse.y == -5);
+    mu_assert("error, button was not released", events[2].type == EVENT_MOUSE_RELEASED);
+    mu_assert("error, wheel was not rotated", events[3].type == EVENT_MOUSE_WHEEL && events[3].data.wheel.rotation == -1
+            && events[3].data.wheel.direction == WHEEL_VERTICAL_DIRECTION);
+
+    mu_assert("error, virtual hook did not stop", stop_hook());
+
+    return NULL;
+}
+
+static char * test_virtual_input_snapshot() {
+    mu_assert("error, virtual hook did not start", start_hook());
+
+    virtual_event input[] = {
+        { EV_ABS, ABS_X, 30 }, { EV_ABS, ABS_Y, 40 }, { EV_SYN, SYN_REPORT, 0 },
+        { EV_KEY, KEY_LEFTSHIFT, 1 }, { EV_SYN, SYN_REPORT, 0 },
+        { EV_KEY, BTN_LEFT, 1 }, { EV_SYN, SYN_REPORT, 0 }
+    };
+    hook_virtual_inject(input, sizeof(input) / sizeof(input[0]));
+
+    input_snapshot snapshot;
+    mu_assert("error, could not get the input snapshot", hook_get_input_snapshot(&snapshot) == UIOHOOK_SUCCESS);
+    mu_assert("error, shift is not held", snapshot.keys[KEY_LEFTSHIFT / 8] & (1 << (KEY_LEFTSHIFT % 8)));
+    mu_assert("error, unexpected modifier mask", (snapshot.mask & MASK_SHIFT_L) && (snapshot.mask & MASK_BUTTON1));
+    mu_assert("error, unexpected pointer position", snapshot.x == 30 && snapshot.y == 40);
+
+    virtual_event release[] = {
+        { EV_KEY, BTN_LEFT, 0 }, { EV_SYN, SYN_REPORT, 0 },
+        { EV_KEY, KEY_LEFTSHIFT, 0 }, { EV_SYN, SYN_REPORT, 0 }
+    };
+    hook_virtual_inject(release, sizeof(release) / sizeof(release[0]));
+
+    hook_get_input_snapshot(&snapshot);
+    mu_assert("error, shift is still held", !(snapshot.keys[KEY_LEFTSHIFT / 8] & (1 << (KEY_LEFTSHIFT % 8))));
+    mu_assert("error, modifiers are still held", snapshot.mask == 0x0000);
+
+    mu_assert("error, virtual hook did not stop", stop_hook());
+
+    return NULL;
+}
+
+static char * test_virtual_screen_changed() {
+    mu_assert("error, virtual hook did not start", start_hook());
+
+    screen_data layout[] = {
+        { .number = 1, .x = 0, .y = 0, .width = 1920, .height = 1080 },
+        { .number = 2, .x = 1920, .y = 0, .width = 1280, .height = 1024 }
+    };
+    hook_virtual_set_screens(layout, 2);
+
+    virtual_event motion[] = {
+        { EV_ABS, ABS_X, 2000 }, { EV_SYN, SYN_REPORT, 0 }
+    };
+    hook_virtual_inject(motion, sizeof(motion) / sizeof(motion[0]));
+
+    // The layout change is reported ahead of the next input event.
+    mu_assert("error, unexpected number of screen events", event_count == 2);
+    mu_assert("error, screen change was not dispatched", events[0].type == EVENT_SCREEN_CHANGED);
+    mu_assert("error, pointer was not moved", events[1].type == EVENT_MOUSE_MOVED);
+    mu_assert("error, pointer is not on the second screen", events[1].data.mouse.screen == 1
+            && events[1].data.mouse.screen_x == 80 && events[1].data.mouse.screen_y == 0);
+
+    // A buffer smaller than the layout is filled and the full count is reported.
+    screen_data first;
+    unsigned char count = 1;
+    mu_assert("error, could not get screen info", hook_get_screen_info(&first, &count) == UIOHOOK_SUCCESS);
+    mu_assert("error, unexpected screen count", count == 2);
+    mu_assert("error, unexpected first screen", first.number == 1 && first.width == 1920);
+
+    // Restore the default layout for the other tests.
+    hook_virtual_set_screens(layout, 1);
+
+    mu_assert("error, virtual hook did not stop", stop_hook());
+
+    return NULL;
+}
+
+static char * test_virtual_devices() {
+    device_info list[] = {
+        { .id = 2, .device_class = DEVICE_CLASS_KEYBOARD, .name = "Virtual keyboard" },
+        { .id = 3, .device_class = DEVICE_CLASS_TOUCHPAD, .name = "Virtual touchpad" }
+    };
+    hook_virtual_set_devices(list, 2);
+
+    mu_assert("error, virtual hook did not start", start_hook());
+
+    device_info devices[4];
+    unsigned char count = 4;
+    mu_assert("error, could not get devices", hook_get_devices(devices, &count) == UIOHOOK_SUCCESS);
+    mu_assert("error, unexpected device count", count == 2);
+    mu_assert("error, unexpected second device", devices[1].id == 3 && strcmp(devices[1].name, "Virtual touchpad") == 0);
+
+    virtual_event input[] = {
+        { VIRTUAL_EVENT_DEVICE, 2, 0 },
+        { EV_KEY, KEY_B, 1 }, { EV_SYN, SYN_REPORT, 0 },
+        { VIRTUAL_EVENT_DEVICE, 3, 0 },
+        { EV_REL, REL_X, 4 }, { EV_SYN, SYN_REPORT, 0 }
+    };
+    hook_virtual_inject(input, sizeof(input) / sizeof(input[0]));
+
+    mu_assert("error, unexpected number of device events", event_count == 3);
+    mu_assert("error, key was not tagged with the keyboard", events[0].type == EVENT_KEY_PRESSED
+            && events[0].device == 2 && events[0].device_class == DEVICE_CLASS_KEYBOARD);
+    mu_assert("error, typed key was not tagged with the keyboard", events[1].type == EVENT_KEY_TYPED && events[1].device == 2);
+    mu_assert("error, motion was not tagged with the touchpad", events[2].type == EVENT_MOUSE_MOVED
+            && events[2].device == 3 && events[2].device_class == DEVICE_CLASS_TOUCHPAD);
+
+    // Events from a disabled device are dropped, the state they change is still tracked.
+    event_count = 0;
+    hook_set_device_enabled(3, false);
+    hook_virtual_inject(&input[3], 3);
+    mu_assert("error, event from a disabled device was dispatched", event_count == 0);
+
+    input_snapshot snapshot;
+    hook_get_input_snapshot(&snapshot);
+    mu_assert("error, disabled device did not move the pointer", snapshot.x == 8);
+
+    hook_set_device_enabled(3, true);
+    hook_virtual_inject(&input[3], 3);
+    mu_assert("error, event from an enabled device was not dispatched", event_count == 1 && events[0].device == 3);
+
+    mu_assert("error, virtual hook did not stop", stop_hook());
+    mu_assert("error, hook events carry a device", events[event_count - 1].device == DEVICE_UNDEFINED);
+
+    hook_virtual_set_devices(NULL, 0);
+
+    return NULL;
+}
+
+static char * test_virtual_dispatch_watchdog() {
+    dispatch_budget budget = { .budget = 1000, .offload = true, .offload_after = 2, .recover_after = 2, .queue_size = 64 };
+    mu_assert("error, could not set the dispatch budget", hook_set_dispatch_budget(&budget) == UIOHOOK_SUCCESS);
+    mu_assert("error, virtual hook did not start", start_hook());
+    mu_assert("error, budget changed while the hook is running", hook_set_dispatch_budget(NULL) == UIOHOOK_FAILURE);
+
+    virtual_event input[] = {
+        { EV_KEY, KEY_A, 1 }, { EV_SYN, SYN_REPORT, 0 },
+        { EV_KEY, KEY_A, 0 }, { EV_SYN, SYN_REPORT, 0 }
+    };
+
+    // Two slow calls move dispatching to the worker thread.
+    __atomic_store_n(&dispatch_delay, 5000, __ATOMIC_RELAXED);
+    hook_virtual_inject(input, 4);
+    hook_virtual_inject(input, 4);
+
+    dispatch_stats stats;
+    hook_get_dispatch_stats(&stats);
+    mu_assert("error, slow calls were not counted", stats.slow >= 2 && stats.max >= 5000);
+    mu_assert("error, events were not offloaded", stats.queued && stats.offloaded > 0);
+
+    // Once the worker is within budget again the next event is dispatched inline.
+    __atomic_store_n(&dispatch_delay, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < 100 && stats.queued; i++) {
+        usleep(10000);
+        hook_virtual_inject(input, 4);
+        hook_get_dispatch_stats(&stats);
+    }
+    mu_assert("error, dispatching did not recover", !stats.queued);
+
+    mu_assert("error, virtual hook did not stop", stop_hook());
+
+    // Every event arrives in order, the hook stop event last.
+    for (size_t i = 0; i + 1 < event_count; i += 3) {
+        mu_assert("error, events were reordered", events[i].type == EVENT_KEY_PRESSED
+                && events[i + 1].type == EVENT_KEY_TYPED && events[i + 2].type == EVENT_KEY_RELEASED);
+    }
+    mu_assert("error, events were dropped", event_count % 3 == 1 && stats.dropped == 0);
+
+    mu_assert("error, could not disable the watchdog", hook_set_dispatch_budget(NULL) == UIOHOOK_SUCCESS);
+
+    return NULL;
+}
+
+#ifdef USE_TRACE
+static char * test_virtual_trace() {
+    trace_options options = { .buffer_size = 4 };
+    mu_assert("error, could not start tracing", hook_trace_start(&options) == UIOHOOK_SUCCESS);
+    mu_assert("error, virtual hook did not start", start_hook());
+
+    virtual_event input[] = {
+        { EV_KEY, KEY_A, 1 }, { EV_SYN, SYN_REPORT, 0 },
+        { EV_KEY, KEY_A, 0 }, { EV_SYN, SYN_REPORT, 0 }
+    };
+    hook_virtual_inject(input, sizeof(input) / sizeof(input[0]));
+
+    mu_assert("error, virtual hook did not stop", stop_hook());
+    mu_assert("error, could not stop tracing", hook_trace_stop() == UIOHOOK_SUCCESS);
+
+    char path[] = "/tmp/uiohook_trace_XXXXXX";
+    close(mkstemp(path));
+
+    trace_stats stats;
+    mu_assert("error, could not dump the trace", hook_trace_dump(path, &stats) == UIOHOOK_SUCCESS);
+
+    char json[4096] = { 0 };
+    FILE *file = fopen(path, "r");
+    size_t length = fread(json, 1, sizeof(json) - 1, file);
+    fclose(file);
+    unlink(path);
+
+    // 2 translations and 5 dispatches, the ring buffer keeps the last 4 spans of the hook thread.
+    mu_assert("error, unexpected span count", stats.recorded == 7 && stats.dropped == 3 && stats.written == 4);
+    mu_assert("error, trace is not a trace event object", length > 0 && strncmp(json, "{\"displayTimeUnit\"", 18) == 0);
+    mu_assert("error, dispatch span is missing", strstr(json, "\"name\":\"dispatch\",\"cat\":\"uiohook\",\"ph\":\"X\"") != NULL);
+    mu_assert("error, translate span is missing", strstr(json, "\"name\":\"translate\"") != NULL);
+
+    return NULL;
+}
+#else
+static char * test_virtual_trace() {
+    mu_assert("error, tracing started without USE_TRACE", hook_trace_start(NULL) == UIOHOOK_FAILURE);
+    mu_assert("error, tracing stopped without USE_TRACE", hook_trace_stop() == UIOHOOK_FAILURE);
+    mu_assert("error, trace dumped without USE_TRACE", hook_trace_dump("/dev/null", NULL) == UIOHOOK_FAILURE);
+
+    return NULL;
+}
+#endif
+#endif
+
+char * virtual_hook_tests() {
+    #ifdef USE_VIRTUAL
+    mu_run_test(test_virtual_key_typed);
+    mu_run_test(test_virtual_mouse_clicks);
+    mu_run_test(test_virtual_mouse_drag);
+    mu_run_test(test_virtual_input_snapshot);
+    mu_run_test(test_virtual_screen_changed);
+    mu_run_test(test_virtual_devices);
+    mu_run_test(test_virtual_dispatch_watchdog);
+    mu_run_test(test_virtual_trace);
+    #endif
+
+    return NULL;
+}
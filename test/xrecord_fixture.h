@@ -0,0 +1,85 @@
+/* libUIOHook: Cross-platform keyboard and mouse hooking from userland.
+ * Copyright (C) 2006-2023 Alexander Barker.  All Rights Reserved.
+ * https://github.com/kwhat/libuiohook/
+ *
+ * libUIOHook is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libUIOHook is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Drives hook_event_proc() of the X11 backend with synthetic XRecord intercept
+ * data, without running the hook.  Include from a single translation unit of
+ * the executable.
+ */
+
+#ifndef _included_xrecord_fixture
+#define _included_xrecord_fixture
+
+#include <string.h>
+#include <X11/Xlibint.h>
+#include <X11/Xlib.h>
+#include <X11/extensions/record.h>
+
+// Same layout as the XRecordDatum used by src/x11/input_hook.c.
+typedef union {
+    unsigned char       type;
+    xEvent              event;
+    xResourceReq        req;
+    xGenericReply       reply;
+    xError              error;
+    xConnSetupPrefix    setup;
+} XRecordDatum;
+
+extern void hook_event_proc(XPointer closeure, XRecordInterceptData *recorded_data);
+extern void load_input_state(Display *display);
+extern void unload_input_state();
+
+/* The intercept data is owned by the fixture and not by libXtst, so the free
+ * done at the end of hook_event_proc() must be a no-op.
+ */
+void XRecordFreeData(XRecordInterceptData *data) {
+    (void) data;
+}
+
+static void set_datum(XRecordDatum *datum, unsigned char type, unsigned char detail, int16_t x, int16_t y) {
+    memset(datum, 0, sizeof(XRecordDatum));
+    datum->event.u.u.type = type;
+    datum->event.u.u.detail = detail;
+    datum->event.u.keyButtonPointer.rootX = x;
+    datum->event.u.keyButtonPointer.rootY = y;
+}
+
+// The display stands in for the control display opened by hook_run().
+static void send_datum(Display *display, XRecordDatum *datum, Time time) {
+    XRecordInterceptData intercept = {
+        .id_base = 0,
+        .server_time = time,
+        .client_seq = 0,
+        .category = XRecordFromServer,
+        .client_swapped = False,
+        .data = (unsigned char *) datum,
+        .data_len = sizeof(xEvent) / 4
+    };
+
+    hook_event_proc((XPointer) display, &intercept);
+}
+
+static void send_category(Display *display, int category) {
+    XRecordInterceptData intercept = {
+        .server_time = CurrentTime,
+        .category = category
+    };
+
+    hook_event_proc((XPointer) display, &intercept);
+}
+
+#endif